@@ -0,0 +1,102 @@
+#!/bin/bash
+
+# Runs a batch of simulations, several at the same time, and summarizes the results.
+#
+# Every run takes place in its own directory (links to the programs, a copy of config.txt, its log, error_* and
+# recorded order files) with its own access key, so that runs do not share IPC resources. A run passes when the
+# generator terminates successfully and every group is LEAVING in the last state line; the directories of failed
+# runs are kept.
+#
+# Every run is a session of its own: when the generator terminates, times out or crashes, the processes left in
+# the session are killed and the IPC resources of the run are removed.
+
+usage() {
+    echo "USAGE: $0 [-j jobs] [-t timeout] [-R] [-d directory] «number-of-runs» [-- generator options]"
+    echo "    -j jobs       simultaneous runs (number of processors by default)"
+    echo "    -t timeout    seconds a run may take before it is killed (60 by default)"
+    echo "    -R            the order of the downs of each run is recorded, to be replayed with -P"
+    echo "    -d directory  where the directories of the runs are created (runs.XXXXXX by default)"
+    exit 1
+}
+
+jobs=$(nproc)
+limit=60
+record=""
+work=""
+while getopts "j:t:Rd:" opt; do
+    case $opt in
+        j) jobs=$OPTARG;;
+        t) limit=$OPTARG;;
+        R) record="-R order.txt";;
+        d) work=$OPTARG;;
+        *) usage;;
+    esac
+done
+shift $((OPTIND - 1))
+[ $# -ge 1 ] || usage
+n=$1
+shift
+[ "$1" = "--" ] && shift
+opts="$*"
+
+if ! [ $n -gt 0 ] 2>/dev/null || ! [ $jobs -gt 0 ] 2>/dev/null; then
+    echo "Wrong argument value. Aborting."
+    exit 1
+fi
+
+here=$(pwd)
+[ -n "$work" ] || work=$(mktemp -d runs.XXXXXX)
+mkdir -p "$work"
+ngroups=$( head -2 config.txt | tail -1 )
+base=$(( 0x52000000 + ($$ % 4096) * 4096 ))                               # access keys of the runs of the batch
+
+# one run: $1 is the number of the run
+run() {
+    local dir="$work/run$1" key=$(( base + $1 )) pid watchdog rc status
+    mkdir -p "$dir"
+    for prog in probSemSharedMemRestaurant chef waiter group receptionist logdump; do
+        ln -sf "$here/$prog" "$dir/$prog"
+    done
+    cp config.txt "$dir"
+    ( cd "$dir" && exec setsid ./probSemSharedMemRestaurant -k $key $record $opts log > out 2>&1 ) &
+    pid=$!
+    ( sleep $limit; kill -KILL -- -$pid ) > /dev/null 2>&1 &
+    watchdog=$!
+    wait $pid
+    rc=$?
+    kill -KILL -- -$pid 2> /dev/null                                     # processes left in the session
+    pkill -P $watchdog sleep
+    wait $watchdog
+    ipcrm -S $key -M $key -M $(( key ^ 0x01000000 )) 2> /dev/null                 # both semaphore backends
+    if [ $rc -ne 0 ]; then
+        status="FAIL (exit status $rc)"
+    elif ! { ./logdump "$dir/log" 2> /dev/null || cat "$dir/log"; } | tail -1 |
+            awk -v ng=$ngroups '{ for (i = 4; i < 4 + ng; i++) if ($i != 7) exit 1 }'; then
+        status="FAIL (groups did not leave)"
+    else
+        status="PASS"
+        rm -rf "$dir"
+    fi
+    echo "$1 $status" >> "$work/results"
+}
+
+rm -f "$work/results"
+start=$(date +%s)
+for i in $(seq 1 $n); do
+    while [ $(jobs -rp | wc -l) -ge $jobs ]; do
+        wait -n
+    done
+    run $i 2> /dev/null &
+done
+wait
+
+passed=$(grep -c " PASS$" "$work/results")
+failed=$(( n - passed ))
+echo "$n runs ($jobs at a time) in $(( $(date +%s) - start )) s: $passed passed, $failed failed"
+if [ $failed -gt 0 ]; then
+    grep -v " PASS$" "$work/results" | sort -n | while read i status; do
+        echo "    run $i: $status, see $work/run$i"
+    done
+    exit 1
+fi
+rm -rf "$work"
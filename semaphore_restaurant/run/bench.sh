@@ -0,0 +1,155 @@
+#!/bin/bash
+
+# Performance suite of the simulation (see make bench in src).
+#
+# The results are written as comma separated values (suite, test, variant, value and unit) to the results file and
+# shown as a table:
+#   micro      microbenchmarks of both semaphore backends (down and up, multiple operations, round trip between two
+#              processes) and of the state saves in each log mode (see microbench.c), in ns per operation
+#   virtual    groups served per second by the process engine at a scaled population, with virtual time (-v), so
+#              that no run sleeps: the time of a run is the time of its synchronization and logging
+#   zero       groups served per second by every engine (processes, threads, forked processes and the warm pool
+#              of forked processes) at the scaled population, with all start and eat times zeroed
+#   reference  groups served per second by the entities built from the sources and by the reference binaries, at
+#              the population the reference binaries support (MAXGROUPS groups, two tables) with zeroed times, and
+#              the ratio of both: a ratio below one is a performance regression of the rewritten entities
+#
+# Every run takes place in its own directory, with its own access key, as in batch.sh.
+
+usage() {
+    echo "USAGE: $0 [-n runs] [-g groups] [-t tables] [-s staff] [-o results file]"
+    echo "    -n runs       runs of each end-to-end test (5 by default)"
+    echo "    -g groups     scaled number of groups (500 by default)"
+    echo "    -t tables     scaled number of tables (20 by default)"
+    echo "    -s staff      scaled number of waiters and of chefs (4 by default)"
+    echo "    -o file       results file (bench.csv by default)"
+    exit 1
+}
+
+runs=5
+groups=500
+tables=20
+staff=4
+results=bench.csv
+while getopts "n:g:t:s:o:" opt; do
+    case $opt in
+        n) runs=$OPTARG;;
+        g) groups=$OPTARG;;
+        t) tables=$OPTARG;;
+        s) staff=$OPTARG;;
+        o) results=$OPTARG;;
+        *) usage;;
+    esac
+done
+shift $((OPTIND - 1))
+[ $# -eq 0 ] || usage
+for value in $runs $groups $tables $staff; do
+    if ! [ $value -gt 0 ] 2>/dev/null; then
+        echo "Wrong argument value (\"$value\"). Aborting."
+        exit 1
+    fi
+done
+
+here=$(pwd)
+suffix=$(getconf LONG_BIT)
+work=$(mktemp -d bench.XXXXXX)
+key=$(( 0x53000000 + ($$ % 4096) * 4096 ))                                 # access keys of the runs of the suite
+trap 'rm -rf "$work"' EXIT
+
+# configuration file: $1 groups, $2 tables, $3 waiters and chefs, $4 set when the times are zeroed
+config() {
+    awk -v g=$1 -v t=$2 -v s=$3 -v zero=$4 'BEGIN {
+        srand(1)
+        print "#ngroups"; print g; print "#startTime timeToEat"
+        for (i = 0; i < g; i++) print zero ? "0 0" : int(rand() * 100000) " " int(rand() * 200000)
+        print "#ntables"; print t; print "#nwaiters"; print s; print "#nchefs"; print s
+    }'
+}
+
+# directory of a test: $1 name, $2 configuration file, $3 set for the reference binaries
+setup() {
+    local dir="$work/$1" prog
+    mkdir -p "$dir"
+    for prog in probSemSharedMemRestaurant probThreadedRestaurant probForkedRestaurant; do
+        ln -sf "$here/$prog" "$dir/$prog"
+    done
+    for prog in chef waiter group receptionist; do
+        if [ -n "$3" ]; then
+            ln -sf "$here/${prog}_bin_$suffix" "$dir/$prog"
+        else
+            ln -sf "$here/$prog" "$dir/$prog"
+        fi
+    done
+    cp "$2" "$dir/config.txt"
+    echo "$dir"
+}
+
+# groups served per second: $1 suite, $2 test, $3 variant, $4 directory, $5 number of groups, $6 runs of an
+# execution of the generator, $7 generator and its options
+throughput() {
+    local suite=$1 test=$2 variant=$3 dir=$4 ng=$5 per=$6 start end i
+    shift 6
+    start=$(date +%s.%N)
+    for i in $(seq 1 $(( (runs + per - 1) / per ))); do
+        key=$(( key + 1 ))
+        if ! ( cd "$dir" && timeout 300 ./$1 -k $key ${@:2} log > out 2>&1 ); then
+            echo "$suite $test $variant: the generator failed, see $dir/out" >&2
+            ipcrm -S $key -M $key -M $(( key ^ 0x01000000 )) 2> /dev/null
+            trap - EXIT
+            exit 1
+        fi
+    done
+    end=$(date +%s.%N)
+    awk -v s="$suite" -v t="$test" -v v="$variant" -v n=$(( ng * ((runs + per - 1) / per) * per )) \
+        -v start=$start -v end=$end 'BEGIN { printf "%s,%s,%s,%.1f,groups/s\n", s, t, v, n / (end - start) }' |
+        tee -a "$results"
+}
+
+echo "suite,test,variant,value,unit" > "$results"
+
+# microbenchmarks
+./microbench_sysv -b sysv 2> /dev/null | tee -a "$results"
+./microbench_posix -b posix 2> /dev/null | tee -a "$results"
+
+# scaled population, virtual time
+config $groups $tables $staff 0 > "$work/scaled.txt"
+dir=$(setup virtual "$work/scaled.txt")
+throughput virtual "$groups groups" "no log" "$dir" $groups 1 probSemSharedMemRestaurant -v -n
+throughput virtual "$groups groups" "text log" "$dir" $groups 1 probSemSharedMemRestaurant -v
+throughput virtual "$groups groups" "coalesced text log" "$dir" $groups 1 probSemSharedMemRestaurant -v -d
+throughput virtual "$groups groups" "log ring" "$dir" $groups 1 probSemSharedMemRestaurant -v -r
+throughput virtual "$groups groups" "split locks and 4 slot mailboxes" "$dir" $groups 1 \
+    probSemSharedMemRestaurant -v -n -l -m 4
+throughput virtual "$groups groups" "16 groups per process" "$dir" $groups 1 probSemSharedMemRestaurant -v -n -g 16
+throughput virtual "$groups groups" "pipelined kitchen" "$dir" $groups 1 probSemSharedMemRestaurant -v -n -K
+
+# scaled population, zeroed times
+config $groups $tables $staff 1 > "$work/zero.txt"
+dir=$(setup zero "$work/zero.txt")
+throughput zero "$groups groups" "processes" "$dir" $groups 1 probSemSharedMemRestaurant -n
+throughput zero "$groups groups" "threads" "$dir" $groups 1 probThreadedRestaurant -n
+throughput zero "$groups groups" "forked processes" "$dir" $groups 1 probForkedRestaurant -n
+throughput zero "$groups groups" "warm pool" "$dir" $groups $runs probForkedRestaurant -n -w $runs
+
+# scaled population, zeroed times, a single waiter
+config $groups $tables 1 1 > "$work/single.txt"
+dir=$(setup single "$work/single.txt")
+throughput single "$groups groups" "threads" "$dir" $groups 1 probThreadedRestaurant -n
+throughput single "$groups groups" "event-driven staff threads" "$dir" $groups 1 probThreadedRestaurant -n -e
+throughput single "$groups groups" "forked processes" "$dir" $groups 1 probForkedRestaurant -n
+throughput single "$groups groups" "event-driven staff processes" "$dir" $groups 1 probForkedRestaurant -n -e
+
+# population of the reference binaries, zeroed times
+config 16 2 1 1 > "$work/reference.txt"
+dir=$(setup own "$work/reference.txt")
+own=$(throughput reference "16 groups" "sources" "$dir" 16 1 probSemSharedMemRestaurant) || { trap - EXIT; exit 1; }
+echo "$own"
+dir=$(setup ref "$work/reference.txt" ref)
+ref=$(throughput reference "16 groups" "reference binaries" "$dir" 16 1 probSemSharedMemRestaurant) ||
+    { trap - EXIT; exit 1; }
+echo "$ref"
+awk -v a=$(echo "$own" | cut -d, -f4) -v b=$(echo "$ref" | cut -d, -f4) \
+    'BEGIN { printf "reference,16 groups,sources / reference binaries,%.2f,ratio\n", a / b }' | tee -a "$results"
+
+echo
+awk -F, '{ printf "%-10s %-18s %-32s %12s %s\n", $1, $2, $3, $4, $5 }' "$results"
@@ -3,6 +3,11 @@
 rm -f error*
 rm -f core
 
-# change 0x61066137 to your semaphore and shared memory key
-ipcrm -S 0x61116055
-ipcrm -M 0x61116055
+# semaphore set and shared memory of the key generated by ftok(".", 'a') and of the keys given as parameters
+# (the POSIX semaphore backend keeps its semaphores in a shared memory block whose key has bit 24 changed)
+read dev ino < <(stat -c '%d %i' .)
+for key in $(( (0x61 << 24) | ((dev & 0xff) << 16) | (ino & 0xffff) )) "$@"; do
+    ipcrm -S $(( key )) 2> /dev/null
+    ipcrm -M $(( key )) 2> /dev/null
+    ipcrm -M $(( key ^ 0x01000000 )) 2> /dev/null
+done
@@ -1,18 +1,17 @@
 #!/bin/bash
 
+# runs the simulation several times, as many at a time as there are processors (see batch.sh)
+
 case $# in
-    0) n=1000;;
-    1) n=$1;;
-    *) echo "USAGE: $0 «number-of-runs»"; exit;;
+    0) n=1000; j=$(nproc);;
+    1) n=$1; j=$(nproc);;
+    2) n=$1; j=$2;;
+    *) echo "USAGE: $0 «number-of-runs» «simultaneous-runs»"; exit;;
 esac
 
-if ! [ $n -gt 0 ] 2>/dev/null; then
-    echo "Wrong argument value (\"$n\"). Aborting."
+if ! [ $n -gt 0 ] 2>/dev/null || ! [ $j -gt 0 ] 2>/dev/null; then
+    echo "Wrong argument value (\"$n\" \"$j\"). Aborting."
     exit 1
 fi
 
-for i in $(seq 1 $n)
-do
-     echo -e "\n\e[34;1mRun n.º $i\e[0m"
-     ./probSemSharedMemRestaurant
-done
+exec ./batch.sh -j $j $n
@@ -0,0 +1,80 @@
+#!/bin/bash
+
+# Sweeps the load of a large scenario and writes the latencies of the groups against the offered load.
+#
+# For each arrival rate (groups per second), the configuration of the scenario is generated by scengen and the
+# simulation is run with virtual time (-v), so that no run sleeps, and latency histograms (-H). The results are
+# written as comma separated values, one row per rate: the rate, the offered load (rate times the mean eat time,
+# per table: the fraction of the tables the groups would keep busy eating) and the p50 and p99 of the latencies
+# printed by the generator (reception to table, order to food and checkout, in us), followed by the utilization of
+# the tables achieved by the scheduling policy of the waiting groups (-p, see -S of the generator). To plot them:
+#   gnuplot -e "set datafile separator ','; set key autotitle columnhead; set logscale y; \
+#               plot 'sweep.csv' using 2:4 with linespoints, '' using 2:6 with linespoints; pause -1"
+#
+# Every run takes place in its own directory, with its own access key, as in batch.sh.
+
+usage() {
+    echo "USAGE: $0 [-g groups] [-t tables] [-s staff] [-a arrivals] [-e eat times] [-p policy] [-o results file] «rate» ..."
+    echo "    -g groups     number of groups (1000 by default)"
+    echo "    -t tables     number of tables (20 by default)"
+    echo "    -s staff      number of waiters and of chefs (4 by default)"
+    echo "    -a arrivals   arrival pattern: uniform, poisson or \"bursty burst n\" (poisson by default)"
+    echo "    -e eat times  eat time distribution: \"fixed time\", \"uniform min max\" or \"exponential mean\", in us"
+    echo "                  (\"exponential 50000\" by default)"
+    echo "    -p policy     scheduling policy of the waiting groups: fifo, sef or edf (fifo by default)"
+    echo "    -o file       results file (sweep.csv by default)"
+    exit 1
+}
+
+groups=1000
+tables=20
+staff=4
+arrivals=poisson
+eat="exponential 50000"
+policy=fifo
+results=sweep.csv
+while getopts "g:t:s:a:e:p:o:" opt; do
+    case $opt in
+        g) groups=$OPTARG;;
+        t) tables=$OPTARG;;
+        s) staff=$OPTARG;;
+        a) arrivals=$OPTARG;;
+        e) eat=$OPTARG;;
+        p) policy=$OPTARG;;
+        o) results=$OPTARG;;
+        *) usage;;
+    esac
+done
+shift $((OPTIND - 1))
+[ $# -ge 1 ] || usage
+
+here=$(pwd)
+work=$(mktemp -d sweep.XXXXXX)
+key=$(( 0x53000000 + ($$ % 4096) * 4096 + 2048 ))                           # access keys of the runs of the sweep
+trap 'rm -rf "$work"' EXIT
+mean=$(echo "$eat" | awk '{ print ($1 == "uniform") ? ($2 + $3) / 2 : $2 }')                 # mean eat time (us)
+for prog in probSemSharedMemRestaurant chef waiter group receptionist; do
+    ln -sf "$here/$prog" "$work/$prog"
+done
+
+echo "rate,load,table p50,table p99,food p50,food p99,checkout p50,checkout p99,utilization" > "$results"
+for rate in "$@"; do
+    read type burst <<< "$arrivals"
+    if ! ./scengen -g $groups -t $tables -w $staff -c $staff $type $rate $burst eat $eat > "$work/config.txt"; then
+        echo "Wrong scenario (\"$arrivals $rate eat $eat\"). Aborting."
+        exit 1
+    fi
+    key=$(( key + 1 ))
+    if ! ( cd "$work" && timeout 600 ./probSemSharedMemRestaurant -k $key -v -H -S $policy -n log > out 2>&1 ); then
+        echo "rate $rate: the generator failed, see $work/out" >&2
+        ipcrm -S $key -M $key -M $(( key ^ 0x01000000 )) 2> /dev/null
+        trap - EXIT
+        exit 1
+    fi
+    awk -v rate=$rate -v load=$(awk -v r=$rate -v m=$mean -v t=$tables 'BEGIN { printf "%.3f", r * m / 1e6 / t }') '
+        /^reception to table/ { table = $5 "," $6 }
+        /^order to food/      { food = $5 "," $6 }
+        /^checkout/           { checkout = $3 "," $4 }
+        /^table utilization/  { utilization = $3 }
+        END { print rate "," load "," table "," food "," checkout "," utilization }' "$work/out" | tee -a "$results"
+done
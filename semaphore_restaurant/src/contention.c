@@ -0,0 +1,91 @@
+/**
+ *  \file contention.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Naming the semaphores and printing their contention profile.
+ *
+ *  Operations defined:
+ *     \li naming the semaphores of the set, in ranges of semaphores of the same kind
+ *     \li printing the contention profile of the semaphores.
+ *
+ *  The counters may be read while the entities update them, so that the profile of a running simulation may be
+ *  printed.
+ */
+
+#include <stdio.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "sharedDataSync.h"
+#include "semaphore.h"
+#include "latency.h"
+#include "contention.h"
+
+/** \brief names of the callers */
+static const char *callerName[MEMBERKINDS] = {"group", "waiter", "chef", "receptionist"};
+
+/**
+ *  \brief Naming the semaphores of the set, in ranges of semaphores of the same kind.
+ *
+ *  \param sh pointer to the shared data
+ *  \param ranges ranges of semaphores (SEMRANGES ranges, some of them may be empty)
+ *
+ *  \return number of ranges
+ */
+unsigned int semRanges (SHARED_DATA *sh, SEM_RANGE ranges[])
+{
+    SEM_RANGE all[SEMRANGES] = {{"mutex", MUTEX, 1}, {"receptionistReq", RECEPTIONISTREQ, 1},
+                                {"receptionistRequestPossible", RECEPTIONISTREQUESTPOSSIBLE, 1},
+                                {"waiterRequest", WAITERREQUEST, 1}, {"waiterRequestPossible", WAITERREQUESTPOSSIBLE, 1},
+                                {"waitOrder", WAITORDER, 1}, {"orderReceived", ORDERRECEIVED, 1},
+                                {"waitForTable", WAITFORTABLE, sh->fSt.nGroups}, {"foodArrived", FOODARRIVED, sh->nTables},
+                                {"requestReceived", REQUESTRECEIVED, sh->nTables}, {"tableDone", TABLEDONE, sh->nTables},
+                                {"receptionLock", RECEPTIONLOCK, 1}, {"kitchenLock", KITCHENLOCK, 1},
+                                {"tableLock", TABLELOCK, sh->nTables}, {"foodReadyPossible", FOODREADYPOSSIBLE, 1},
+                                {"orderSlots", ORDERSLOTS, 1}, {"logLock", LOGLOCK, 1}, {"running", RUNNING, 1},
+                                {"wakeUp", WAKEUP, sh->clock.members}, {"turn", TURN, sh->replay.members}};
+    unsigned int r;
+
+    for (r = 0; r < SEMRANGES; r++) {
+        ranges[r] = all[r];
+    }
+    return SEMRANGES;
+}
+
+/**
+ *  \brief Printing the contention profile: acquires, contended acquires and time blocked of each semaphore and
+ *  caller (semaphores and callers without acquires are not printed).
+ *
+ *  \param fp stream the profile is printed to
+ *  \param stats pointer to the profile
+ *  \param ranges names of the semaphores
+ *  \param n number of ranges
+ */
+void printContention (FILE *fp, SEM_STATS *stats, SEM_RANGE ranges[], unsigned int n)
+{
+    SEM_COUNTERS cnt;                                                   /* counters of the semaphore and caller */
+    unsigned int r, s, c;
+    char name[64];
+
+    fprintf (fp, "%-32s %-12s %10s %10s %6s %12s\n", "semaphore", "caller", "acquires", "contended", "%",
+             "blocked (ms)");
+    for (r = 0; r < n; r++) {
+        for (s = ranges[r].first; (s < ranges[r].first + ranges[r].count) && (s < stats->nSems); s++) {
+            if (ranges[r].count > 1) {
+                snprintf (name, sizeof (name), "%s %u", ranges[r].name, s - ranges[r].first);
+            }
+            else snprintf (name, sizeof (name), "%s", ranges[r].name);
+            for (c = 0; (c < stats->nCallers) && (c < MEMBERKINDS); c++) {
+                cnt.acquires = __atomic_load_n (&SEMCOUNTERS (stats, s, c).acquires, __ATOMIC_RELAXED);
+                cnt.contended = __atomic_load_n (&SEMCOUNTERS (stats, s, c).contended, __ATOMIC_RELAXED);
+                cnt.blocked = __atomic_load_n (&SEMCOUNTERS (stats, s, c).blocked, __ATOMIC_RELAXED);
+                if (cnt.acquires == 0) {
+                    continue;
+                }
+                fprintf (fp, "%-32s %-12s %10lu %10lu %6.1f %12.3f\n", name, callerName[c], cnt.acquires,
+                         cnt.contended, 100.0 * cnt.contended / cnt.acquires, cnt.blocked / 1e6);
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+/**
+ *  \file contention.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Naming the semaphores and printing their contention profile.
+ *
+ *  Operations defined:
+ *     \li naming the semaphores of the set, in ranges of semaphores of the same kind
+ *     \li printing the contention profile of the semaphores.
+ *
+ *  The profile is filled by the semaphore module when it is compiled with <tt>SEMPROFILE</tt> defined; the callers
+ *  are the kinds of entities (MEMBERGROUP, MEMBERWAITER, MEMBERCHEF and MEMBERRECEPTIONIST).
+ */
+
+#ifndef CONTENTION_H_
+#define CONTENTION_H_
+
+#include <stdio.h>
+
+#include "sharedDataSync.h"
+#include "semaphore.h"
+#include "latency.h"
+
+/** \brief number of ranges of semaphores of the same kind */
+#define  SEMRANGES      20
+
+/**
+ *  \brief Naming the semaphores of the set, in ranges of semaphores of the same kind.
+ *
+ *  \param sh pointer to the shared data
+ *  \param ranges ranges of semaphores (SEMRANGES ranges, some of them may be empty)
+ *
+ *  \return number of ranges
+ */
+extern unsigned int semRanges (SHARED_DATA *sh, SEM_RANGE ranges[]);
+
+/**
+ *  \brief Printing the contention profile: acquires, contended acquires and time blocked of each semaphore and
+ *  caller (semaphores and callers without acquires are not printed).
+ *
+ *  \param fp stream the profile is printed to
+ *  \param stats pointer to the profile
+ *  \param ranges names of the semaphores
+ *  \param n number of ranges
+ */
+extern void printContention (FILE *fp, SEM_STATS *stats, SEM_RANGE ranges[], unsigned int n);
+
+#endif /* CONTENTION_H_ */
@@ -0,0 +1,113 @@
+/**
+ *  \file histogram.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Histograms of durations.
+ *
+ *  Operations defined on a histogram:
+ *     \li recording a value
+ *     \li adding a histogram to another
+ *     \li computing a percentile.
+ */
+
+#include "histogram.h"
+
+/** \brief number of sub-buckets of a power of two */
+#define  SUBBUCKETS      (1UL << HISTSUBBITS)
+
+/* internal functions */
+
+static unsigned int bucketOf (unsigned long value)
+{
+    unsigned int e;                                                            /* most significant bit of value */
+
+    if (value < SUBBUCKETS) {
+        return (unsigned int) value;
+    }
+    e = 63 - __builtin_clzl (value);
+    if (e > HISTMAXEXP) {
+        return HISTBUCKETS - 1;
+    }
+    return ((e - HISTSUBBITS + 1) << HISTSUBBITS) + ((value >> (e - HISTSUBBITS)) & (SUBBUCKETS - 1));
+}
+
+static unsigned long highestOf (unsigned int b)
+{
+    unsigned int e;                                                  /* most significant bit of the bucket values */
+
+    if (b < SUBBUCKETS) {
+        return b;
+    }
+    e = (b >> HISTSUBBITS) + HISTSUBBITS - 1;
+    return ((SUBBUCKETS + (b & (SUBBUCKETS - 1)) + 1) << (e - HISTSUBBITS)) - 1;
+}
+
+/* external functions */
+
+/**
+ *  \brief Recording a value.
+ *
+ *  \param h pointer to the histogram
+ *  \param value value to be recorded
+ */
+void histRecord (HISTOGRAM *h, unsigned long value)
+{
+    unsigned long max = __atomic_load_n (&h->max, __ATOMIC_RELAXED);
+
+    __atomic_add_fetch (&h->bucket[bucketOf (value)], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch (&h->sum, value, __ATOMIC_RELAXED);
+    __atomic_add_fetch (&h->count, 1, __ATOMIC_RELAXED);
+    while ((value > max) &&
+           !__atomic_compare_exchange_n (&h->max, &max, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+/**
+ *  \brief Adding a histogram to another (the histograms must not be updated meanwhile).
+ *
+ *  \param dst pointer to the histogram the values are added to
+ *  \param src pointer to the histogram whose values are added
+ */
+void histMerge (HISTOGRAM *dst, HISTOGRAM *src)
+{
+    unsigned int b;
+
+    for (b = 0; b < HISTBUCKETS; b++) {
+        dst->bucket[b] += src->bucket[b];
+    }
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+}
+
+/**
+ *  \brief Computing a percentile.
+ *
+ *  \param h pointer to the histogram
+ *  \param p percentile (0 .. 100)
+ *
+ *  \return largest value of the bucket of the percentile (at most the largest recorded value), 0 if the histogram
+ *          is empty
+ */
+unsigned long histPercentile (HISTOGRAM *h, double p)
+{
+    unsigned long rank = (unsigned long) (p / 100.0 * h->count + 0.5),    /* number of values up to the percentile */
+                  seen = 0;
+    unsigned int b;
+
+    if (h->count == 0) {
+        return 0;
+    }
+    if (rank < 1) {
+        rank = 1;
+    }
+    for (b = 0; b < HISTBUCKETS; b++) {
+        if ((seen += h->bucket[b]) >= rank) {
+            break;
+        }
+    }
+    return (highestOf (b) < h->max) ? highestOf (b) : h->max;
+}
@@ -0,0 +1,72 @@
+/**
+ *  \file histogram.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Histograms of durations.
+ *
+ *  Operations defined on a histogram:
+ *     \li recording a value
+ *     \li adding a histogram to another
+ *     \li computing a percentile.
+ *
+ *  Buckets are log-linear, as in HDR histograms: values below <tt>2^HISTSUBBITS</tt> have a bucket of their own
+ *  and every power of two above is split into <tt>2^HISTSUBBITS</tt> buckets, so that a value is known with a
+ *  relative error below <tt>2^-HISTSUBBITS</tt>. Values are recorded with atomic operations, without locks, so that
+ *  a histogram in shared memory may be updated by every entity.
+ */
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+/** \brief number of bits of the sub-buckets of a power of two */
+#define  HISTSUBBITS     4
+
+/** \brief largest power of two given buckets (larger values are recorded in the last bucket) */
+#define  HISTMAXEXP     40
+
+/** \brief number of buckets */
+#define  HISTBUCKETS    ((HISTMAXEXP - HISTSUBBITS + 2) << HISTSUBBITS)
+
+/**
+ *  \brief Definition of <em>histogram</em> data type.
+ */
+typedef struct {
+    /** \brief number of recorded values */
+    unsigned long count;
+    /** \brief sum of the recorded values */
+    unsigned long sum;
+    /** \brief largest recorded value */
+    unsigned long max;
+    /** \brief number of recorded values of each bucket */
+    unsigned int bucket[HISTBUCKETS];
+} HISTOGRAM;
+
+/**
+ *  \brief Recording a value.
+ *
+ *  \param h pointer to the histogram
+ *  \param value value to be recorded
+ */
+extern void histRecord (HISTOGRAM *h, unsigned long value);
+
+/**
+ *  \brief Adding a histogram to another (the histograms must not be updated meanwhile).
+ *
+ *  \param dst pointer to the histogram the values are added to
+ *  \param src pointer to the histogram whose values are added
+ */
+extern void histMerge (HISTOGRAM *dst, HISTOGRAM *src);
+
+/**
+ *  \brief Computing a percentile.
+ *
+ *  \param h pointer to the histogram
+ *  \param p percentile (0 .. 100)
+ *
+ *  \return largest value of the bucket of the percentile (at most the largest recorded value), 0 if the histogram
+ *          is empty
+ */
+extern unsigned long histPercentile (HISTOGRAM *h, double p);
+
+#endif /* HISTOGRAM_H_ */
@@ -0,0 +1,227 @@
+/**
+ *  \file latency.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Latency statistics.
+ *
+ *  Operations defined on the latency statistics:
+ *     \li size of the stamps and semaphore histograms
+ *     \li initialization
+ *     \li joining the statistics and leaving them
+ *     \li stamping a transition of a group
+ *     \li printing the percentiles
+ *     \li printing the utilization of the tables.
+ *
+ *  A group is the only writer of its stamps, so they need no lock; the histograms are updated atomically.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "semaphore.h"
+#include "virtualClock.h"
+#include "histogram.h"
+#include "latency.h"
+
+/** \brief stamps of the groups */
+#define  STAMPS(lat)     ((unsigned long *) ((char *) (lat) + (lat)->stampsOff))
+
+/** \brief histograms of the downs of each semaphore */
+#define  WAITS(lat)      ((HISTOGRAM *) ((char *) (lat) + (lat)->waitsOff))
+
+/** \brief names of the latencies */
+static const char *phaseName[NLATENCIES] = {"reception to table", "order to food", "checkout"};
+
+/* internal functions */
+
+static void printHistogram (FILE *fp, const char *name, HISTOGRAM *h)
+{
+    fprintf (fp, "%-28s %8lu %10.1f %10.1f %10.1f", name, h->count, histPercentile (h, 50.0) / 1000.0,
+             histPercentile (h, 99.0) / 1000.0, h->max / 1000.0);
+}
+
+/* external functions */
+
+/**
+ *  \brief Size of the stamps and semaphore histograms.
+ *
+ *  \param nGroups number of groups
+ *  \param nSems number of semaphores (including the start of operations semaphore)
+ *
+ *  \return number of bytes required by the stamps and the histograms
+ */
+unsigned long latencyBytes (unsigned int nGroups, unsigned int nSems)
+{
+    return nGroups * NSTAMPS * sizeof (unsigned long) + nSems * sizeof (HISTOGRAM);
+}
+
+/**
+ *  \brief Latency statistics initialization.
+ *
+ *  \param lat pointer to the statistics
+ *  \param space pointer to the space reserved for the stamps and histograms (in shared memory, aligned for them),
+ *         NULL to disable the statistics
+ *  \param nGroups number of groups
+ *  \param nSems number of semaphores (including the start of operations semaphore)
+ */
+void initLatency (LATENCY *lat, void *space, unsigned int nGroups, unsigned int nSems)
+{
+    memset (lat, 0, sizeof (LATENCY));
+    if (space == NULL) {
+        return;
+    }
+    lat->enabled = 1;
+    lat->nSems = nSems;
+    lat->nGroups = nGroups;
+    lat->stampsOff = (char *) space - (char *) lat;
+    lat->waitsOff = lat->stampsOff + nGroups * NSTAMPS * sizeof (unsigned long);
+    memset (space, 0, latencyBytes (nGroups, nSems));
+}
+
+/**
+ *  \brief Joining the statistics: the downs of the calling thread are timed from now on.
+ *
+ *  \param lat pointer to the statistics
+ */
+void joinLatency (LATENCY *lat)
+{
+    if (lat->enabled) {
+        semTimeWaits (WAITS (lat));
+    }
+}
+
+/**
+ *  \brief Leaving the statistics: the downs of the calling thread are no longer timed.
+ *
+ *  \param lat pointer to the statistics
+ */
+void leaveLatency (LATENCY *lat)
+{
+    semTimeWaits (NULL);
+}
+
+/**
+ *  \brief Stamping a transition of a group, recording the latency of the phase it ends (if any).
+ *
+ *  \param lat pointer to the statistics
+ *  \param clk pointer to the clock (simulated time when enabled)
+ *  \param id group id
+ *  \param event new state of the group or GOTTABLE
+ */
+void stampGroup (LATENCY *lat, VCLOCK *clk, int id, unsigned int event)
+{
+    unsigned long *stamps;                                                               /* stamps of the group */
+
+    if (!lat->enabled) {
+        return;
+    }
+    stamps = STAMPS (lat) + (unsigned long) id * NSTAMPS;
+    stamps[event] = clockNow (clk);
+    switch (event) {
+        case GOTTABLE:
+            histRecord (&lat->phase[LATTABLE], stamps[GOTTABLE] - stamps[ATRECEPTION]);
+            break;
+        case EAT:
+            histRecord (&lat->phase[LATFOOD], stamps[EAT] - stamps[FOOD_REQUEST]);
+            break;
+        case LEAVING:
+            histRecord (&lat->phase[LATCHECKOUT], stamps[LEAVING] - stamps[CHECKOUT]);
+            break;
+    }
+}
+
+/**
+ *  \brief Printing the count, median, 99th percentile and maximum of the latencies and of the downs of the
+ *  semaphores (microseconds).
+ *
+ *  The downs of a range of several semaphores are merged and the semaphore with the longest down is printed.
+ *
+ *  \param fp stream the statistics are printed to
+ *  \param lat pointer to the statistics
+ *  \param ranges semaphores printed together (semaphore ranges without downs are not printed)
+ *  \param n number of ranges
+ */
+void printLatency (FILE *fp, LATENCY *lat, SEM_RANGE ranges[], unsigned int n)
+{
+    HISTOGRAM *merged;                                                        /* downs of a range of semaphores */
+    unsigned int r, s, worst;
+    char name[64];
+
+    if (!lat->enabled) {
+        return;
+    }
+    if ((merged = malloc (sizeof (HISTOGRAM))) == NULL) {
+        perror ("error on allocating the histogram");
+        exit (EXIT_FAILURE);
+    }
+    fprintf (fp, "%-28s %8s %10s %10s %10s\n", "latency (us)", "count", "p50", "p99", "max");
+    for (r = 0; r < NLATENCIES; r++) {
+        printHistogram (fp, phaseName[r], &lat->phase[r]);
+        fprintf (fp, "\n");
+    }
+    fprintf (fp, "%-28s %8s %10s %10s %10s\n", "semaphore downs (us)", "count", "p50", "p99", "max");
+    for (r = 0; r < n; r++) {
+        memset (merged, 0, sizeof (HISTOGRAM));
+        worst = ranges[r].first;
+        for (s = ranges[r].first; (s < ranges[r].first + ranges[r].count) && (s < lat->nSems); s++) {
+            histMerge (merged, &WAITS (lat)[s]);
+            if (WAITS (lat)[s].max > WAITS (lat)[worst].max) {
+                worst = s;
+            }
+        }
+        if (merged->count == 0) {
+            continue;
+        }
+        if (ranges[r].count > 1) {
+            snprintf (name, sizeof (name), "%s[%u]", ranges[r].name, ranges[r].count);
+            printHistogram (fp, name, merged);
+            fprintf (fp, "  (longest: %s %u)\n", ranges[r].name, worst - ranges[r].first);
+        }
+        else {
+            printHistogram (fp, ranges[r].name, merged);
+            fprintf (fp, "\n");
+        }
+    }
+    free (merged);
+}
+
+/**
+ *  \brief Printing the utilization of the tables.
+ *
+ *  A table is busy from the assignment to a group until the group leaves; the utilization is the busy time of
+ *  every table over the time the tables were available, from the first arrival at the reception to the last
+ *  group leaving.
+ *
+ *  \param fp stream the utilization is printed to
+ *  \param lat pointer to the statistics
+ *  \param nTables number of tables
+ *  \param policy name of the scheduling policy of the waiting groups
+ */
+void printUtilization (FILE *fp, LATENCY *lat, unsigned int nTables, const char *policy)
+{
+    unsigned long *stamps;                                                               /* stamps of a group */
+    unsigned long first = ~0UL, last = 0;                        /* first arrival and last group leaving (ns) */
+    double busy = 0.0;                                                        /* busy time of the tables (ns) */
+    unsigned int g;
+
+    if (!lat->enabled) {
+        return;
+    }
+    for (g = 0; g < lat->nGroups; g++) {
+        stamps = STAMPS (lat) + (unsigned long) g * NSTAMPS;
+        if (stamps[ATRECEPTION] < first) {
+            first = stamps[ATRECEPTION];
+        }
+        if (stamps[LEAVING] > last) {
+            last = stamps[LEAVING];
+        }
+        busy += stamps[LEAVING] - stamps[GOTTABLE];
+    }
+    fprintf (fp, "%-28s %7.1f %%  (%s, %u tables over %.1f ms)\n", "table utilization",
+             (last > first) ? 100.0 * busy / ((double) nTables * (last - first)) : 0.0, policy, nTables,
+             (last > first) ? (last - first) / 1e6 : 0.0);
+}
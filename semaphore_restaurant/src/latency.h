@@ -0,0 +1,108 @@
+/**
+ *  \file latency.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Latency statistics.
+ *
+ *  Operations defined on the latency statistics:
+ *     \li size of the stamps and semaphore histograms
+ *     \li initialization
+ *     \li joining the statistics and leaving them
+ *     \li stamping a transition of a group
+ *     \li printing the percentiles
+ *     \li printing the utilization of the tables.
+ *
+ *  The latencies of the groups (reception to table, order to food and checkout) are computed from the stamps of
+ *  their transitions and recorded in lock-free histograms in shared memory; the entities that join the statistics
+ *  have the time of their downs recorded in the histogram of the semaphore. When the statistics are disabled,
+ *  the operations have no effect.
+ */
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <stdio.h>
+
+#include "probDataStruct.h"
+
+/**
+ *  \brief Definition of a <em>semaphore range</em>: semaphores printed together.
+ */
+typedef struct {
+    /** \brief name of the semaphores */
+    const char *name;
+    /** \brief identification of the first semaphore */
+    unsigned int first;
+    /** \brief number of semaphores */
+    unsigned int count;
+} SEM_RANGE;
+
+/**
+ *  \brief Size of the stamps and semaphore histograms.
+ *
+ *  \param nGroups number of groups
+ *  \param nSems number of semaphores (including the start of operations semaphore)
+ *
+ *  \return number of bytes required by the stamps and the histograms
+ */
+extern unsigned long latencyBytes (unsigned int nGroups, unsigned int nSems);
+
+/**
+ *  \brief Latency statistics initialization.
+ *
+ *  \param lat pointer to the statistics
+ *  \param space pointer to the space reserved for the stamps and histograms (in shared memory, aligned for them),
+ *         NULL to disable the statistics
+ *  \param nGroups number of groups
+ *  \param nSems number of semaphores (including the start of operations semaphore)
+ */
+extern void initLatency (LATENCY *lat, void *space, unsigned int nGroups, unsigned int nSems);
+
+/**
+ *  \brief Joining the statistics: the downs of the calling thread are timed from now on.
+ *
+ *  \param lat pointer to the statistics
+ */
+extern void joinLatency (LATENCY *lat);
+
+/**
+ *  \brief Leaving the statistics: the downs of the calling thread are no longer timed.
+ *
+ *  \param lat pointer to the statistics
+ */
+extern void leaveLatency (LATENCY *lat);
+
+/**
+ *  \brief Stamping a transition of a group, recording the latency of the phase it ends (if any).
+ *
+ *  \param lat pointer to the statistics
+ *  \param clk pointer to the clock (simulated time when enabled)
+ *  \param id group id
+ *  \param event new state of the group or GOTTABLE
+ */
+extern void stampGroup (LATENCY *lat, VCLOCK *clk, int id, unsigned int event);
+
+/**
+ *  \brief Printing the count, median, 99th percentile and maximum of the latencies and of the downs of the
+ *  semaphores (microseconds).
+ *
+ *  \param fp stream the statistics are printed to
+ *  \param lat pointer to the statistics
+ *  \param ranges semaphores printed together (semaphore ranges without downs are not printed)
+ *  \param n number of ranges
+ */
+extern void printLatency (FILE *fp, LATENCY *lat, SEM_RANGE ranges[], unsigned int n);
+
+/**
+ *  \brief Printing the utilization of the tables: their busy time, from the assignment to a group until the
+ *  group leaves, over the time they were available.
+ *
+ *  \param fp stream the utilization is printed to
+ *  \param lat pointer to the statistics
+ *  \param nTables number of tables
+ *  \param policy name of the scheduling policy of the waiting groups
+ */
+extern void printUtilization (FILE *fp, LATENCY *lat, unsigned int nTables, const char *policy);
+
+#endif /* LATENCY_H_ */
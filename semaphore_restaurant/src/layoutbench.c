@@ -0,0 +1,224 @@
+/**
+ *  \file layoutbench.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  Benchmark of the cache line traffic caused by the layout of the shared data.
+ *
+ *  For each pair of fields that different entities update at the same time, two threads, on different processors
+ *  when possible, update (or, for the fields that are only read, read) one field each and the time of an
+ *  operation is measured. Fields that share a cache line take the line away from each other on every write, so
+ *  their operations are much slower than those of fields in different lines. The first pairs are the reference:
+ *  two words of the same line and two words of different lines. The fixed size arrays of the full state, whose
+ *  layout is that of the reference binaries, are measured next to the arrays that follow the shared data (option
+ *  <tt>-a</tt> of the generator, or large populations).
+ *
+ *  Options:
+ *    \li <tt>-n ops</tt> number of operations of each thread (10000000 by default).
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "sharedDataSync.h"
+
+/** \brief default number of operations of each thread */
+#define  BENCHOPS        10000000UL
+
+/** \brief number of groups of the group arrays that follow the shared data */
+#define  BENCHGROUPS     MAXGROUPS
+
+/**
+ *  \brief Definition of the <em>measured pair</em> data type.
+ */
+typedef struct {
+    /** \brief description of the pair */
+    const char *name;
+    /** \brief field updated by the first thread */
+    unsigned int *first;
+    /** \brief field updated (or read) by the second thread */
+    unsigned int *second;
+    /** \brief set when the second field is only read */
+    bool read;
+} PAIR;
+
+/**
+ *  \brief Definition of the <em>worker</em> data type: one of the threads of a measurement.
+ */
+typedef struct {
+    /** \brief field of the worker */
+    unsigned int *field;
+    /** \brief set when the field is only read */
+    bool read;
+    /** \brief processor the worker runs on (-1 for any) */
+    int cpu;
+    /** \brief number of operations */
+    unsigned long ops;
+    /** \brief time of the operations (in seconds) */
+    double elapsed;
+} WORKER;
+
+/** \brief both workers are ready */
+static pthread_barrier_t ready;
+
+/* internal functions */
+
+static double secondsNow (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *workerLife (void *arg)
+{
+    WORKER *w = (WORKER *) arg;
+    unsigned long n, sum = 0;
+    double start;
+
+    if (w->cpu >= 0) {
+        cpu_set_t set;
+
+        CPU_ZERO (&set);
+        CPU_SET (w->cpu, &set);
+        pthread_setaffinity_np (pthread_self (), sizeof (set), &set);
+    }
+    pthread_barrier_wait (&ready);
+    start = secondsNow ();
+    if (w->read) {
+        for (n = 0; n < w->ops; n++) {
+            sum += __atomic_load_n (w->field, __ATOMIC_RELAXED);
+        }
+    }
+    else {
+        for (n = 0; n < w->ops; n++) {
+            __atomic_add_fetch (w->field, 1, __ATOMIC_RELAXED);
+        }
+    }
+    w->elapsed = secondsNow () - start;
+    return (void *) sum;
+}
+
+static double measure (PAIR *p, int cpus[], unsigned long ops)
+{
+    WORKER w[2] = { { p->first, false, cpus[0], ops, 0.0 }, { p->second, p->read, cpus[1], ops, 0.0 } };
+    pthread_t thr[2];
+    int t;
+
+    pthread_barrier_init (&ready, NULL, 2);
+    for (t = 0; t < 2; t++) {
+        if (pthread_create (&thr[t], NULL, workerLife, &w[t]) != 0) {
+            perror ("error on creating a worker thread");
+            exit (EXIT_FAILURE);
+        }
+    }
+    for (t = 0; t < 2; t++) {
+        pthread_join (thr[t], NULL);
+    }
+    pthread_barrier_destroy (&ready);
+    return (w[0].elapsed + w[1].elapsed) / 2 * 1e9 / ops;
+}
+
+/**
+ *  \brief Main program.
+ *
+ *  Its role is to measure the time of the operations of every pair of fields and to print it.
+ */
+int main (int argc, char *argv[])
+{
+    SHARED_DATA *sh;                                                                    /* measured shared data */
+    unsigned int *words;                                                 /* reference words, a cache line apart */
+    unsigned long arrayBytes = CACHELINES (BENCHGROUPS * sizeof (int));        /* size of each separate array */
+    char *arrays;                                                  /* group arrays that follow the shared data */
+    unsigned long ops = BENCHOPS;                                             /* number of operations per thread */
+    int cpus[2] = { -1, -1 };                                                    /* processors of the workers */
+    cpu_set_t set;
+    int opt, c, n;
+
+    while ((opt = getopt (argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n':
+                ops = strtoul (optarg, NULL, 0);
+                break;
+            default:
+                fprintf (stderr, "Usage: %s [-n ops]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (ops == 0) {
+        fprintf (stderr, "Usage: %s [-n ops]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if ((posix_memalign ((void **) &sh, 4096, sizeof (SHARED_DATA)) != 0) ||
+        (posix_memalign ((void **) &words, CACHELINE, 2 * CACHELINE) != 0) ||
+        (posix_memalign ((void **) &arrays, CACHELINE, 5 * arrayBytes) != 0)) {
+        perror ("error on allocating the shared data");
+        return EXIT_FAILURE;
+    }
+    memset (sh, 0, sizeof (SHARED_DATA));
+    memset (words, 0, 2 * CACHELINE);
+    memset (arrays, 0, 5 * arrayBytes);
+
+    CPU_ZERO (&set);
+    if (sched_getaffinity (0, sizeof (set), &set) == 0) {
+        for (c = 0, n = 0; (c < CPU_SETSIZE) && (n < 2); c++) {
+            if (CPU_ISSET (c, &set)) {
+                cpus[n++] = c;
+            }
+        }
+        if (n < 2) {
+            cpus[0] = cpus[1] = -1;
+        }
+    }
+
+    PAIR pairs[] = {
+        { "reference: words of the same line", &words[0], &words[1], false },
+        { "reference: words of different lines", &words[0], &words[CACHELINE / sizeof (int)], false },
+        { "chef / waiter states (reference layout)", &sh->fSt.st.chefStat, &sh->fSt.st.waiterStat, false },
+        { "group 0 / group 1 states (reference layout)", &sh->fSt.st.groupStat[0], &sh->fSt.st.groupStat[1],
+          false },
+        { "group state / start time (fixed arrays)", &sh->fSt.st.groupStat[MAXGROUPS - 1],
+          (unsigned int *) &sh->fSt.startTime[0], true },
+        { "group state / start time (separate arrays)", (unsigned int *) (arrays + 3 * arrayBytes),
+          (unsigned int *) arrays, true },
+        { "receptionist / waiter mailboxes", &sh->receptionistBox.count, &sh->waiterBox.count, false },
+        { "order queue / log ring head", &sh->orders.count, &sh->log.ring.head, false },
+        { "log ring head / tail", &sh->log.ring.head, &sh->log.ring.tail, false },
+        { "log ring head / log lock semaphore", &sh->log.ring.head, &sh->log.lockSem, true },
+        { "clock lock / clock members", &sh->clock.lock, &sh->clock.members, true },
+        { "replay next entry / log ring head", &sh->replay.next, &sh->log.ring.head, false },
+        { "latency count / number of semaphores", (unsigned int *) &sh->lat.phase[LATTABLE].count, &sh->lat.nSems,
+          true },
+    };
+
+    if (cpus[0] == -1) {
+        printf ("Only one processor is available: the workers share it and no cross-core traffic is measured.\n\n");
+    }
+    else printf ("Workers on processors %d and %d, %lu operations each.\n\n", cpus[0], cpus[1], ops);
+    printf ("%-46s %-6s %9s  %-5s %10s\n", "fields", "second", "distance", "line", "ns/op");
+    for (n = 0; n < (int) (sizeof (pairs) / sizeof (pairs[0])); n++) {
+        unsigned long first = (unsigned long) pairs[n].first, second = (unsigned long) pairs[n].second;
+        bool same = (first / CACHELINE) == (second / CACHELINE);
+
+        printf ("%-46s %-6s %9lu  %-5s %10.2f\n", pairs[n].name, pairs[n].read ? "read" : "write",
+                (first > second) ? first - second : second - first, same ? "same" : "apart",
+                measure (&pairs[n], cpus, ops));
+    }
+
+    free (arrays);
+    free (words);
+    free (sh);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,159 @@
+/**
+ *  \file logdump.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  Renderer of binary trace files.
+ *
+ *  Upon execution, one parameter is requested:
+ *    \li name of the binary trace file (stdin is used if it is missing).
+ *
+ *  Options:
+ *    \li <tt>-f</tt> the trace is rendered in the layout of <tt>filter_log.awk</tt>, where unchanged entity states
+ *        are replaced by dots; otherwise it is rendered in the layout of the text log.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "logging.h"
+
+/** \brief maximum length of a column */
+#define  COLSIZE         12
+
+/** \brief number of columns of a line */
+static int nCols;
+
+/** \brief width of each column in the filtered layout */
+static int *colWidth;
+
+/** \brief previous value of each column in the filtered layout */
+static char (*prevCol)[COLSIZE];
+
+/**
+ *  \brief prints a line in the filtered layout.
+ *
+ *  The chef, waiter, receptionist and groups columns are replaced by a dot when the value did not change
+ *  since the previous line.
+ *
+ *  \param col values of the columns
+ *  \param nGroups number of groups
+ */
+static void printFiltered (char col[][COLSIZE], int nGroups)
+{
+    int c;
+
+    for (c = 0; c < nCols; c++) {
+        if (c < nGroups + 3) {
+            if (strcmp (col[c], prevCol[c]) == 0) {
+                printf ("%*s ", colWidth[c], ".");
+            }
+            else printf ("%*s ", colWidth[c], col[c]);
+            strcpy (prevCol[c], col[c]);
+        }
+        else printf ("%*s ", colWidth[c], col[c]);
+    }
+    printf ("\n");
+}
+
+/**
+ *  \brief Main program.
+ *
+ *  Its role is to read a binary trace file and to render its records as text.
+ */
+int main (int argc, char *argv[])
+{
+    FILE *fic;                                                                                 /* binary trace file */
+    FULL_STAT *p_fSt;                                                                              /* decoded state */
+    GROUP_ARRAYS groups;                                                           /* location of the group arrays */
+    unsigned int *groupStat;                                                                  /* state of the groups */
+    int *assignedTable;                                                              /* table assigned to the groups */
+    int nGroups, nTables;                                                           /* number of groups and tables */
+    bool filtered = false;                                                                  /* filtered layout flag */
+    char (*col)[COLSIZE];                                                                   /* values of the columns */
+    int opt, c, g;
+
+    while ((opt = getopt (argc, argv, "f")) != -1) {
+        switch (opt) {
+            case 'f':
+                filtered = true;
+                break;
+            default:
+                fprintf (stderr, "Usage: %s [-f] [trace file]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (optind < argc) {
+        if ((fic = fopen (argv[optind], "r")) == NULL) {
+            perror ("error on opening the trace file");
+            return EXIT_FAILURE;
+        }
+    }
+    else fic = stdin;
+
+    if (readTraceHeader (fic, &nGroups, &nTables) == -1) {
+        fprintf (stderr, "Not a binary trace file!\n");
+        return EXIT_FAILURE;
+    }
+    p_fSt = newLogState (nGroups, &groups);
+    groupStat = GROUPARRAY (p_fSt, groups.groupStat, unsigned int);
+    assignedTable = GROUPARRAY (p_fSt, groups.assignedTable, int);
+
+    if (!filtered) {
+        createLog ("", p_fSt);
+        while (readTraceState (fic, p_fSt, nTables)) {
+            saveState ("", p_fSt);
+        }
+        closeLogSession ();
+        return EXIT_SUCCESS;
+    }
+
+    /* column widths and header line, as in filter_log.awk */
+    nCols = 4 + 2*nGroups;
+    colWidth = malloc (nCols * sizeof (int));
+    prevCol = calloc (nCols, COLSIZE);
+    col = malloc (nCols * COLSIZE);
+    if ((colWidth == NULL) || (prevCol == NULL) || (col == NULL)) {
+        perror ("error on allocating the columns");
+        return EXIT_FAILURE;
+    }
+    colWidth[0] = 3;
+    colWidth[1] = colWidth[2] = 2;
+    for (c = 3; c < nCols; c++) {
+        colWidth[c] = 3;
+    }
+    colWidth[3 + nGroups] = 4;
+
+    printf ("%31cRestaurant - Description of the internal state\n\n", ' ');
+    strcpy (col[0], "CH");
+    strcpy (col[1], "WT");
+    strcpy (col[2], "RC");
+    for (g = 0; g < nGroups; g++) {
+        sprintf (col[3 + g], "G%02d", g);
+        sprintf (col[4 + nGroups + g], "T%02d", g);
+    }
+    strcpy (col[3 + nGroups], "gWT");
+    printFiltered (col, nGroups);
+
+    while (readTraceState (fic, p_fSt, nTables)) {
+        sprintf (col[0], "%u", p_fSt->st.chefStat);
+        sprintf (col[1], "%u", p_fSt->st.waiterStat);
+        sprintf (col[2], "%u", p_fSt->st.receptionistStat);
+        for (g = 0; g < nGroups; g++) {
+            sprintf (col[3 + g], "%u", groupStat[g]);
+            if (assignedTable[g] != -1) {
+                sprintf (col[4 + nGroups + g], "%d", assignedTable[g]);
+            }
+            else strcpy (col[4 + nGroups + g], ".");
+        }
+        sprintf (col[3 + nGroups], "%d", p_fSt->groupsWaiting);
+        printFiltered (col, nGroups);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -7,25 +7,132 @@
  *
  *  Defined operations:
  *     \li file initialization
- *     \li writing the present full state as a single line at the end of the file.
+ *     \li opening and closing of a log session
+ *     \li writing the present full state as a single line at the end of the file
+ *     \li queueing the present full state in the log ring and draining it into the file
+ *     \li writing and reading the binary trace format
+ *     \li writing the structured event formats (JSON lines and CSV)
+ *     \li numbering the entity that saves its state
+ *     \li publishing the last saved state and sampling it without locks
+ *     \li skipping the saves of a state equal to the last saved one (coalesced log)
+ *     \li allocation of full states for any number of groups.
+ *
+ *  The structured formats are written by the log drainer: each event (saved state) is written with its sequence
+ *  number, time and entity and the fields that changed since the previous event, named as in the text header.
  *
  *  \author Nuno Lau - December 2023
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
 
 #include <sys/types.h>
 #include <unistd.h>
+#include <sched.h>
+#include <time.h>
 
 
 #include "probConst.h"
 #include "probDataStruct.h"
+#include "semaphore.h"
+
+/** \brief maximum length of a state line for n groups (chef, waiter, receptionist, groups, waiting groups, tables) */
+#define  LINESIZE(n)     (16 + 8*(n))
+
+/** \brief size of a packed state snapshot for n groups (states, waiting groups, groups state, tables) */
+#define  RECSIZE(n)      (5 + 3*(n))
+
+/** \brief number of bits of an entity state in the binary trace */
+#define  STATBITS        3
+
+/** \brief identification of binary trace files */
+#define  TRACEMAGIC      "RSTT"
+
+/** \brief size of the binary trace header (magic, number of groups, number of tables) */
+#define  TRACEHDRSIZE    8
+
+/** \brief size of the buffer used by the log drainer to batch lines */
+#define  DRAINBUFSIZE    (64*1024)
+
+/** \brief number of fields of a state for n groups (chef, waiter, receptionist, groups, waiting groups, tables) */
+#define  NFIELDS(n)      (4 + 2*(n))
+
+/** \brief maximum length of a structured event for n groups (every field changed) */
+#define  EVENTSIZE(n)    (128 + 64*NFIELDS(n))
+
+/** \brief entity that saves the state and time it was saved, stored after the stamp of a log ring slot */
+typedef struct {
+    /** \brief kind of entity (MEMBERGROUP, MEMBERWAITER, MEMBERCHEF, MEMBERRECEPTIONIST or -1 for the generator) */
+    int kind;
+    /** \brief number of the entity among those of its kind */
+    int id;
+    /** \brief time the state was saved (nanoseconds since the start of the log) */
+    unsigned long time;
+} LOG_EVENT;
+
+/** \brief file descriptor of the log session (-1 if no session is open) */
+static int logFd = -1;
+
+/** \brief log configuration of the session (NULL if lines are written directly) */
+static LOG_CONF *logConf = NULL;
+
+/** \brief semaphore set of the log lock of the session */
+static int logSemgid = -1;
+
+/** \brief log format of the session (LOGTEXT or LOGBINARY) */
+static int logFormat = LOGTEXT;
+
+/** \brief number of tables of the session */
+static int logTables = NUMTABLES;
+
+/** \brief location of the group arrays of the saved full states */
+static GROUP_ARRAYS logGroups = { offsetof (FULL_STAT, st.groupStat), offsetof (FULL_STAT, startTime),
+                                  offsetof (FULL_STAT, eatTime), offsetof (FULL_STAT, assignedTable) };
+
+/** \brief buffer where state lines are formatted before being written */
+static char *logBuf = NULL;
+
+/** \brief size of the buffer where state lines are formatted */
+static size_t logBufSize = 0;
+
+/** \brief number of open log sessions (the entities of the threaded engine share the file descriptor) */
+static int logSessions = 0;
+
+/** \brief kind of the entity of the calling thread (-1 for the generator) */
+static __thread int logKind = -1;
+
+/** \brief number of the entity of the calling thread among those of its kind */
+static __thread int logId = 0;
+
+/** \brief names of the kinds of entities */
+static const char *kindName[MEMBERKINDS] = {"group", "waiter", "chef", "receptionist"};
+
+/** \brief state of group g of the full state p_fSt, whose group arrays are located by groups */
+#define  GROUPSTATOF(p_fSt, groups, g)   (GROUPARRAY(p_fSt, (groups)->groupStat, unsigned int)[g])
+
+/** \brief table assigned to group g of the full state p_fSt, whose group arrays are located by groups */
+#define  TABLEOF(p_fSt, groups, g)       (GROUPARRAY(p_fSt, (groups)->assignedTable, int)[g])
 
 /* internal functions */
 
+static char *lineBuffer(int nGroups)
+{
+    if (logBufSize < LINESIZE(nGroups)) {
+        free(logBuf);
+        logBufSize = LINESIZE(nGroups);
+        if ((logBuf = malloc(logBufSize)) == NULL) {
+            perror ("error on allocating the log buffer");
+            exit (EXIT_FAILURE);
+        }
+    }
+    return logBuf;
+}
+
 static FILE *openLog(char nFic[], char mode[])
 {
     FILE *fic;
@@ -47,6 +154,48 @@ static FILE *openLog(char nFic[], char mode[])
     return fic;
 }
 
+static int openLogFd(char nFic[])
+{
+    int fd;
+
+    if ((nFic == NULL) || (strlen (nFic) == 0)) {
+        return STDOUT_FILENO;
+    }
+
+    fprintf(stderr,"%d opening log %s %s\n",getpid(),nFic,"a");
+
+    if ((fd = open (nFic, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0666)) == -1) {
+        perror ("error on opening log file");
+        exit (EXIT_FAILURE);
+    }
+    return fd;
+}
+
+static void closeLogFd(int fd)
+{
+    if ((fd != STDOUT_FILENO) && (close (fd) == -1)) {
+        perror ("error on closing of log file");
+        exit (EXIT_FAILURE);
+    }
+}
+
+static FULL_STAT *allocState(int nGroups, GROUP_ARRAYS *groups)
+{
+    FULL_STAT *p_fSt;
+    size_t arraySize = nGroups * sizeof (int);                                           /* size of a group array */
+
+    if ((p_fSt = calloc (1, sizeof (FULL_STAT) + 4 * arraySize)) == NULL) {
+        perror ("error on allocating the full state");
+        exit (EXIT_FAILURE);
+    }
+    p_fSt->nGroups = nGroups;
+    groups->groupStat = sizeof (FULL_STAT);
+    groups->startTime = groups->groupStat + arraySize;
+    groups->eatTime = groups->startTime + arraySize;
+    groups->assignedTable = groups->eatTime + arraySize;
+    return p_fSt;
+}
+
 static void closeLog(FILE *fic)
 {
     if(fic==stderr || fic == stdout) {
@@ -80,8 +229,433 @@ static void printHeader(FILE *fic, FULL_STAT *p_fSt)
     fprintf(fic,"\n");
 }
 
+static char *putNum(char *p, int width, int val)
+{
+    char digits[12];
+    int n = 0;
+    unsigned int u = (val < 0) ? -(unsigned int) val : (unsigned int) val;
+
+    do {
+        digits[n++] = (char) ('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+    if (val < 0) {
+        digits[n++] = '-';
+    }
+    while (width-- > n) {
+        *p++ = ' ';
+    }
+    while (n > 0) {
+        *p++ = digits[--n];
+    }
+    return p;
+}
+
+static char *putStr(char *p, int width, char str[])
+{
+    int n = strlen(str);
+
+    while (width-- > n) {
+        *p++ = ' ';
+    }
+    memcpy(p, str, n);
+    return p + n;
+}
+
+static void writeLog(int fd, char buf[], size_t len)
+{
+    ssize_t n;
+
+    while (len > 0) {
+        if ((n = write(fd, buf, len)) == -1) {
+            if (errno == EINTR) continue;
+            perror ("error on writing to log file");
+            exit (EXIT_FAILURE);
+        }
+        buf += n;
+        len -= n;
+    }
+}
+
+static size_t formatState(char buf[], FULL_STAT *p_fSt, GROUP_ARRAYS *groups)
+{
+    char *p = buf;                                                                     /* insertion point in buffer */
+    int g;
+
+    p = putNum(p, 3, p_fSt->st.chefStat);
+    p = putNum(p, 3, p_fSt->st.waiterStat);
+    p = putNum(p, 3, p_fSt->st.receptionistStat);
+    *p++ = ' ';
+    for(g=0; g < p_fSt->nGroups; g++) {
+        p = putNum(p, 4, GROUPSTATOF(p_fSt, groups, g));
+    }
+
+    p = putNum(p, 5, p_fSt->groupsWaiting);
+
+    for(g=0; g < p_fSt->nGroups; g++) {
+        if(TABLEOF(p_fSt, groups, g)!=-1)
+            p = putNum(p, 4, TABLEOF(p_fSt, groups, g));
+        else {
+            p = putStr(p, 4, ".");
+        }
+    }
+
+    *p++ = '\n';
+
+    return p - buf;
+}
+
+static void packState(unsigned char *rec, FULL_STAT *p_fSt, GROUP_ARRAYS *groups)
+{
+    int g;
+
+    *rec++ = (unsigned char) p_fSt->st.chefStat;
+    *rec++ = (unsigned char) p_fSt->st.waiterStat;
+    *rec++ = (unsigned char) p_fSt->st.receptionistStat;
+    *rec++ = (unsigned char) (p_fSt->groupsWaiting & 0xff);
+    *rec++ = (unsigned char) (p_fSt->groupsWaiting >> 8);
+    for(g=0; g < p_fSt->nGroups; g++) {
+        *rec++ = (unsigned char) GROUPSTATOF(p_fSt, groups, g);
+    }
+    for(g=0; g < p_fSt->nGroups; g++) {
+        *rec++ = (unsigned char) (TABLEOF(p_fSt, groups, g) & 0xff);
+        *rec++ = (unsigned char) (TABLEOF(p_fSt, groups, g) >> 8);
+    }
+}
+
+static void unpackState(FULL_STAT *p_fSt, unsigned char *rec, GROUP_ARRAYS *groups)
+{
+    int g;
+
+    p_fSt->st.chefStat = *rec++;
+    p_fSt->st.waiterStat = *rec++;
+    p_fSt->st.receptionistStat = *rec++;
+    p_fSt->groupsWaiting = rec[0] | (rec[1] << 8);
+    rec += 2;
+    for(g=0; g < p_fSt->nGroups; g++) {
+        GROUPSTATOF(p_fSt, groups, g) = *rec++;
+    }
+    for(g=0; g < p_fSt->nGroups; g++) {
+        TABLEOF(p_fSt, groups, g) = (short) (rec[0] | (rec[1] << 8));
+        rec += 2;
+    }
+}
+
+static int bitsFor(unsigned int maxVal)
+{
+    int n = 1;
+
+    while ((n < 32) && ((1u << n) <= maxVal)) {
+        n++;
+    }
+    return n;
+}
+
+static void putBits(unsigned char rec[], unsigned int *pos, int n, unsigned int val)
+{
+    for (; n > 0; n--, val >>= 1, (*pos)++) {
+        if (val & 1) {
+            rec[*pos >> 3] |= (unsigned char) (1 << (*pos & 7));
+        }
+    }
+}
+
+static unsigned int getBits(unsigned char rec[], unsigned int *pos, int n)
+{
+    unsigned int val = 0;
+    int b;
+
+    for (b = 0; b < n; b++, (*pos)++) {
+        val |= (unsigned int) ((rec[*pos >> 3] >> (*pos & 7)) & 1) << b;
+    }
+    return val;
+}
+
+static size_t traceRecordSize(int nGroups, int nTables)
+{
+    return (STATBITS*(3 + nGroups) + bitsFor(nGroups) + nGroups*bitsFor(nTables) + 7) / 8;
+}
+
+static size_t packTrace(unsigned char rec[], FULL_STAT *p_fSt, int nTables, GROUP_ARRAYS *groups)
+{
+    size_t size = traceRecordSize(p_fSt->nGroups, nTables);
+    unsigned int pos = 0;                                                                /* bit insertion point */
+    int tblBits = bitsFor(nTables);
+    int g;
+
+    memset(rec, 0, size);
+    putBits(rec, &pos, STATBITS, p_fSt->st.chefStat);
+    putBits(rec, &pos, STATBITS, p_fSt->st.waiterStat);
+    putBits(rec, &pos, STATBITS, p_fSt->st.receptionistStat);
+    for(g=0; g < p_fSt->nGroups; g++) {
+        putBits(rec, &pos, STATBITS, GROUPSTATOF(p_fSt, groups, g));
+    }
+    putBits(rec, &pos, bitsFor(p_fSt->nGroups), p_fSt->groupsWaiting);
+    for(g=0; g < p_fSt->nGroups; g++) {
+        putBits(rec, &pos, tblBits, TABLEOF(p_fSt, groups, g) + 1);               /* 0 stands for no table assigned */
+    }
+    return size;
+}
+
+static void unpackTrace(FULL_STAT *p_fSt, unsigned char rec[], int nTables, GROUP_ARRAYS *groups)
+{
+    unsigned int pos = 0;                                                               /* bit extraction point */
+    int tblBits = bitsFor(nTables);
+    int g;
+
+    p_fSt->st.chefStat = getBits(rec, &pos, STATBITS);
+    p_fSt->st.waiterStat = getBits(rec, &pos, STATBITS);
+    p_fSt->st.receptionistStat = getBits(rec, &pos, STATBITS);
+    for(g=0; g < p_fSt->nGroups; g++) {
+        GROUPSTATOF(p_fSt, groups, g) = getBits(rec, &pos, STATBITS);
+    }
+    p_fSt->groupsWaiting = getBits(rec, &pos, bitsFor(p_fSt->nGroups));
+    for(g=0; g < p_fSt->nGroups; g++) {
+        TABLEOF(p_fSt, groups, g) = (int) getBits(rec, &pos, tblBits) - 1;
+    }
+}
+
+static size_t formatRecord(char buf[], FULL_STAT *p_fSt, int format, int nTables, GROUP_ARRAYS *groups)
+{
+    if (format == LOGBINARY) {
+        return packTrace((unsigned char *) buf, p_fSt, nTables, groups);
+    }
+    return formatState(buf, p_fSt, groups);
+}
+
+static unsigned long monotonicNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+static void fieldValues(int vals[], FULL_STAT *p_fSt, GROUP_ARRAYS *groups)
+{
+    int n = p_fSt->nGroups;
+    int g;
+
+    vals[0] = p_fSt->st.chefStat;
+    vals[1] = p_fSt->st.waiterStat;
+    vals[2] = p_fSt->st.receptionistStat;
+    for(g=0; g < n; g++) {
+        vals[3+g] = GROUPSTATOF(p_fSt, groups, g);
+    }
+    vals[3+n] = p_fSt->groupsWaiting;
+    for(g=0; g < n; g++) {
+        vals[4+n+g] = TABLEOF(p_fSt, groups, g);
+    }
+}
+
+static void fieldName(char name[], int f, int nGroups)
+{
+    static const char *fixed[3] = {"CH", "WT", "RC"};
+
+    if (f < 3) {
+        strcpy(name, fixed[f]);
+    }
+    else if (f < 3 + nGroups) {
+        sprintf(name, "G%02d", f - 3);
+    }
+    else if (f == 3 + nGroups) {
+        strcpy(name, "gWT");
+    }
+    else sprintf(name, "T%02d", f - 4 - nGroups);
+}
+
+static size_t formatEvent(char buf[], int format, unsigned int seq, LOG_EVENT *ev, int vals[], int prev[],
+                          int nGroups)
+{
+    char *p = buf;                                                                     /* insertion point in buffer */
+    char entity[16], name[12];
+    bool table;                                                                       /* field is an assigned table */
+    int f;
+
+    strcpy(entity, (ev->kind >= 0) && (ev->kind < MEMBERKINDS) ? kindName[ev->kind] : "generator");
+    if (format == LOGJSON) {
+        p += sprintf(p, "{\"seq\":%u,\"time_ns\":%lu,\"entity\":\"%s\",\"id\":%d", seq, ev->time, entity, ev->id);
+    }
+    for (f = 0; f < NFIELDS(nGroups); f++) {
+        if ((prev != NULL) && (vals[f] == prev[f])) {
+            continue;
+        }
+        fieldName(name, f, nGroups);
+        table = (f > 3 + nGroups) && (vals[f] == -1);
+        if (format == LOGJSON) {
+            p += table ? sprintf(p, ",\"%s\":null", name) : sprintf(p, ",\"%s\":%d", name, vals[f]);
+        }
+        else {
+            p += sprintf(p, "%u,%lu,%s,%d,%s,", seq, ev->time, entity, ev->id, name);
+            p += table ? sprintf(p, "\n") : sprintf(p, "%d\n", vals[f]);
+        }
+    }
+    if (format == LOGJSON) {
+        p += sprintf(p, "}\n");
+    }
+    return p - buf;
+}
+
+static void lockLog(LOG_CONF *conf)
+{
+    if (semDown(logSemgid, conf->lockSem) == -1) {
+        perror("error on the down operation for the log lock");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void unlockLog(LOG_CONF *conf)
+{
+    if (semUp(logSemgid, conf->lockSem) == -1) {
+        perror("error on the up operation for the log lock");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static unsigned int *ringSlot(LOG_RING *ring, unsigned int seq)
+{
+    return (unsigned int *) ((char *) ring + ring->slotsOff + (seq % ring->size) * ring->slotSize);
+}
+
+static LOG_SNAPSHOT *snapshotOf(LOG_CONF *conf)
+{
+    return ((conf != NULL) && (conf->snap.dataOff != 0)) ? &conf->snap : NULL;
+}
+
+static void publishState(LOG_SNAPSHOT *snap, FULL_STAT *p_fSt)
+{
+    unsigned int version = snap->version;                                       /* even, writers are serialized */
+
+    __atomic_store_n(&snap->version, version + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    packState((unsigned char *) snap + snap->dataOff, p_fSt, &logGroups);
+    snap->states += 1;
+    __atomic_store_n(&snap->version, version + 2, __ATOMIC_RELEASE);
+}
+
+static bool unchangedState(LOG_SNAPSHOT *snap, FULL_STAT *p_fSt)
+{
+    static unsigned char *rec = NULL;                                                 /* packed state to save */
+    static size_t recSize = 0;
+
+    if (snap->states == 0) {                                                 /* the first state is always saved */
+        return false;
+    }
+    if (recSize < RECSIZE(p_fSt->nGroups)) {
+        free(rec);
+        recSize = RECSIZE(p_fSt->nGroups);
+        if ((rec = malloc(recSize)) == NULL) {
+            perror ("error on allocating the packed state");
+            exit (EXIT_FAILURE);
+        }
+    }
+    packState(rec, p_fSt, &logGroups);
+    return memcmp(rec, (unsigned char *) snap + snap->dataOff, RECSIZE(p_fSt->nGroups)) == 0;
+}
+
+static void pushState(LOG_RING *ring, FULL_STAT *p_fSt, LOG_EVENT *ev)
+{
+    unsigned int pos, seq;                                          /* sequence number claimed and slot stamp */
+    unsigned int *slot;
+
+    pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    for (;;) {
+        slot = ringSlot(ring, pos);
+        seq = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+        if (seq == pos) {
+            if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else {
+            if ((int) (seq - pos) < 0) {                                /* ring is full, wait for the drainer */
+                sched_yield();
+            }
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    memcpy(slot + 1, ev, sizeof (LOG_EVENT));
+    packState((unsigned char *) (slot + 1) + sizeof (LOG_EVENT), p_fSt, &logGroups);
+    __atomic_store_n(slot, pos + 1, __ATOMIC_RELEASE);
+}
+
 /* external functions */
 
+/**
+ *  \brief Log session opening.
+ *
+ *  The function opens the logging file once, in append mode, so that the following <tt>saveState</tt> calls
+ *  do not have to open and close it.
+ *  If <tt>nFic</tt> is a null pointer or a null string, stdout is used.
+ *  If the log configuration selects the log ring, no file is opened: snapshots are queued in the ring.
+ *  The group arrays of the saved full states are located as given by the log configuration.
+ *
+ *  \param nFic name of the logging file
+ *  \param conf pointer to the shared log configuration (NULL to write lines directly)
+ *  \param semgid semaphore set access identifier (the log lock is one of its semaphores, -1 if there is none)
+ */
+void openLogSession (char nFic[], LOG_CONF *conf, int semgid)
+{
+    logConf = conf;
+    logSemgid = semgid;
+    logFormat = (conf != NULL) ? conf->format : LOGTEXT;
+    logTables = (conf != NULL) ? conf->nTables : NUMTABLES;
+    if (conf != NULL) {
+        logGroups = conf->groups;
+    }
+    __atomic_add_fetch (&logSessions, 1, __ATOMIC_ACQ_REL);
+    if ((conf != NULL) && ((conf->mode == LOGRING) || (conf->mode == LOGNONE))) {
+        return;
+    }
+    if (logFd != -1) {
+        return;
+    }
+    logFd = openLogFd(nFic);
+}
+
+/**
+ *  \brief Log session closing.
+ *
+ *  The function closes the logging file opened by <tt>openLogSession</tt>.
+ *  Sessions may be nested (threads of the same process share the logging file): the file is only closed when
+ *  the last open session is closed.
+ */
+void closeLogSession (void)
+{
+    if (__atomic_sub_fetch (&logSessions, 1, __ATOMIC_ACQ_REL) > 0) {
+        return;
+    }
+    if (logFd != -1) {
+        closeLogFd(logFd);
+    }
+    logFd = -1;
+    logConf = NULL;
+    logFormat = LOGTEXT;
+    logTables = NUMTABLES;
+}
+
+/**
+ *  \brief Allocation of a full state for a given number of groups.
+ *
+ *  The group arrays follow the allocated full state, so that any number of groups is supported; from now on, the
+ *  group arrays of the saved, read and drained full states are located as in the allocated one.
+ *  The full state is released with <tt>free</tt>.
+ *
+ *  \param nGroups number of groups
+ *  \param p_groups pointer to the location where the location of the group arrays is stored (may be NULL)
+ *
+ *  \return pointer to the allocated full state
+ */
+FULL_STAT *newLogState (int nGroups, GROUP_ARRAYS *p_groups)
+{
+    FULL_STAT *p_fSt = allocState(nGroups, &logGroups);
+
+    if (p_groups != NULL) {
+        *p_groups = logGroups;
+    }
+    return p_fSt;
+}
+
 /**
  *  \brief File initialization.
  *
@@ -108,10 +682,142 @@ void createLog (char nFic[], FULL_STAT *p_fSt)
     closeLog(fic);
 }
 
+/**
+ *  \brief Structured event file initialization.
+ *
+ *  The function creates the logging file and, for the CSV format, writes the header row
+ *  <tt>seq,time_ns,entity,id,field,value</tt>; JSON lines files have no header.
+ *  If <tt>nFic</tt> is a null pointer or a null string, stdout is used.
+ *
+ *  \param nFic name of the logging file
+ *  \param format log format (LOGJSON or LOGCSV)
+ */
+void createEventLog (char nFic[], int format)
+{
+    FILE *fic;                                                                                      /* file descriptor */
+
+    fic = openLog(nFic,"w");
+    if (format == LOGCSV) {
+        fprintf (fic, "seq,time_ns,entity,id,field,value\n");
+    }
+    closeLog(fic);
+}
+
+/**
+ *  \brief Numbering the entity of the calling thread, so that the events it saves are identified.
+ *
+ *  \param conf pointer to the shared log configuration
+ *  \param kind kind of entity (MEMBERGROUP, MEMBERWAITER, MEMBERCHEF or MEMBERRECEPTIONIST)
+ *  \param id number of the entity among those of its kind (-1 for the next number of the kind)
+ */
+void logEntity (LOG_CONF *conf, int kind, int id)
+{
+    logKind = kind;
+    logId = (id >= 0) ? id : (int) __atomic_fetch_add (&conf->numbered[kind], 1, __ATOMIC_RELAXED);
+}
+
+/**
+ *  \brief Binary trace file initialization.
+ *
+ *  The function creates the logging file and writes the binary trace header, that consists of
+ *       \li the identification "RSTT"
+ *       \li the number of groups (16 bits, little endian)
+ *       \li the number of tables (16 bits, little endian).
+ *
+ *  Each following record packs the entities states (3 bits each) in the same order as the text lines,
+ *  the number of groups waiting and the table assigned to each group plus one (0 when there is none),
+ *  using the minimum number of bits for the number of groups and tables.
+ *  If <tt>nFic</tt> is a null pointer or a null string, stdout is used.
+ *
+ *  \param nFic name of the logging file
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ *  \param nTables number of tables
+ */
+void createTrace (char nFic[], FULL_STAT *p_fSt, int nTables)
+{
+    FILE *fic;                                                                                      /* file descriptor */
+    unsigned char hdr[TRACEHDRSIZE];                                                                  /* trace header */
+
+    fic = openLog(nFic,"w");
+
+    memcpy (hdr, TRACEMAGIC, 4);
+    hdr[4] = (unsigned char) (p_fSt->nGroups & 0xff);
+    hdr[5] = (unsigned char) (p_fSt->nGroups >> 8);
+    hdr[6] = (unsigned char) (nTables & 0xff);
+    hdr[7] = (unsigned char) (nTables >> 8);
+    if (fwrite (hdr, TRACEHDRSIZE, 1, fic) != 1) {
+        perror ("error on writing the trace header");
+        exit (EXIT_FAILURE);
+    }
+
+    closeLog(fic);
+}
+
+/**
+ *  \brief Reading the header of a binary trace file.
+ *
+ *  \param fic binary trace file
+ *  \param p_nGroups pointer to the location where the number of groups is stored
+ *  \param p_nTables pointer to the location where the number of tables is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when the file is not a binary trace
+ */
+int readTraceHeader (FILE *fic, int *p_nGroups, int *p_nTables)
+{
+    unsigned char hdr[TRACEHDRSIZE];                                                                  /* trace header */
+
+    if ((fread (hdr, TRACEHDRSIZE, 1, fic) != 1) || (memcmp (hdr, TRACEMAGIC, 4) != 0)) {
+        return -1;
+    }
+    *p_nGroups = hdr[4] | (hdr[5] << 8);
+    *p_nTables = hdr[6] | (hdr[7] << 8);
+    if ((*p_nGroups < 1) || (*p_nGroups > MAXPOPULATION) || (*p_nTables < 1) || (*p_nTables > MAXTABLES)) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ *  \brief Reading the next record of a binary trace file.
+ *
+ *  \param fic binary trace file, positioned after the header
+ *  \param p_fSt pointer to the location where the state is stored (allocated by <tt>newLogState</tt>)
+ *  \param nTables number of tables
+ *
+ *  \return \c true, if a record was read
+ *  \return \c false, at the end of the file
+ */
+bool readTraceState (FILE *fic, FULL_STAT *p_fSt, int nTables)
+{
+    size_t size = traceRecordSize (p_fSt->nGroups, nTables);
+    char *buf = lineBuffer (p_fSt->nGroups);
+
+    if (fread (buf, size, 1, fic) != 1) {
+        return false;
+    }
+    unpackTrace (p_fSt, (unsigned char *) buf, nTables, &logGroups);
+    return true;
+}
+
 /**
  *  \brief Writing the present full state as a single line at the end of the file.
  *
- *  If <tt>nFic</tt> is a null pointer or a null string, the lines are written to stdout
+ *  If <tt>nFic</tt> is a null pointer or a null string, the lines are written to stdout.
+ *  If no log session was opened, one is opened on the first call.
+ *
+ *  The line is formatted into an internal buffer and appended with a single <tt>write</tt>.
+ *  If the session uses the log ring, a packed snapshot is queued instead and the line is written
+ *  later by the log drainer, in the order the snapshots were queued.
+ *  If the session uses the binary format, a trace record is written instead of the line.
+ *  If entities may save their state concurrently (locks are split), the save is carried out holding the log
+ *  lock, a semaphore of the set, so that the log order is the order in which the snapshots were taken; the
+ *  fields of the regions whose locks the caller does not hold may be changing (see sharedDataSync.h). The log
+ *  ring is then used, so that the lock is only held to claim a slot and pack the state, not across a write.
+ *  If states are published, the state is also copied to the snapshot of the log configuration; if the session
+ *  uses no log, nothing else is done.
+ *  If the log is coalesced, a state equal to the last published one is neither published nor logged, only
+ *  counted, so that no line (record or event) repeats the previous one.
  *
  *  The following layout is obeyed for the full state in a single line
  *    \li chef state
@@ -125,32 +831,254 @@ void createLog (char nFic[], FULL_STAT *p_fSt)
  */
 void saveState (char nFic[], FULL_STAT *p_fSt)
 {
-    FILE *fic;                                                                                      /* file descriptor */
+    LOG_SNAPSHOT *snap = snapshotOf(logConf);
+    bool serialize = (logConf != NULL) && (logConf->lockSem != 0) && ((logConf->mode != LOGNONE) || (snap != NULL));
 
-    fic = openLog(nFic,"a");
+    if (serialize) {
+        lockLog(logConf);
+    }
+    if ((snap != NULL) && logConf->coalesce && unchangedState(snap, p_fSt)) {
+        snap->coalesced += 1;
+        if (serialize) {
+            unlockLog(logConf);
+        }
+        return;
+    }
+    if (snap != NULL) {
+        publishState(snap, p_fSt);
+    }
+    if ((logConf != NULL) && (logConf->mode == LOGRING)) {
+        LOG_EVENT ev = { logKind, logId, monotonicNow() - logConf->start };
 
-    fprintf(fic,"%3d",p_fSt->st.chefStat);
-    fprintf(fic,"%3d",p_fSt->st.waiterStat);
-    fprintf(fic,"%3d",p_fSt->st.receptionistStat);
-    fprintf(fic," ");
-    int g;
-    for(g=0; g < p_fSt->nGroups; g++) {
-        fprintf(fic,"%4d",p_fSt->st.groupStat[g]);
+        pushState(&logConf->ring, p_fSt, &ev);
     }
+    else if ((logConf == NULL) || (logConf->mode != LOGNONE)) {
+        if (logFd == -1) {
+            openLogSession(nFic, NULL, -1);
+        }
+        char *buf = lineBuffer(p_fSt->nGroups);
 
-    fprintf(fic,"%5d",p_fSt->groupsWaiting);
+        writeLog(logFd, buf, formatRecord(buf, p_fSt, logFormat, logTables, &logGroups));
+    }
+    if (serialize) {
+        unlockLog(logConf);
+    }
+}
 
-    for(g=0; g < p_fSt->nGroups; g++) {
-        if(p_fSt->assignedTable[g]!=-1)
-            fprintf(fic,"%4d",p_fSt->assignedTable[g]);
-        else {
-            fprintf(fic,"%4s",".");
+/**
+ *  \brief Size of the log ring slots.
+ *
+ *  \param size number of slots
+ *  \param nGroups number of groups in each snapshot
+ *
+ *  \return number of bytes required by the slots of the log ring
+ */
+unsigned long logRingBytes (unsigned int size, int nGroups)
+{
+    return (unsigned long) size * ((sizeof (unsigned int) + sizeof (LOG_EVENT) + RECSIZE(nGroups) + 3) & ~3u);
+}
+
+/**
+ *  \brief Log ring initialization.
+ *
+ *  The log configuration is set to LOGRING mode and all slots are marked as free.
+ *
+ *  \param conf pointer to the shared log configuration
+ *  \param slots location of the slots in shared memory (<tt>logRingBytes(size, nGroups)</tt> bytes)
+ *  \param size number of slots
+ *  \param nGroups number of groups in each snapshot
+ */
+void initLogRing (LOG_CONF *conf, void *slots, unsigned int size, int nGroups)
+{
+    LOG_RING *ring = &conf->ring;
+    unsigned int s;
+
+    conf->mode = LOGRING;
+    ring->size = size;
+    ring->slotSize = (unsigned int) (logRingBytes (size, nGroups) / size);
+    ring->slotsOff = (unsigned long) ((char *) slots - (char *) ring);
+    ring->nGroups = nGroups;
+    ring->head = ring->tail = ring->done = 0;
+    conf->start = monotonicNow();
+    for (s = 0; s < size; s++) {
+        *ringSlot (ring, s) = s;
+    }
+}
+
+/**
+ *  \brief Size of the published state snapshot.
+ *
+ *  \param nGroups number of groups
+ *
+ *  \return number of bytes required by the packed state of the snapshot
+ */
+unsigned long logSnapshotBytes (int nGroups)
+{
+    return RECSIZE(nGroups);
+}
+
+/**
+ *  \brief Published state snapshot initialization.
+ *
+ *  From now on, every saved state is also copied to the snapshot of the log configuration.
+ *
+ *  \param conf pointer to the shared log configuration
+ *  \param data location of the packed state in shared memory (<tt>logSnapshotBytes(nGroups)</tt> bytes)
+ *  \param nGroups number of groups
+ */
+void initLogSnapshot (LOG_CONF *conf, void *data, int nGroups)
+{
+    LOG_SNAPSHOT *snap = &conf->snap;
+
+    snap->version = 0;
+    snap->nGroups = nGroups;
+    snap->states = 0;
+    snap->coalesced = 0;
+    memset (data, 0, RECSIZE(nGroups));
+    snap->dataOff = (unsigned long) ((char *) data - (char *) snap);
+}
+
+/**
+ *  \brief Sampling the published state snapshot.
+ *
+ *  The snapshot is copied without taking any lock: the copy is retried until no state was saved while it was
+ *  being taken, so that the sample is a state that was actually saved.
+ *
+ *  \param conf pointer to the shared log configuration
+ *  \param p_fSt pointer to the location where the sampled state is stored (allocated by <tt>newLogState</tt> for
+ *         the number of groups of the snapshot)
+ *
+ *  \return number of states saved up to the sampled one (0 if states are not published)
+ */
+unsigned long sampleState (LOG_CONF *conf, FULL_STAT *p_fSt)
+{
+    LOG_SNAPSHOT *snap = snapshotOf(conf);
+    static unsigned char *rec = NULL;                                             /* copy of the packed state */
+    static size_t recSize = 0;
+    unsigned int first, last;                                           /* versions before and after the copy */
+    unsigned long states;
+
+    if (snap == NULL) {
+        return 0;
+    }
+    if (recSize < RECSIZE(snap->nGroups)) {
+        free (rec);
+        recSize = RECSIZE(snap->nGroups);
+        if ((rec = malloc (recSize)) == NULL) {
+            perror ("error on allocating the state sample");
+            exit (EXIT_FAILURE);
+        }
+    }
+    for (;;) {
+        first = __atomic_load_n (&snap->version, __ATOMIC_ACQUIRE);
+        if ((first & 1) == 0) {
+            memcpy (rec, (unsigned char *) snap + snap->dataOff, RECSIZE(snap->nGroups));
+            states = snap->states;
+            __atomic_thread_fence (__ATOMIC_ACQUIRE);
+            last = __atomic_load_n (&snap->version, __ATOMIC_RELAXED);
+            if (first == last) {
+                break;
+            }
         }
+        sched_yield ();
+    }
+    p_fSt->nGroups = snap->nGroups;
+    unpackState (p_fSt, rec, &logGroups);
+    return states;
+}
+
+/**
+ *  \brief Life cycle of the log drainer.
+ *
+ *  The snapshots queued in the log ring are formatted (as text lines or trace records, according to the
+ *  log configuration), in sequence order, and appended to the logging file in large batches. The function
+ *  returns when the ring is empty and <tt>stopLogDrainer</tt> was called.
+ *  If <tt>nFic</tt> is a null pointer or a null string, the lines are written to stdout.
+ *
+ *  \param nFic name of the logging file
+ *  \param conf pointer to the shared log configuration
+ */
+void drainLog (char nFic[], LOG_CONF *conf)
+{
+    LOG_RING *ring = &conf->ring;
+    FULL_STAT *p_fSt;                                                               /* unpacked snapshot */
+    GROUP_ARRAYS groups;                                                /* location of the snapshot group arrays */
+    char *buf;                                                                      /* batch of formatted lines */
+    int fd;                                                                             /* logging file descriptor */
+    size_t bufSize = DRAINBUFSIZE;                                                                /* batch size */
+    size_t len = 0;
+    bool structured = (conf->format == LOGJSON) || (conf->format == LOGCSV);        /* events of changed fields */
+    size_t maxSize = structured ? EVENTSIZE(ring->nGroups) : LINESIZE(ring->nGroups);   /* size of a record */
+    LOG_EVENT ev;                                                           /* entity and time of the snapshot */
+    int *vals = NULL, *prev = NULL;                                  /* fields of the snapshot and previous one */
+    bool first = true;                                                                  /* no previous snapshot */
+    unsigned int pos, *slot;
+
+    if (bufSize < 2 * maxSize) {
+        bufSize = 2 * maxSize;
+    }
+    if (structured && (((vals = malloc (NFIELDS(ring->nGroups) * sizeof (int))) == NULL) ||
+                       ((prev = malloc (NFIELDS(ring->nGroups) * sizeof (int))) == NULL))) {
+        perror ("error on allocating the log drainer fields");
+        exit (EXIT_FAILURE);
+    }
+    if ((buf = malloc (bufSize)) == NULL) {
+        perror ("error on allocating the log drainer buffer");
+        exit (EXIT_FAILURE);
     }
+    fd = openLogFd (nFic);
+    p_fSt = allocState (ring->nGroups, &groups);
 
+    pos = ring->tail;
+    for (;;) {
+        slot = ringSlot (ring, pos);
+        if (__atomic_load_n (slot, __ATOMIC_ACQUIRE) == pos + 1) {
+            memcpy (&ev, slot + 1, sizeof (LOG_EVENT));
+            unpackState (p_fSt, (unsigned char *) (slot + 1) + sizeof (LOG_EVENT), &groups);
+            if (structured) {
+                int *swap = prev;
 
-    fprintf(fic,"\n");
+                fieldValues (vals, p_fSt, &groups);
+                len += formatEvent (buf + len, conf->format, pos, &ev, vals, first ? NULL : prev, ring->nGroups);
+                prev = vals;
+                vals = swap;
+                first = false;
+            }
+            else len += formatRecord (buf + len, p_fSt, conf->format, conf->nTables, &groups);
+            __atomic_store_n (slot, pos + ring->size, __ATOMIC_RELEASE);
+            pos += 1;
+            __atomic_store_n (&ring->tail, pos, __ATOMIC_RELAXED);
+            if (len > bufSize - maxSize) {
+                writeLog (fd, buf, len);
+                len = 0;
+            }
+        }
+        else {
+            if (len > 0) {
+                writeLog (fd, buf, len);
+                len = 0;
+            }
+            if (__atomic_load_n (&ring->done, __ATOMIC_ACQUIRE)) {
+                if (__atomic_load_n (slot, __ATOMIC_ACQUIRE) != pos + 1)
+                    break;
+            }
+            else usleep (DRAINPERIOD);
+        }
+    }
 
-    closeLog(fic);
+    closeLogFd (fd);
+    free (p_fSt);
+    free (buf);
+    free (vals);
+    free (prev);
 }
 
+/**
+ *  \brief Signalling the log drainer that all entities have terminated.
+ *
+ *  \param conf pointer to the shared log configuration
+ */
+void stopLogDrainer (LOG_CONF *conf)
+{
+    __atomic_store_n (&conf->ring.done, 1, __ATOMIC_RELEASE);
+}
@@ -7,7 +7,14 @@
  *
  *  Defined operations:
  *     \li file initialization
- *     \li writing the present full state as a single line at the end of the file.
+ *     \li opening and closing of a log session
+ *     \li writing the present full state as a single line at the end of the file
+ *     \li queueing the present full state in the log ring and draining it into the file
+ *     \li writing and reading the binary trace format
+ *     \li writing the structured event formats (JSON lines and CSV)
+ *     \li numbering the entity that saves its state
+ *     \li publishing the last saved state and sampling it without locks
+ *     \li allocation of full states for any number of groups.
  *
  *  \author Nuno Lau - December 2023
  */
@@ -15,8 +22,25 @@
 #ifndef LOGGING_H_
 #define LOGGING_H_
 
+#include <stdio.h>
+#include <stdbool.h>
+
 #include "probDataStruct.h"
 
+/**
+ *  \brief Allocation of a full state for a given number of groups.
+ *
+ *  The group arrays follow the allocated full state, so that any number of groups is supported; from now on, the
+ *  group arrays of the saved, read and drained full states are located as in the allocated one.
+ *  The full state is released with <tt>free</tt>.
+ *
+ *  \param nGroups number of groups
+ *  \param p_groups pointer to the location where the location of the group arrays is stored (may be NULL)
+ *
+ *  \return pointer to the allocated full state
+ */
+extern FULL_STAT *newLogState (int nGroups, GROUP_ARRAYS *p_groups);
+
 /**
  *  \brief File initialization.
  *
@@ -31,14 +55,180 @@
  */
 extern void createLog (char nFic[], FULL_STAT *p_fSt);
 
+/**
+ *  \brief Structured event file initialization.
+ *
+ *  The function creates the logging file and, for the CSV format, writes the header row
+ *  <tt>seq,time_ns,entity,id,field,value</tt>; JSON lines files have no header.
+ *  The events are written by the log drainer: a JSON line per event, with its sequence number, time, entity and
+ *  changed fields, or a CSV row per changed field of an event (unassigned tables are null or empty).
+ *  If <tt>nFic</tt> is a null pointer or a null string, stdout is used.
+ *
+ *  \param nFic name of the logging file
+ *  \param format log format (LOGJSON or LOGCSV)
+ */
+extern void createEventLog (char nFic[], int format);
+
+/**
+ *  \brief Numbering the entity of the calling thread, so that the events it saves are identified.
+ *
+ *  Threads that are not numbered are identified as the generator.
+ *
+ *  \param conf pointer to the shared log configuration
+ *  \param kind kind of entity (MEMBERGROUP, MEMBERWAITER, MEMBERCHEF or MEMBERRECEPTIONIST)
+ *  \param id number of the entity among those of its kind (-1 for the next number of the kind)
+ */
+extern void logEntity (LOG_CONF *conf, int kind, int id);
+
+/**
+ *  \brief Binary trace file initialization.
+ *
+ *  The function creates the logging file and writes the binary trace header, that consists of
+ *       \li the identification "RSTT"
+ *       \li the number of groups (16 bits, little endian)
+ *       \li the number of tables (16 bits, little endian).
+ *
+ *  If <tt>nFic</tt> is a null pointer or a null string, stdout is used.
+ *
+ *  \param nFic name of the logging file
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ *  \param nTables number of tables
+ */
+extern void createTrace (char nFic[], FULL_STAT *p_fSt, int nTables);
+
+/**
+ *  \brief Reading the header of a binary trace file.
+ *
+ *  \param fic binary trace file
+ *  \param p_nGroups pointer to the location where the number of groups is stored
+ *  \param p_nTables pointer to the location where the number of tables is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when the file is not a binary trace
+ */
+extern int readTraceHeader (FILE *fic, int *p_nGroups, int *p_nTables);
+
+/**
+ *  \brief Reading the next record of a binary trace file.
+ *
+ *  \param fic binary trace file, positioned after the header
+ *  \param p_fSt pointer to the location where the state is stored (allocated by <tt>newLogState</tt>)
+ *  \param nTables number of tables
+ *
+ *  \return \c true, if a record was read
+ *  \return \c false, at the end of the file
+ */
+extern bool readTraceState (FILE *fic, FULL_STAT *p_fSt, int nTables);
+
+/**
+ *  \brief Log session opening.
+ *
+ *  The function opens the logging file once, in append mode, so that the following <tt>saveState</tt> calls
+ *  do not have to open and close it.
+ *  If <tt>nFic</tt> is a null pointer or a null string, stdout is used.
+ *  If the log configuration selects the log ring, no file is opened: snapshots are queued in the ring.
+ *
+ *  \param nFic name of the logging file
+ *  \param conf pointer to the shared log configuration (NULL to write lines directly)
+ *  \param semgid semaphore set access identifier (the log lock is one of its semaphores, -1 if there is none)
+ */
+extern void openLogSession (char nFic[], LOG_CONF *conf, int semgid);
+
+/**
+ *  \brief Log session closing.
+ *
+ *  The function closes the logging file opened by <tt>openLogSession</tt>.
+ *  Sessions may be nested (threads of the same process share the logging file): the file is only closed when
+ *  the last open session is closed.
+ */
+extern void closeLogSession (void);
+
 /**
  *  \brief write a log record (complete line) that includes the state of all entities and more info.
  *
  *  If <tt>nFic</tt> is a null pointer or a null string, the lines are written to stdout
+ *  If the session uses the binary format, a trace record is written instead of the line.
+ *  If states are published, the state is also copied to the snapshot of the log configuration; if the session
+ *  uses no log (LOGNONE), nothing else is done.
  *
  *  \param nFic name of the logging file
  *  \param p_fSt pointer to the location where the full internal state of the problem is stored
  */
 extern void saveState (char nFic[], FULL_STAT *p_fSt);
 
+/**
+ *  \brief Size of the log ring slots.
+ *
+ *  \param size number of slots
+ *  \param nGroups number of groups in each snapshot
+ *
+ *  \return number of bytes required by the slots of the log ring
+ */
+extern unsigned long logRingBytes (unsigned int size, int nGroups);
+
+/**
+ *  \brief Log ring initialization.
+ *
+ *  The log configuration is set to LOGRING mode and all slots are marked as free.
+ *
+ *  \param conf pointer to the shared log configuration
+ *  \param slots location of the slots in shared memory (<tt>logRingBytes(size, nGroups)</tt> bytes)
+ *  \param size number of slots
+ *  \param nGroups number of groups in each snapshot
+ */
+extern void initLogRing (LOG_CONF *conf, void *slots, unsigned int size, int nGroups);
+
+/**
+ *  \brief Size of the published state snapshot.
+ *
+ *  \param nGroups number of groups
+ *
+ *  \return number of bytes required by the packed state of the snapshot
+ */
+extern unsigned long logSnapshotBytes (int nGroups);
+
+/**
+ *  \brief Published state snapshot initialization.
+ *
+ *  From now on, every saved state is also copied to the snapshot of the log configuration.
+ *
+ *  \param conf pointer to the shared log configuration
+ *  \param data location of the packed state in shared memory (<tt>logSnapshotBytes(nGroups)</tt> bytes)
+ *  \param nGroups number of groups
+ */
+extern void initLogSnapshot (LOG_CONF *conf, void *data, int nGroups);
+
+/**
+ *  \brief Sampling the published state snapshot.
+ *
+ *  The snapshot is copied without taking any lock: the copy is retried until no state was saved while it was
+ *  being taken, so that the sample is a state that was actually saved.
+ *
+ *  \param conf pointer to the shared log configuration
+ *  \param p_fSt pointer to the location where the sampled state is stored (allocated by <tt>newLogState</tt> for
+ *         the number of groups of the snapshot)
+ *
+ *  \return number of states saved up to the sampled one (0 if states are not published)
+ */
+extern unsigned long sampleState (LOG_CONF *conf, FULL_STAT *p_fSt);
+
+/**
+ *  \brief Life cycle of the log drainer.
+ *
+ *  The snapshots queued in the log ring are formatted, in sequence order, and appended to the logging file
+ *  in large batches. The function returns when the ring is empty and <tt>stopLogDrainer</tt> was called.
+ *  If <tt>nFic</tt> is a null pointer or a null string, the lines are written to stdout
+ *
+ *  \param nFic name of the logging file
+ *  \param conf pointer to the shared log configuration
+ */
+extern void drainLog (char nFic[], LOG_CONF *conf);
+
+/**
+ *  \brief Signalling the log drainer that all entities have terminated.
+ *
+ *  \param conf pointer to the shared log configuration
+ */
+extern void stopLogDrainer (LOG_CONF *conf);
+
 #endif /* LOGGING_H_ */
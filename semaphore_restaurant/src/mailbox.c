@@ -0,0 +1,114 @@
+/**
+ *  \file mailbox.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Request mailboxes.
+ *
+ *  Operations defined on a request mailbox (carried out within the critical region that protects it):
+ *     \li initialization
+ *     \li posting a request
+ *     \li taking the oldest request
+ *     \li counting the requests in the mailbox.
+ */
+
+#include <assert.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "mailbox.h"
+
+/**
+ *  \brief Mailbox initialization.
+ *
+ *  \param box pointer to the mailbox
+ *  \param slot pointer to the request slot of the full state
+ *  \param size number of slots (1 .. <tt>MAXMAILBOX</tt>)
+ */
+void initMailbox (MAILBOX *box, request *slot, unsigned int size)
+{
+    assert ((size >= 1) && (size <= MAXMAILBOX));
+    box->head = 0;
+    box->count = 0;
+    box->size = size;
+    slot->reqType = -1;
+    slot->reqGroup = -1;
+}
+
+/**
+ *  \brief Posting a request.
+ *
+ *  With a single slot, the request is stored in the request slot of the full state, as expected by the
+ *  reference binaries.
+ *
+ *  \param box pointer to the mailbox
+ *  \param slot pointer to the request slot of the full state
+ *  \param reqType request id
+ *  \param reqGroup group that issues the request
+ */
+void postRequest (MAILBOX *box, request *slot, int reqType, int reqGroup)
+{
+    request *req;
+
+    if (box->size <= 1) {
+        slot->reqGroup = reqGroup;
+        slot->reqType = reqType;
+        return;
+    }
+    assert (box->count < box->size);
+    req = &box->slot[(box->head + box->count) % box->size];
+    req->reqType = reqType;
+    req->reqGroup = reqGroup;
+    if (box->count == 0) {                                                  /* the oldest request is shown */
+        *slot = *req;
+    }
+    box->count++;
+}
+
+/**
+ *  \brief Taking the oldest request.
+ *
+ *  \param box pointer to the mailbox
+ *  \param slot pointer to the request slot of the full state
+ *
+ *  \return oldest request in the mailbox
+ */
+request takeRequest (MAILBOX *box, request *slot)
+{
+    request ret;
+
+    if (box->size <= 1) {
+        ret = *slot;
+        slot->reqType = -1;
+        slot->reqGroup = -1;
+        return ret;
+    }
+    assert (box->count > 0);
+    ret = box->slot[box->head];
+    box->head = (box->head + 1) % box->size;
+    box->count--;
+    if (box->count > 0) {                                                   /* the oldest request is shown */
+        *slot = box->slot[box->head];
+    }
+    else {
+        slot->reqType = -1;
+        slot->reqGroup = -1;
+    }
+    return ret;
+}
+
+/**
+ *  \brief Counting the requests in the mailbox.
+ *
+ *  \param box pointer to the mailbox
+ *  \param slot pointer to the request slot of the full state
+ *
+ *  \return number of requests in the mailbox
+ */
+unsigned int pendingRequests (MAILBOX *box, request *slot)
+{
+    if (box->size <= 1) {
+        return (slot->reqType != -1) ? 1 : 0;
+    }
+    return box->count;
+}
@@ -0,0 +1,62 @@
+/**
+ *  \file mailbox.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Request mailboxes.
+ *
+ *  Operations defined on a request mailbox (carried out within the critical region that protects it):
+ *     \li initialization
+ *     \li posting a request
+ *     \li taking the oldest request
+ *     \li counting the requests in the mailbox.
+ *
+ *  The number of vacant and used slots is kept by the semaphores of the producers and of the consumer of the
+ *  mailbox, so that a request is only posted when there is a vacant slot and only taken when there is one.
+ */
+
+#ifndef MAILBOX_H_
+#define MAILBOX_H_
+
+#include "probDataStruct.h"
+
+/**
+ *  \brief Mailbox initialization.
+ *
+ *  \param box pointer to the mailbox
+ *  \param slot pointer to the request slot of the full state
+ *  \param size number of slots (1 .. <tt>MAXMAILBOX</tt>)
+ */
+extern void initMailbox (MAILBOX *box, request *slot, unsigned int size);
+
+/**
+ *  \brief Posting a request.
+ *
+ *  \param box pointer to the mailbox
+ *  \param slot pointer to the request slot of the full state
+ *  \param reqType request id
+ *  \param reqGroup group that issues the request
+ */
+extern void postRequest (MAILBOX *box, request *slot, int reqType, int reqGroup);
+
+/**
+ *  \brief Taking the oldest request.
+ *
+ *  \param box pointer to the mailbox
+ *  \param slot pointer to the request slot of the full state
+ *
+ *  \return oldest request in the mailbox
+ */
+extern request takeRequest (MAILBOX *box, request *slot);
+
+/**
+ *  \brief Counting the requests in the mailbox.
+ *
+ *  \param box pointer to the mailbox
+ *  \param slot pointer to the request slot of the full state
+ *
+ *  \return number of requests in the mailbox
+ */
+extern unsigned int pendingRequests (MAILBOX *box, request *slot);
+
+#endif /* MAILBOX_H_ */
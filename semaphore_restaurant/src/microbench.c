@@ -0,0 +1,274 @@
+/**
+ *  \file microbench.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  Microbenchmarks of the semaphore backend and of the state saves.
+ *
+ *  The program is linked with one of the semaphore backends (<tt>microbench_sysv</tt> and
+ *  <tt>microbench_posix</tt>) and measures the time of:
+ *    \li a <em>down</em> and an <em>up</em> of a semaphore in the green state (no process is blocked)
+ *    \li a <em>down</em> and an <em>up</em> of two semaphores in single operations (<tt>semOpMulti</tt>)
+ *    \li a round trip between two processes, each one waking the other up through a semaphore of its own
+ *    \li a state save (<tt>saveState</tt>) of a full state of <tt>MAXGROUPS</tt> groups in each log mode and format
+ *        of the generator: text and binary log files written directly, text log file written by a log drainer
+ *        process through the ring, and no log (only the snapshot published for the monitor).
+ *
+ *  Every result is printed as a line of comma separated values (suite, test, variant, value and unit), the format
+ *  of the results file of <tt>bench.sh</tt>.
+ *
+ *  Options:
+ *    \li <tt>-n ops</tt> number of operations of the semaphore measures (1000000 by default; a tenth of them for the
+ *        round trips and a fifth for the state saves)
+ *    \li <tt>-b name</tt> name of the semaphore backend, printed as the variant of the results.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "logging.h"
+#include "semaphore.h"
+
+/** \brief default number of operations of the semaphore measures */
+#define  BENCHOPS        1000000UL
+
+/** \brief number of slots of the log ring */
+#define  BENCHRING       1024
+
+/** \brief semaphore the parent process is woken up through */
+#define  PING            1
+
+/** \brief semaphore the child process is woken up through */
+#define  PONG            2
+
+/**
+ *  \brief Definition of the <em>saved state</em> data type: the log configuration and the full state saved, in
+ *  shared memory, so that the log drainer process reads the ring.
+ */
+typedef struct {
+    /** \brief log configuration */
+    LOG_CONF log;
+    /** \brief full state */
+    FULL_STAT fSt;
+} SAVED;
+
+/** \brief name of the backend (variant of the results) */
+static char *backend = "-";
+
+/* internal functions */
+
+static double secondsNow (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void printResult (char *test, double value, char *unit)
+{
+    printf ("micro,%s,%s,%.1f,%s\n", test, backend, value, unit);
+    fflush (stdout);
+}
+
+static void semaphoreOps (int semgid, unsigned long ops)
+{
+    SEM_OP downs[] = {{PING, -1}, {PONG, -1}};
+    SEM_OP ups[] = {{PING, 1}, {PONG, 1}};
+    unsigned long n;
+    double start;
+
+    if ((semUp (semgid, PING) == -1) || (semUp (semgid, PONG) == -1)) {                 /* both semaphores green */
+        perror ("error on the up operation for semaphore access");
+        exit (EXIT_FAILURE);
+    }
+    start = secondsNow ();
+    for (n = 0; n < ops; n++) {
+        if ((semDown (semgid, PING) == -1) || (semUp (semgid, PING) == -1)) {
+            perror ("error on the down and up operations for semaphore access");
+            exit (EXIT_FAILURE);
+        }
+    }
+    printResult ("sem down up", (secondsNow () - start) * 1e9 / ops, "ns");
+
+    start = secondsNow ();
+    for (n = 0; n < ops; n++) {
+        if ((semOpMulti (semgid, downs, 2) == -1) || (semOpMulti (semgid, ups, 2) == -1)) {
+            perror ("error on the multiple operations for semaphore access");
+            exit (EXIT_FAILURE);
+        }
+    }
+    printResult ("sem multi op", (secondsNow () - start) * 1e9 / ops, "ns");
+    if (semOpMulti (semgid, downs, 2) == -1) {                                   /* both semaphores red again */
+        perror ("error on the down operation for semaphore access");
+        exit (EXIT_FAILURE);
+    }
+}
+
+static void roundTrips (int semgid, unsigned long trips)
+{
+    unsigned long n;
+    double start;
+    pid_t pid;
+
+    if ((pid = fork ()) < 0) {
+        perror ("error on the fork operation for the round trips");
+        exit (EXIT_FAILURE);
+    }
+    if (pid == 0) {                                       /* the child answers every wake up of the parent */
+        for (n = 0; n < trips; n++) {
+            if ((semDown (semgid, PONG) == -1) || (semUp (semgid, PING) == -1)) {
+                perror ("error on the round trip");
+                exit (EXIT_FAILURE);
+            }
+        }
+        exit (EXIT_SUCCESS);
+    }
+    start = secondsNow ();
+    for (n = 0; n < trips; n++) {
+        if ((semUp (semgid, PONG) == -1) || (semDown (semgid, PING) == -1)) {
+            perror ("error on the round trip");
+            exit (EXIT_FAILURE);
+        }
+    }
+    printResult ("sem round trip", (secondsNow () - start) * 1e9 / trips, "ns");
+    waitpid (pid, NULL, 0);
+}
+
+static void stateSaves (SAVED *sv, void *slots, void *snapData, char nFic[], char *test, int mode, int format,
+                        unsigned long saves)
+{
+    unsigned long n;
+    double start;
+    pid_t pid = -1;
+    int g;
+
+    memset (sv, 0, sizeof (SAVED));
+    sv->fSt.nGroups = MAXGROUPS;
+    for (g = 0; g < MAXGROUPS; g++) {
+        sv->fSt.st.groupStat[g] = GOTOREST;
+        sv->fSt.assignedTable[g] = -1;
+    }
+    sv->log.mode = LOGDIRECT;
+    sv->log.format = format;
+    sv->log.nTables = NUMTABLES;
+    sv->log.groups.groupStat = offsetof (FULL_STAT, st.groupStat);
+    sv->log.groups.startTime = offsetof (FULL_STAT, startTime);
+    sv->log.groups.eatTime = offsetof (FULL_STAT, eatTime);
+    sv->log.groups.assignedTable = offsetof (FULL_STAT, assignedTable);
+    if (mode == LOGRING) {
+        initLogRing (&sv->log, slots, BENCHRING, MAXGROUPS);
+    }
+    initLogSnapshot (&sv->log, snapData, MAXGROUPS);
+    if (mode == LOGNONE) {
+        sv->log.mode = LOGNONE;
+    }
+    else if (format == LOGBINARY) {
+        createTrace (nFic, &sv->fSt, NUMTABLES);
+    }
+    else createLog (nFic, &sv->fSt);
+    if (mode == LOGRING) {
+        if ((pid = fork ()) < 0) {
+            perror ("error on the fork operation for the log drainer");
+            exit (EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            drainLog (nFic, &sv->log);
+            exit (EXIT_SUCCESS);
+        }
+    }
+
+    openLogSession (nFic, &sv->log, -1);
+    start = secondsNow ();
+    for (n = 0; n < saves; n++) {
+        sv->fSt.st.groupStat[n % MAXGROUPS] = GOTOREST + n % LEAVING;           /* a field changes every save */
+        saveState (nFic, &sv->fSt);
+    }
+    if (mode == LOGRING) {                                     /* the drainer writes the remaining snapshots */
+        stopLogDrainer (&sv->log);
+        waitpid (pid, NULL, 0);
+    }
+    printResult (test, (secondsNow () - start) * 1e9 / saves, "ns");
+    closeLogSession ();
+}
+
+/**
+ *  \brief Main program.
+ *
+ *  Its role is to measure the time of the semaphore operations and of the state saves and to print it.
+ */
+int main (int argc, char *argv[])
+{
+    unsigned long ops = BENCHOPS;                                                /* number of semaphore operations */
+    char nFic[] = "/tmp/microbenchXXXXXX";                                         /* name of the logging file */
+    unsigned long bytes;                                                    /* size of the saved state region */
+    char *region;                                             /* saved state, ring slots and published snapshot */
+    char *slots, *snapData;                                      /* location of the ring slots and the snapshot */
+    int semgid, fd, opt;
+
+    while ((opt = getopt (argc, argv, "n:b:")) != -1) {
+        switch (opt) {
+            case 'n':
+                ops = strtoul (optarg, NULL, 0);
+                break;
+            case 'b':
+                backend = optarg;
+                break;
+            default:
+                fprintf (stderr, "Usage: %s [-n ops] [-b name]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (ops < 10) {
+        fprintf (stderr, "Usage: %s [-n ops] [-b name]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* semaphore measures: a set of two semaphores of a key of its own */
+    if ((semgid = semCreate ((int) getpid (), PONG)) == -1) {
+        perror ("error on creating the semaphore set");
+        return EXIT_FAILURE;
+    }
+    if (semSignal (semgid) == -1) {
+        perror ("error on signaling start of operations");
+        return EXIT_FAILURE;
+    }
+    semaphoreOps (semgid, ops);
+    roundTrips (semgid, ops / 10);
+    if (semDestroy (semgid) == -1) {
+        perror ("error on destructing the semaphore set");
+        return EXIT_FAILURE;
+    }
+
+    /* state save measures */
+    if ((fd = mkstemp (nFic)) == -1) {
+        perror ("error on creating the logging file");
+        return EXIT_FAILURE;
+    }
+    close (fd);
+    bytes = sizeof (SAVED) + CACHELINES (logRingBytes (BENCHRING, MAXGROUPS)) + logSnapshotBytes (MAXGROUPS);
+    if ((region = mmap (NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED) {
+        perror ("error on mapping the saved state");
+        return EXIT_FAILURE;
+    }
+    slots = region + sizeof (SAVED);
+    snapData = slots + CACHELINES (logRingBytes (BENCHRING, MAXGROUPS));
+    stateSaves ((SAVED *) region, slots, snapData, nFic, "saveState text", LOGDIRECT, LOGTEXT, ops / 5);
+    stateSaves ((SAVED *) region, slots, snapData, nFic, "saveState binary", LOGDIRECT, LOGBINARY, ops / 5);
+    stateSaves ((SAVED *) region, slots, snapData, nFic, "saveState ring", LOGRING, LOGTEXT, ops / 5);
+    stateSaves ((SAVED *) region, slots, snapData, nFic, "saveState none", LOGNONE, LOGTEXT, ops / 5);
+    munmap (region, bytes);
+    unlink (nFic);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+/**
+ *  \file monitor.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  Live monitor of a running simulation.
+ *
+ *  The shared region of the simulation is attached and the entity states, the occupancy of the tables and the
+ *  depth of the queues are redrawn at a fixed rate, until the simulation terminates. The state is sampled from the
+ *  snapshot published by the entities, under its sequence lock, so that the monitor never takes a lock of the
+ *  simulation nor writes to the shared region; the request mailboxes and the order queue are shown as their
+ *  counters stand. The log may be turned off (option <tt>-n</tt> of the generator) while the simulation is watched.
+ *
+ *  Options:
+ *    \li <tt>-k key</tt> access key of the shared region, instead of the key generated from the current directory
+ *    \li <tt>-i ms</tt> refresh period, in milliseconds (200 by default)
+ *    \li <tt>-o</tt> the state is printed once, instead of being redrawn.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "sharedDataSync.h"
+#include "sharedMemory.h"
+#include "logging.h"
+
+/** \brief default refresh period (in ms) */
+#define  REFRESHPERIOD   200
+
+/** \brief largest population whose groups are shown one by one */
+#define  MONITORGROUPS    64
+
+/** \brief largest number of tables shown one by one */
+#define  MONITORTABLES    32
+
+/** \brief names of the group states */
+static const char *groupName[LEAVING + 1] = { "?", "GOTOREST", "ATRECEPTION", "FOOD_REQUEST", "WAIT_FOR_FOOD",
+                                              "EAT", "CHECKOUT", "LEAVING" };
+
+/** \brief names of the chef states */
+static const char *chefName[REST + 1] = { "WAIT_FOR_ORDER", "COOK", "REST" };
+
+/** \brief names of the waiter states */
+static const char *waiterName[TAKE_TO_TABLE + 1] = { "WAIT_FOR_REQUEST", "INFORM_CHEF", "TAKE_TO_TABLE" };
+
+/** \brief names of the receptionist states */
+static const char *receptionistName[RECVPAY + 1] = { "WAIT_FOR_REQUEST", "ASSIGNTABLE", "RECVPAY" };
+
+/** \brief name of state s of an array of n names */
+#define  NAMEOF(names, n, s)   ((((unsigned int) (s)) < (n)) ? (names)[s] : "?")
+
+/* internal functions */
+
+static double secondsNow (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool terminated (int shmid)
+{
+    struct shmid_ds ds;
+
+    return (shmctl (shmid, IPC_STAT, &ds) == -1) || ((ds.shm_perm.mode & SHM_DEST) != 0);
+}
+
+static void printQueue (char name[], MAILBOX *box)
+{
+    if (box->size > 1) {
+        printf ("   %s %u/%u", name, __atomic_load_n (&box->count, __ATOMIC_RELAXED), box->size);
+    }
+}
+
+static void drawState (SHARED_DATA *sh, FULL_STAT *p_fSt, GROUP_ARRAYS *groups, int *seated,
+                       unsigned long states, double rate)
+{
+    unsigned int count[LEAVING + 1] = { 0 };                                     /* number of groups per state */
+    int n = p_fSt->nGroups;
+    int g, t, s;
+
+    printf ("Restaurant - %d groups, %d tables - %lu states saved (%.0f states/s)\n\n", n, sh->nTables, states,
+            rate);
+    printf (" chef %s   waiter %s   receptionist %s\n\n", NAMEOF(chefName, REST + 1, p_fSt->st.chefStat),
+            NAMEOF(waiterName, TAKE_TO_TABLE + 1, p_fSt->st.waiterStat),
+            NAMEOF(receptionistName, RECVPAY + 1, p_fSt->st.receptionistStat));
+
+    for (t = 0; t < sh->nTables; t++) {
+        seated[t] = -1;
+    }
+    for (g = 0; g < n; g++) {
+        s = GROUPARRAY(p_fSt, groups->groupStat, unsigned int)[g];
+        count[((unsigned int) s <= LEAVING) ? s : 0] += 1;
+        t = GROUPARRAY(p_fSt, groups->assignedTable, int)[g];
+        if ((t >= 0) && (t < sh->nTables)) {
+            seated[t] = g;
+        }
+    }
+    printf (" groups");
+    for (s = GOTOREST; s <= LEAVING; s++) {
+        printf ("   %s %u", groupName[s], count[s]);
+    }
+    printf ("\n");
+    if (n <= MONITORGROUPS) {
+        for (g = 0; g < n; g++) {
+            s = GROUPARRAY(p_fSt, groups->groupStat, unsigned int)[g];
+            printf ("%s G%02d %-13s", (g % 6 == 0) ? "\n" : "", g, NAMEOF(groupName, LEAVING + 1, s));
+        }
+        printf ("\n");
+    }
+
+    t = 0;
+    for (g = 0; g < sh->nTables; g++) {
+        t += (seated[g] != -1);
+    }
+    printf ("\n tables   %d occupied, %d vacant\n", t, sh->nTables - t);
+    if (sh->nTables <= MONITORTABLES) {
+        for (t = 0; t < sh->nTables; t++) {
+            if (seated[t] == -1) {
+                printf ("%s T%02d %-18s", (t % 4 == 0) ? "\n" : "", t, "vacant");
+            }
+            else {
+                s = GROUPARRAY(p_fSt, groups->groupStat, unsigned int)[seated[t]];
+                printf ("%s T%02d G%02d %-14s", (t % 4 == 0) ? "\n" : "", t, seated[t],
+                        NAMEOF(groupName, LEAVING + 1, s));
+            }
+        }
+        printf ("\n");
+    }
+
+    printf ("\n queues   waiting for a table %d", p_fSt->groupsWaiting);
+    printQueue ("receptionist mailbox", &sh->receptionistBox);
+    printQueue ("waiter mailbox", &sh->waiterBox);
+    if (sh->queueOrders) {
+        printf ("   food orders %u/%u", __atomic_load_n (&sh->orders.count, __ATOMIC_RELAXED), sh->orders.size);
+    }
+    printf ("\n");
+}
+
+/**
+ *  \brief Main program.
+ *
+ *  Its role is to attach the shared region of a simulation and to redraw its state until it terminates.
+ */
+int main (int argc, char *argv[])
+{
+    SHARED_DATA *sh;                                                           /* pointer to the shared region */
+    FULL_STAT *p_fSt;                                                                         /* sampled state */
+    GROUP_ARRAYS groups;                                                  /* location of the sampled group arrays */
+    int *seated;                                                                /* group seated at each table */
+    int key = IPC_PRIVATE;                                                       /* access key to shared memory */
+    int shmid;                                                                       /* shared memory identifier */
+    int period = REFRESHPERIOD;                                                        /* refresh period (in ms) */
+    bool once = false;                                                        /* the state is printed once */
+    unsigned long states, last = 0;                             /* states saved up to this and the last sample */
+    bool first = true;                                                                /* there is no last sample */
+    double now, before = 0.0;                                             /* times of this and the last sample */
+    int opt;
+
+    while ((opt = getopt (argc, argv, "k:i:o")) != -1) {
+        switch (opt) {
+            case 'k':
+                key = (int) strtol (optarg, NULL, 0);
+                break;
+            case 'i':
+                period = atoi (optarg);
+                break;
+            case 'o':
+                once = true;
+                break;
+            default:
+                fprintf (stderr, "Usage: %s [-k key] [-i ms] [-o]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (period < 1) {
+        fprintf (stderr, "Usage: %s [-k key] [-i ms] [-o]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if ((key == IPC_PRIVATE) && ((key = ftok (".", 'a')) == -1)) {
+        perror ("error on generating the key");
+        return EXIT_FAILURE;
+    }
+
+    if ((shmid = shmemConnect (key)) == -1) {
+        perror ("error on connecting to the shared memory region");
+        return EXIT_FAILURE;
+    }
+    if (shmemAttach (shmid, (void **) &sh) == -1) {
+        perror ("error on mapping the shared region on the process address space");
+        return EXIT_FAILURE;
+    }
+    if (sh->log.snap.dataOff == 0) {
+        fprintf (stderr, "The simulation does not publish its state!\n");
+        return EXIT_FAILURE;
+    }
+    p_fSt = newLogState (sh->log.snap.nGroups, &groups);
+    if ((seated = malloc (sh->nTables * sizeof (int))) == NULL) {
+        perror ("error on allocating the tables");
+        return EXIT_FAILURE;
+    }
+
+    for (;;) {
+        bool done = terminated (shmid);                      /* checked first, the last sample is then final */
+
+        states = sampleState (&sh->log, p_fSt);
+        now = secondsNow ();
+        if (!once) {
+            printf ("\033[H\033[J");                                             /* cursor home, clear screen */
+        }
+        drawState (sh, p_fSt, &groups, seated, states, first ? 0.0 : (states - last) / (now - before));
+        fflush (stdout);
+        if (once || done) {
+            break;
+        }
+        first = false;
+        last = states;
+        before = now;
+        usleep (period * 1000);
+    }
+
+    free (seated);
+    free (p_fSt);
+    if (shmemDettach (sh) == -1) {
+        perror ("error on unmapping the shared region off the process address space");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+/**
+ *  \file notify.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Notification of the requests served by the event-driven staff.
+ *
+ *  Operations defined on a notifier:
+ *     \li creation (with no sources, notifications are disabled)
+ *     \li notifying a source
+ *     \li waiting for any source
+ *     \li destruction.
+ *
+ *  Each source is a non blocking eventfd, registered in the epoll instance with its number as data.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "notify.h"
+
+/**
+ *  \brief Notifier creation.
+ *
+ *  \param nt pointer to the notifier
+ *  \param sources number of sources (0 .. <tt>NOTIFYSOURCES</tt>, 0 when requests are not notified)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int notifyCreate (NOTIFIER *nt, unsigned int sources)
+{
+    struct epoll_event ev;
+    unsigned int s;
+
+    nt->sources = 0;
+    nt->epfd = -1;
+    if (sources > NOTIFYSOURCES) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (sources == 0) {
+        return 0;
+    }
+    if ((nt->epfd = epoll_create1 (0)) == -1) {
+        return -1;
+    }
+    for (s = 0; s < sources; s++) {
+        if ((nt->fd[s] = eventfd (0, EFD_NONBLOCK)) == -1) {
+            notifyDestroy (nt);
+            return -1;
+        }
+        nt->sources = s + 1;
+        ev.events = EPOLLIN;
+        ev.data.u32 = s;
+        if (epoll_ctl (nt->epfd, EPOLL_CTL_ADD, nt->fd[s], &ev) == -1) {
+            notifyDestroy (nt);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ *  \brief Notifying a source.
+ *
+ *  \param nt pointer to the notifier
+ *  \param source source of the request (NOTIFYRECEPTION or NOTIFYKITCHEN)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int notifyPost (NOTIFIER *nt, unsigned int source)
+{
+    uint64_t one = 1;
+
+    if (source >= nt->sources) {                                                 /* requests are not notified */
+        return 0;
+    }
+    while (write (nt->fd[source], &one, sizeof (one)) == -1) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ *  \brief Waiting for any source.
+ *
+ *  \param nt pointer to the notifier
+ *  \param pReady pointer to the location where the ready sources are stored (bit <tt>s</tt> set for source
+ *         <tt>s</tt>)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int notifyWait (NOTIFIER *nt, unsigned int *pReady)
+{
+    struct epoll_event ev[NOTIFYSOURCES];
+    uint64_t count;
+    int n, e;
+
+    while ((n = epoll_wait (nt->epfd, ev, NOTIFYSOURCES, -1)) == -1) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    *pReady = 0;
+    for (e = 0; e < n; e++) {                          /* the counter is reset before the requests are claimed */
+        if ((read (nt->fd[ev[e].data.u32], &count, sizeof (count)) == -1) && (errno != EAGAIN)) {
+            return -1;
+        }
+        *pReady |= 1u << ev[e].data.u32;
+    }
+    return 0;
+}
+
+/**
+ *  \brief Notifier destruction.
+ *
+ *  \param nt pointer to the notifier
+ */
+void notifyDestroy (NOTIFIER *nt)
+{
+    unsigned int s;
+
+    for (s = 0; s < nt->sources; s++) {
+        close (nt->fd[s]);
+    }
+    if (nt->epfd != -1) {
+        close (nt->epfd);
+    }
+    nt->sources = 0;
+    nt->epfd = -1;
+}
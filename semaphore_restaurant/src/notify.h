@@ -0,0 +1,79 @@
+/**
+ *  \file notify.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Notification of the requests served by the event-driven staff.
+ *
+ *  When the receptionist and the waiter are a single entity (<tt>-e</tt>), it cannot block on the semaphores of
+ *  both mailboxes at the same time: the producers post their requests as usual (the semaphores of the consumer
+ *  still count them) and, after leaving the critical region, notify the source of the request through its
+ *  eventfd. The entity waits for any source on an epoll instance and then takes, without blocking, every request
+ *  counted by the semaphores of the ready sources.
+ *
+ *  A notification may be seen after the request it tells of was taken; the entity then just finds no request.
+ *  No request is ever missed: the counter of an eventfd is read before the requests are claimed, so that a request
+ *  posted afterwards makes it readable again.
+ *
+ *  Operations defined on a notifier:
+ *     \li creation (with no sources, notifications are disabled)
+ *     \li notifying a source
+ *     \li waiting for any source
+ *     \li destruction.
+ */
+
+#ifndef NOTIFY_H_
+#define NOTIFY_H_
+
+#include "probDataStruct.h"
+
+/**
+ *  \brief Notifier creation.
+ *
+ *  The descriptors must be created before the entities that use them are generated (threads of the threaded
+ *  engine or processes of the forked engine, which inherit them).
+ *
+ *  \param nt pointer to the notifier
+ *  \param sources number of sources (0 .. <tt>NOTIFYSOURCES</tt>, 0 when requests are not notified)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int notifyCreate (NOTIFIER *nt, unsigned int sources);
+
+/**
+ *  \brief Notifying a source.
+ *
+ *  Nothing is done when requests are not notified.
+ *
+ *  \param nt pointer to the notifier
+ *  \param source source of the request (NOTIFYRECEPTION or NOTIFYKITCHEN)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int notifyPost (NOTIFIER *nt, unsigned int source);
+
+/**
+ *  \brief Waiting for any source.
+ *
+ *  The calling thread blocks until at least one source was notified; the notifications of the ready sources are
+ *  consumed.
+ *
+ *  \param nt pointer to the notifier
+ *  \param pReady pointer to the location where the ready sources are stored (bit <tt>s</tt> set for source
+ *         <tt>s</tt>)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int notifyWait (NOTIFIER *nt, unsigned int *pReady);
+
+/**
+ *  \brief Notifier destruction.
+ *
+ *  \param nt pointer to the notifier
+ */
+extern void notifyDestroy (NOTIFIER *nt);
+
+#endif /* NOTIFY_H_ */
@@ -0,0 +1,117 @@
+/**
+ *  \file placement.c (implementation file)
+ *
+ *  \brief Placement of memory.
+ *
+ *  Operations defined on a range of the process address space (which starts at a page boundary):
+ *     \li setting the NUMA memory policy of its pages (interleaved over the nodes or bound to one node)
+ *     \li faulting its pages in.
+ *
+ *  The memory policy is set with the <tt>mbind</tt> system call (no NUMA library is needed); the pages are faulted
+ *  in with <tt>madvise (MADV_POPULATE_WRITE)</tt> or, on kernels without it, by an atomic update of a word of each
+ *  page that does not change its value.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include "placement.h"
+
+/** \brief maximum number of NUMA nodes of a policy */
+#define  MAXNODES        64
+
+/** \brief list of the online NUMA nodes */
+#define  ONLINENODES     "/sys/devices/system/node/online"
+
+/* internal functions */
+
+static unsigned long onlineNodes (void)
+{
+    FILE *fic;
+    unsigned long mask = 0;
+    int first, last;
+    char sep;
+
+    if ((fic = fopen (ONLINENODES, "r")) == NULL) {
+        return 1UL;                                                                      /* a single node, node 0 */
+    }
+    while (fscanf (fic, "%d", &first) == 1) {
+        last = first;
+        if ((fscanf (fic, "%c", &sep) == 1) && (sep == '-')) {
+            if (fscanf (fic, "%d", &last) != 1) {
+                break;
+            }
+            if (fscanf (fic, "%c", &sep) != 1) {
+                sep = '\n';
+            }
+        }
+        for (; (first <= last) && (first < MAXNODES); first++) {
+            mask |= 1UL << first;
+        }
+        if (sep != ',') {
+            break;
+        }
+    }
+    fclose (fic);
+    return (mask != 0) ? mask : 1UL;
+}
+
+static int prefault (void *add, unsigned long size)
+{
+    long page = sysconf (_SC_PAGESIZE);
+    unsigned long off;
+
+#ifdef MADV_POPULATE_WRITE
+    if (madvise (add, size, MADV_POPULATE_WRITE) == 0) {
+        return 0;
+    }
+    if (errno != EINVAL) {
+        return -1;
+    }
+#endif
+    for (off = 0; off < size; off += page) {                                /* one update of each page */
+        __atomic_fetch_add ((unsigned char *) add + off, 0, __ATOMIC_RELAXED);
+    }
+    return 0;
+}
+
+/* external functions */
+
+/**
+ *  \brief Placing a range of the process address space.
+ *
+ *  The memory policy is set first (SHMINTERLEAVE or SHMBIND), then the pages are faulted in (SHMPREFAULT).
+ *
+ *  \param add start of the range (at a page boundary)
+ *  \param size size of the range (in bytes)
+ *  \param placement combination of SHMPREFAULT with one of SHMINTERLEAVE and SHMBIND (SHMHUGEPAGES is ignored)
+ *  \param node NUMA node the pages are bound to (SHMBIND)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int placeRange (void *add, unsigned long size, unsigned int placement, int node)
+{
+    unsigned long mask;                                                          /* nodes the pages are placed on */
+
+    if (placement & (SHMINTERLEAVE | SHMBIND)) {
+        if ((placement & SHMBIND) && ((node < 0) || (node >= MAXNODES))) {
+            errno = EINVAL;
+            return -1;
+        }
+        mask = (placement & SHMBIND) ? 1UL << node : onlineNodes ();
+        if (syscall (SYS_mbind, add, size, (placement & SHMBIND) ? MPOL_BIND : MPOL_INTERLEAVE, &mask,
+                     MAXNODES + 1, MPOL_MF_MOVE) == -1) {
+            return -1;
+        }
+    }
+    if ((placement & SHMPREFAULT) && (prefault (add, size) == -1)) {
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+/**
+ *  \file placement.h (interface file)
+ *
+ *  \brief Placement of memory.
+ *
+ *  Operations defined on a range of the process address space (which starts at a page boundary):
+ *     \li setting the NUMA memory policy of its pages (interleaved over the nodes or bound to one node)
+ *     \li faulting its pages in.
+ *
+ *  The policy of a range of a shared memory block is the policy of the block: it applies to the pages allocated
+ *  afterwards by any process and the pages already allocated are moved when possible. Faulting the pages in when
+ *  a block is mapped keeps first-touch page faults out of the critical regions.
+ */
+
+#ifndef PLACEMENT_H_
+#define PLACEMENT_H_
+
+/** \brief placement of a block: huge pages (on creation) */
+#define  SHMHUGEPAGES     1
+/** \brief placement of a block: its pages are faulted in */
+#define  SHMPREFAULT      2
+/** \brief placement of a block: its pages are interleaved over the NUMA nodes */
+#define  SHMINTERLEAVE    4
+/** \brief placement of a block: its pages are bound to one NUMA node */
+#define  SHMBIND          8
+
+/** \brief size of a huge page (blocks of huge pages are a whole number of them) */
+#define  HUGEPAGESIZE     (2UL * 1024 * 1024)
+
+/**
+ *  \brief Placing a range of the process address space.
+ *
+ *  The memory policy is set first (SHMINTERLEAVE or SHMBIND), then the pages are faulted in (SHMPREFAULT).
+ *
+ *  \param add start of the range (at a page boundary)
+ *  \param size size of the range (in bytes)
+ *  \param placement combination of SHMPREFAULT with one of SHMINTERLEAVE and SHMBIND (SHMHUGEPAGES is ignored)
+ *  \param node NUMA node the pages are bound to (SHMBIND)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int placeRange (void *add, unsigned long size, unsigned int placement, int node);
+
+#endif /* PLACEMENT_H_ */
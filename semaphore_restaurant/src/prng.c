@@ -0,0 +1,56 @@
+/**
+ *  \file prng.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Counter-based pseudo-random number generators.
+ *
+ *  Operations defined on a generator:
+ *     \li initialization
+ *     \li drawing a number uniformly distributed in [0, 1).
+ *
+ *  Numbers are the output of the <em>splitmix64</em> finalizer applied to the key of the stream combined with the
+ *  counter.
+ */
+
+#include "prng.h"
+
+/** \brief increment of the splitmix64 sequence (golden ratio) */
+#define  GOLDEN     0x9E3779B97F4A7C15UL
+
+/* internal functions */
+
+static unsigned long mix (unsigned long x)
+{
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9UL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBUL;
+    return x ^ (x >> 31);
+}
+
+/* external functions */
+
+/**
+ *  \brief Generator initialization.
+ *
+ *  \param g pointer to the generator
+ *  \param seed seed of the run
+ *  \param stream stream id
+ */
+void prngInit (PRNG *g, unsigned long seed, unsigned int stream)
+{
+    g->key = mix (mix (seed) + (stream + 1) * GOLDEN);
+    g->counter = 0;
+}
+
+/**
+ *  \brief Drawing the next number of the stream.
+ *
+ *  \param g pointer to the generator
+ *
+ *  \return number uniformly distributed in [0, 1)
+ */
+double prngUniform (PRNG *g)
+{
+    g->counter += 1;
+    return (mix (g->key + g->counter * GOLDEN) >> 11) * (1.0 / (1UL << 53));
+}
@@ -0,0 +1,47 @@
+/**
+ *  \file prng.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Counter-based pseudo-random number generators.
+ *
+ *  Operations defined on a generator:
+ *     \li initialization
+ *     \li drawing a number uniformly distributed in [0, 1).
+ *
+ *  The n-th number of a stream is a hash of the seed, the stream id and n: it depends neither on the other streams
+ *  nor on the process or thread drawing it, so that a given seed produces the same times in every run.
+ */
+
+#ifndef PRNG_H_
+#define PRNG_H_
+
+/**
+ *  \brief Definition of <em>generator</em> data type: a stream of numbers.
+ */
+typedef struct {
+    /** \brief key of the stream (derived from the seed and the stream id) */
+    unsigned long key;
+    /** \brief number of numbers drawn so far */
+    unsigned long counter;
+} PRNG;
+
+/**
+ *  \brief Generator initialization.
+ *
+ *  \param g pointer to the generator
+ *  \param seed seed of the run
+ *  \param stream stream id
+ */
+extern void prngInit (PRNG *g, unsigned long seed, unsigned int stream);
+
+/**
+ *  \brief Drawing the next number of the stream.
+ *
+ *  \param g pointer to the generator
+ *
+ *  \return number uniformly distributed in [0, 1)
+ */
+extern double prngUniform (PRNG *g);
+
+#endif /* PRNG_H_ */
@@ -13,17 +13,47 @@
 
 /* Generic parameters */
 
-/** \brief maximum number of groups */
+/** \brief maximum number of groups held by the fixed size group arrays of the full state */
 #define  MAXGROUPS       16 
-/** \brief number of tables */
+/** \brief maximum number of groups (larger populations use group arrays that follow the shared data) */
+#define  MAXPOPULATION 16384
+/** \brief default number of tables (and size of the fixed size table arrays of the shared data) */
 #define  NUMTABLES        2 
+/** \brief maximum number of tables */
+#define  MAXTABLES      256
+/** \brief maximum number of slots of the request mailboxes */
+#define  MAXMAILBOX      64
+/** \brief maximum number of waiters and of chefs */
+#define  MAXSTAFF        32
 /** \brief controls time taken to cook */
 #define  MAXCOOK        100
 
+/** \brief size (in bytes) of a cache line: fields written by different entities are kept in different lines */
+#define  CACHELINE       64
+
+/** \brief number of state snapshots held by the log ring */
+#define  LOGRINGSIZE   4096
+/** \brief maximum size (in bytes) of the log ring slots (the number of slots is reduced for large populations) */
+#define  LOGRINGMAXBYTES  (64*1024*1024)
+/** \brief time (in us) the log drainer sleeps when the log ring is empty */
+#define  DRAINPERIOD   1000
+
 /** \brief controls start time standard deviation */
 #define  STARTDEV         4 
 /** \brief controls eat time standard deviation */
-#define  EATDEV           4 
+#define  EATDEV           4
+
+/** \brief random stream of the start and eat times of group g */
+#define  GROUPSTREAM(g)   (2 * (g))
+/** \brief random stream of the cooking time of the food of group g */
+#define  COOKSTREAM(g)    (2 * (g) + 1)
+/** \brief random stream of the arrival times of a scenario expanded at load time */
+#define  ARRIVALSTREAM    (2 * MAXPOPULATION)
+/** \brief random stream of the eat times of a scenario expanded at load time */
+#define  EATSTREAM        (2 * MAXPOPULATION + 1)
+
+/** \brief maximum number of recorded downs per group (size of the recorded order of a run) */
+#define  REPLAYPERGROUP  64
 
 /** \brief id of table request (group->receptionist) */
 #define TABLEREQ   1
@@ -34,6 +64,80 @@
 /** \brief id of food ready (chef->waiter) */
 #define FOODREADY 4
 
+/* Log mode constants */
+
+/** \brief each entity writes its state lines directly to the log file */
+#define  LOGDIRECT         0
+/** \brief entities queue state snapshots in the log ring, the log drainer writes them */
+#define  LOGRING           1
+/** \brief no log is written, the states are only published to the monitor */
+#define  LOGNONE           2
+
+/** \brief log is written as text lines */
+#define  LOGTEXT           0
+/** \brief log is written as a binary trace */
+#define  LOGBINARY         1
+/** \brief log is written as JSON lines, one per event with its changed fields */
+#define  LOGJSON           2
+/** \brief log is written as CSV, one row per changed field of an event */
+#define  LOGCSV            3
+
+/* Replay mode constants */
+
+/** \brief the order of the downs is neither recorded nor imposed */
+#define  REPLAYOFF         0
+/** \brief the order of the downs is recorded */
+#define  REPLAYRECORD      1
+/** \brief the recorded order of the downs is imposed */
+#define  REPLAYENFORCE     2
+
+/** \brief replay members that are groups */
+#define  MEMBERGROUP       0
+/** \brief replay members that are waiters */
+#define  MEMBERWAITER      1
+/** \brief replay members that are chefs */
+#define  MEMBERCHEF        2
+/** \brief replay member that is the receptionist */
+#define  MEMBERRECEPTIONIST 3
+/** \brief number of kinds of members (callers of the contention profile) */
+#define  MEMBERKINDS       4
+
+/* Notification constants */
+
+/** \brief source of requests of the event-driven staff: the receptionist mailbox */
+#define  NOTIFYRECEPTION   0
+/** \brief source of requests of the event-driven staff: the waiter mailbox and the food handed by the chefs */
+#define  NOTIFYKITCHEN     1
+/** \brief number of sources of requests of the event-driven staff */
+#define  NOTIFYSOURCES     2
+
+/* Scheduling policy constants */
+
+/** \brief waiting groups are seated in order of arrival */
+#define  SCHEDFIFO         0
+/** \brief waiting groups are seated by shortest expected eat time first */
+#define  SCHEDSEF          1
+/** \brief waiting groups are seated by earliest deadline first (arrival plus expected eat time) */
+#define  SCHEDEDF          2
+/** \brief number of scheduling policies */
+#define  SCHEDPOLICIES     3
+
+/* Latency constants */
+
+/** \brief latency from the arrival at the reception to the assignment of a table */
+#define  LATTABLE          0
+/** \brief latency from the food request to the arrival of the food */
+#define  LATFOOD           1
+/** \brief latency from the checkout to leaving */
+#define  LATCHECKOUT       2
+/** \brief number of latencies */
+#define  NLATENCIES        3
+
+/** \brief stamp of the assignment of a table (the other stamps of a group are its states) */
+#define  GOTTABLE          8
+/** \brief number of stamps of a group */
+#define  NSTAMPS           9
+
 /* Client state constants */
 
 /** \brief group initial state */
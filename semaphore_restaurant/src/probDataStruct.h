@@ -16,6 +16,13 @@
 #include <stdbool.h>
 
 #include "probConst.h"
+#include "histogram.h"
+
+/** \brief field or data type that starts a cache line of its own */
+#define  CACHEALIGNED   __attribute__ ((aligned (CACHELINE)))
+
+/** \brief number of bytes of the cache lines that hold n bytes */
+#define  CACHELINES(n)  (((n) + CACHELINE - 1) & ~(unsigned long) (CACHELINE - 1))
 
 /**
  *  \brief Definition of requests to receptionist and waiter 
@@ -27,6 +34,23 @@ typedef struct {
     int reqGroup;
 } request;
 
+/**
+ *  \brief Definition of <em>request mailbox</em> data type.
+ *
+ *  Bounded circular buffer of requests. The request slot of the full state shows the oldest request in the
+ *  mailbox; with a single slot, the mailbox is not used and requests are stored in the request slot.
+ */
+typedef struct {
+    /** \brief requests, in order of arrival */
+    request slot[MAXMAILBOX];
+    /** \brief position of the oldest request */
+    unsigned int head;
+    /** \brief number of requests in the mailbox */
+    unsigned int count;
+    /** \brief number of slots */
+    unsigned int size;
+} MAILBOX;
+
 
 /**
  *  \brief Definition of <em>state of the intervening entities</em> data type.
@@ -80,4 +104,229 @@ typedef struct
 } FULL_STAT;
 
 
+/**
+ *  \brief Definition of the <em>location of the group arrays</em> data type.
+ *
+ *  Offsets relative to the full state the arrays belong to. With up to MAXGROUPS groups they locate the
+ *  fixed size arrays of the full state; larger populations use arrays placed after it, each one starting a cache
+ *  line, with the arrays that are only read (start and eat times) apart from those written by the entities.
+ */
+typedef struct {
+    /** \brief location of the group state array */
+    long groupStat;
+    /** \brief location of the estimated start time array */
+    long startTime;
+    /** \brief location of the estimated eat time array */
+    long eatTime;
+    /** \brief location of the assigned table array */
+    long assignedTable;
+} GROUP_ARRAYS;
+
+/** \brief array of the given type located by offset <tt>off</tt> relative to the full state <tt>p_fSt</tt> */
+#define  GROUPARRAY(p_fSt, off, type)   ((type *) ((char *) (p_fSt) + (off)))
+
+/**
+ *  \brief Definition of the <em>log ring</em> data type.
+ *
+ *  Bounded multi-producer / single-consumer queue of packed state snapshots, stored in shared memory.
+ *  Each slot starts with a sequence stamp that tells whether it is free or holds a snapshot, followed by the
+ *  entity that saved the snapshot and the time it was saved.
+ *  The head, written by the producers, and the tail, written by the consumer, are in different cache lines.
+ */
+typedef struct {
+    /** \brief number of slots */
+    unsigned int size;
+    /** \brief size of each slot (in bytes) */
+    unsigned int slotSize;
+    /** \brief location of the first slot (offset relative to the ring) */
+    unsigned long slotsOff;
+    /** \brief number of groups in each snapshot */
+    int nGroups;
+    /** \brief sequence number of the next snapshot to be written */
+    unsigned int head CACHEALIGNED;
+    /** \brief sequence number of the next snapshot to be drained */
+    unsigned int tail CACHEALIGNED;
+    /** \brief set when all entities have terminated */
+    unsigned int done;
+} LOG_RING;
+
+/**
+ *  \brief Definition of the <em>state snapshot</em> data type.
+ *
+ *  Last saved state, packed as in the log ring, published for readers outside the simulation (see
+ *  <tt>monitor</tt>). The snapshot is guarded by a sequence lock: its version is odd while it is being written, so
+ *  that readers copy it without taking any lock and retry when the version changed meanwhile.
+ */
+typedef struct {
+    /** \brief version of the snapshot (odd while it is being written) */
+    unsigned int version;
+    /** \brief number of groups of the snapshot */
+    int nGroups;
+    /** \brief number of states saved so far */
+    unsigned long states;
+    /** \brief number of state saves skipped so far, because the state did not change (coalesced log) */
+    unsigned long coalesced;
+    /** \brief location of the packed state (offset relative to the snapshot, 0 when states are not published) */
+    unsigned long dataOff;
+} LOG_SNAPSHOT;
+
+/**
+ *  \brief Definition of the <em>log configuration</em> data type, shared by all entities.
+ *
+ *  The configuration, which is only read once the log is created (the semaphore of the log lock included), is
+ *  followed by the ring and the snapshot, each in cache lines of its own.
+ */
+typedef struct {
+    /** \brief log mode (LOGDIRECT, LOGRING or LOGNONE) */
+    int mode;
+    /** \brief log format (LOGTEXT, LOGBINARY, LOGJSON or LOGCSV) */
+    int format;
+    /** \brief number of tables (needed by the binary trace records) */
+    int nTables;
+    /** \brief location of the group arrays of the full state being saved */
+    GROUP_ARRAYS groups;
+    /** \brief identification of the semaphore that serializes the state saves, when entities may save their state
+     *  concurrently (locks are split), 0 otherwise */
+    unsigned int lockSem;
+    /** \brief set when a state is only saved if it differs from the last saved state (coalesced log) */
+    int coalesce;
+    /** \brief start of the log (nanoseconds of the monotonic clock), the events are stamped relative to it */
+    unsigned long start;
+    /** \brief number of entities of each kind numbered by the log so far */
+    unsigned int numbered[MEMBERKINDS];
+    /** \brief ring of state snapshots (LOGRING mode) */
+    LOG_RING ring CACHEALIGNED;
+    /** \brief last saved state, published for the monitor */
+    LOG_SNAPSHOT snap CACHEALIGNED;
+} LOG_CONF;
+
+/**
+ *  \brief Definition of the <em>clock timer</em> data type: scheduled wake-up of a sleeping entity.
+ */
+typedef struct {
+    /** \brief simulated time of the wake-up (in microseconds) */
+    unsigned long wake;
+    /** \brief order of scheduling (wake-ups scheduled for the same time take place in this order) */
+    unsigned int seq;
+    /** \brief member of the clock to be woken up */
+    unsigned int member;
+} CLOCK_TIMER;
+
+/**
+ *  \brief Definition of the <em>virtual clock</em> data type, shared by all entities.
+ *
+ *  The members of the clock are the entities (groups first, then waiters, chefs and receptionist). Sleeping members
+ *  schedule a wake-up in a timer queue (a binary heap ordered by wake-up time) and block; the simulated time jumps
+ *  to the earliest wake-up when every member is blocked. The wait descriptors of the members follow the timer
+ *  queue. The fields that are only read once the clock is initialized are apart from those that are updated.
+ */
+typedef struct {
+    /** \brief set when the simulated time is used instead of the real time */
+    int enabled;
+    /** \brief identification of semaphore counting the members that are not blocked */
+    unsigned int running;
+    /** \brief identification of the wake-up semaphore of the first member (one per member) */
+    unsigned int wakeUp;
+    /** \brief number of members */
+    unsigned int members;
+    /** \brief location of the timer queue (offset relative to the clock) */
+    unsigned long timersOff;
+    /** \brief location of the wait descriptors of the members (offset relative to the clock) */
+    unsigned long waitsOff;
+    /** \brief spin lock protecting the timer queue */
+    unsigned int lock CACHEALIGNED;
+    /** \brief simulated time (in microseconds) */
+    unsigned long now;
+    /** \brief number of members that are not groups and have joined the clock */
+    unsigned int staff;
+    /** \brief number of members that have not terminated */
+    int live;
+    /** \brief number of times a member blocked or terminated */
+    unsigned int blockings;
+    /** \brief number of scheduled wake-ups */
+    unsigned int nTimers;
+    /** \brief number of wake-ups scheduled so far */
+    unsigned int seq;
+} VCLOCK;
+
+/**
+ *  \brief Definition of the <em>replay entry</em> data type: a down carried out by a member.
+ */
+typedef struct {
+    /** \brief member that carried out the down */
+    unsigned int member;
+    /** \brief number of downs carried out by a non blocking down (-1 for a blocking down) */
+    int result;
+} REPLAY_ENTRY;
+
+/**
+ *  \brief Definition of the <em>replay</em> data type, shared by all entities.
+ *
+ *  The members are the entities (groups first, then waiters, chefs and receptionist), numbered by kind, so that
+ *  entities of the same kind, which run the same code, may swap their numbers between runs. The downs of the
+ *  members are recorded in the order they complete or are carried out in the recorded order, a member waiting
+ *  for its turn on its own semaphore. The entries follow the timer queue of the clock.
+ */
+typedef struct {
+    /** \brief replay mode (REPLAYOFF, REPLAYRECORD or REPLAYENFORCE) */
+    int mode;
+    /** \brief number of members */
+    unsigned int members;
+    /** \brief identification of the turn semaphore of the first member (one per member) */
+    unsigned int turn;
+    /** \brief first member of each kind */
+    unsigned int first[4];
+    /** \brief number of members of each kind that have joined */
+    unsigned int joined[4];
+    /** \brief number of entries (recorded or to be imposed) */
+    unsigned int length;
+    /** \brief maximum number of entries */
+    unsigned int capacity;
+    /** \brief position of the next entry to be imposed */
+    unsigned int next;
+    /** \brief set when the order is no longer imposed (every entry was imposed or the run diverged) */
+    int done;
+    /** \brief location of the entries (offset relative to the replay) */
+    unsigned long entriesOff;
+} REPLAY;
+
+/**
+ *  \brief Definition of the <em>latency statistics</em> data type, shared by all entities.
+ *
+ *  Every state transition of a group, and the assignment of its table, is stamped with the current time (simulated
+ *  with the virtual clock) and the latencies of the phases it ends are recorded by the group itself: reception to
+ *  table, order to food and checkout. The time of the downs of each semaphore that may block is recorded by the
+ *  semaphore module. The stamps and the histograms of the semaphores follow the replay entries.
+ */
+typedef struct {
+    /** \brief set when the latencies are recorded */
+    int enabled;
+    /** \brief number of semaphores (including the start of operations semaphore) */
+    unsigned int nSems;
+    /** \brief number of groups */
+    unsigned int nGroups;
+    /** \brief location of the stamps of the groups, NSTAMPS per group (offset relative to the statistics) */
+    unsigned long stampsOff;
+    /** \brief location of the histograms of the downs of each semaphore (offset relative to the statistics) */
+    unsigned long waitsOff;
+    /** \brief histograms of the latencies (nanoseconds), apart from the fields that are only read */
+    HISTOGRAM phase[NLATENCIES] CACHEALIGNED;
+} LATENCY;
+
+/**
+ *  \brief Definition of the <em>notifier</em> data type.
+ *
+ *  Notification of the requests posted to the mailboxes served by a single event-driven entity: an eventfd per
+ *  source of requests, all of them watched by an epoll instance. The descriptors are those of the generator,
+ *  inherited by the entities of the threaded and the forked engines.
+ */
+typedef struct {
+    /** \brief number of sources of requests (0 when requests are not notified) */
+    unsigned int sources;
+    /** \brief epoll instance that watches the sources */
+    int epfd;
+    /** \brief eventfd of each source */
+    int fd[NOTIFYSOURCES];
+} NOTIFIER;
+
 #endif /* PROBDATASTRUCT_H_ */
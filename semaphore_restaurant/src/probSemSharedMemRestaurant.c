@@ -8,9 +8,87 @@
  *
  *  Generator process of the intervening entities.
  *
+ *  The number of groups (up to <tt>MAXPOPULATION</tt>), their start and eat times and, optionally and in this
+ *  order, the number of tables (<tt>NUMTABLES</tt> if missing), waiters and chefs (one if missing) are read from
+ *  <tt>config.txt</tt>. The start and eat times of the groups may be replaced by a scenario, a single
+ *  <tt>\#arrivals</tt> line whose arrival pattern and eat time distribution are expanded into the times of every
+ *  group when the file is read (see scenario.h and <tt>scengen</tt>).
+ *
  *  Upon execution, one parameter is requested:
  *    \li name of the logging file.
  *
+ *  Options:
+ *    \li <tt>-r</tt> state snapshots are queued in a shared memory ring and written by a log drainer process
+ *    \li <tt>-b</tt> the log is written as a binary trace (see <tt>logdump</tt>)
+ *    \li <tt>-j</tt> the log is written as JSON lines, one per event with its sequence number, time, entity and
+ *        changed fields, by the log drainer (implies <tt>-r</tt>)
+ *    \li <tt>-c</tt> the log is written as CSV, one row per changed field of an event, by the log drainer
+ *        (implies <tt>-r</tt>)
+ *    \li <tt>-n</tt> no log is written (the state may still be watched with <tt>monitor</tt>)
+ *    \li <tt>-d</tt> a state is only logged when it differs from the last logged one (coalesced log: the saves of
+ *        an unchanged state are counted and their number is printed at exit; not with the reference binaries, whose
+ *        lines are not seen by the other entities)
+ *    \li <tt>-l</tt> the reception, kitchen and table locks are split into different semaphores (implies <tt>-r</tt>:
+ *        every save still takes the log lock, a single semaphore, to claim its slot of the log ring and pack the
+ *        state into it, so that the saves of disjoint regions serialize on it, although no write is made holding it;
+ *        the lines are logged in order, but a line may show a change of a region before it is saved, see
+ *        sharedDataSync.h; not with the reference binaries, which only take <tt>mutex</tt>)
+ *    \li <tt>-a</tt> the group arrays follow the shared data, in cache lines of their own, even when the fixed size
+ *        arrays of the full state would hold them (not with the reference binaries)
+ *    \li <tt>-g n</tt> each group process hosts up to <tt>n</tt> groups, one thread per group
+ *    \li <tt>-m n</tt> the request mailboxes of the receptionist and the waiter have <tt>n</tt> slots (one by default;
+ *        more than one not with the reference binaries, which only use the request slot of the full state)
+ *    \li <tt>-v</tt> sleeping takes simulated time, advanced by a clock process when every entity is blocked
+ *        (System V semaphores only, not with the reference binaries)
+ *    \li <tt>-s seed</tt> seed of the random streams of the start, eat and cooking times (derived from the time
+ *        and the process id by default)
+ *    \li <tt>-R file</tt> the order in which the entities carry out their downs is recorded in <tt>file</tt>,
+ *        together with the seed
+ *    \li <tt>-P file</tt> the order recorded in <tt>file</tt> is imposed on the entities and its seed is used, so that
+ *        the recorded interleaving is reproduced (same configuration and options, not with the reference binaries)
+ *    \li <tt>-k key</tt> access key of the shared memory and the semaphore set, instead of the key generated from the
+ *        current directory, so that several simulations may run at the same time in the same directory
+ *    \li <tt>-u</tt> the shared region is made of huge pages (they must be reserved, see
+ *        <tt>/proc/sys/vm/nr_hugepages</tt>)
+ *    \li <tt>-p</tt> every entity faults the pages of the shared region in when it maps it, so that no page fault
+ *        takes place within a critical region
+ *    \li <tt>-N i</tt> the pages of the shared region are interleaved over the NUMA nodes; <tt>-N n</tt> binds them
+ *        to node <tt>n</tt>
+ *    \li <tt>-H</tt> the latencies of the groups (reception to table, order to food and checkout) and the time of the
+ *        downs of each semaphore are recorded in histograms, whose percentiles are printed at exit
+ *    \li <tt>-w runs</tt> the simulation is run <tt>runs</tt> times by a warm pool of entities (forked engine only)
+ *    \li <tt>-e</tt> the receptionist and the waiter are a single event-driven entity, woken up by the notification
+ *        of the requests to either of them (threaded and forked engines only, a single waiter, not with <tt>-R</tt> or
+ *        <tt>-P</tt>)
+ *    \li <tt>-S policy</tt> scheduling policy of the groups waiting for a table, when one gets vacant: <tt>fifo</tt>
+ *        (order of arrival, by default), <tt>sef</tt> (shortest expected eat time first) or <tt>edf</tt> (earliest
+ *        deadline first, the deadline of a group being its arrival plus its expected eat time); with <tt>-H</tt>, the
+ *        utilization of the tables is printed as well (not with the reference binaries)
+ *    \li <tt>-K</tt> pipelined kitchen: the cooking of an order starts when it is placed and a chef receives new
+ *        orders while the previous ones cook, handing the food that is ready in batches to the mailbox of the waiter
+ *        (not with the reference binaries; a recorded order is only imposed with <tt>-v</tt>).
+ *
+ *  When compiled with <tt>SEMPROFILE</tt> defined (<tt>make profile</tt>), the acquires, contended acquires and time
+ *  blocked of each semaphore and kind of entity are kept in a contention profile in the shared region, printed at
+ *  exit and readable while the simulation runs (see <tt>semstat</tt>).
+ *
+ *  When compiled with <tt>THREADED</tt> defined (<tt>make threaded</tt>), the life cycles of the entities are
+ *  linked into the generator and every entity is a thread of the generator process, sharing a process-private
+ *  shared data block and semaphore set.
+ *
+ *  When compiled with <tt>FORKED</tt> defined (<tt>make forked</tt>), the life cycles of the entities are linked
+ *  into the generator as well, but every entity is a child process of the generator that runs its life cycle right
+ *  after the fork, without executing a program. The shared data block and the semaphore set (POSIX semaphores) are
+ *  anonymous shared mappings inherited across the fork: no System V resource nor file is created, so nothing is
+ *  left behind when the simulation crashes, and the key is only known by the generator and its children (the
+ *  monitor and semstat cannot attach to the simulation).
+ *
+ *  With <tt>-w</tt>, the entities of the forked engine, and the log drainer, are a pool of workers forked once:
+ *  after a run, they wait for the next one, while the generator restores the shared region and the values of the
+ *  semaphore set saved before the first run. Every run writes the log file again, so that it holds the last run,
+ *  and run <tt>r</tt> uses the seed plus <tt>r</tt> (unless a recorded order is imposed). The statistics are
+ *  printed after every run and the time of the runs at exit.
+ *
  *  \author Nuno Lau - December 2023
  */
 
@@ -21,8 +99,14 @@
 #include <sys/wait.h>
 #include <sys/types.h>
 #include <sys/ipc.h>
+#include <stddef.h>
 #include <string.h>
 #include <math.h>
+#include <errno.h>
+#include <time.h>
+#ifdef THREADED
+#include <pthread.h>
+#endif
 
 #include "probConst.h"
 #include "probDataStruct.h"
@@ -30,6 +114,13 @@
 #include "sharedDataSync.h"
 #include "semaphore.h"
 #include "sharedMemory.h"
+#include "mailbox.h"
+#include "virtualClock.h"
+#include "replay.h"
+#include "scenario.h"
+#include "notify.h"
+#include "latency.h"
+#include "contention.h"
 
 /** \brief name of chef process */
 #define   CHEF               "./chef"
@@ -42,6 +133,252 @@
 
 /** \brief name of chef process */
 #define   RECEPTIONIST       "./receptionist"
+
+/** \brief command line usage */
+#define   USAGE              "Usage: %s [-r] [-b | -j | -c] [-n] [-d] [-l] [-a] [-g groups per process]\n" \
+                             "       [-m mailbox slots] [-v] [-s seed] [-R order file | -P order file] [-k key] [-H]\n" \
+                             "       [-u] [-p] [-N i | -N node] [-w runs] [-e] [-S fifo | -S sef | -S edf] [-K]\n" \
+                             "       [log file]\n"
+
+/** \brief names of the scheduling policies of the waiting groups */
+static const char *schedName[SCHEDPOLICIES] = {"fifo", "sef", "edf"};
+
+/** \brief maximum number of command line parameters of an entity */
+#define   MAXARGS            6
+
+#ifdef THREADED
+/** \brief stack size of the entity threads */
+#define   ENTITYSTACK        (256 * 1024)
+#endif
+
+#ifdef FORKED
+/** \brief bits of the key changed to obtain the key of the semaphore set of the pool */
+#define   POOLKEYMASK        0x02000000
+
+/** \brief semaphore of the pool: the workers may start the next run */
+#define   POOLSTART          1
+
+/** \brief semaphore of the pool: a worker ended its run */
+#define   POOLDONE           2
+#endif
+
+#if defined (THREADED) || defined (FORKED)
+/** \brief life cycle of an entity linked into the generator */
+#define   ENTRY(f)           f
+
+/* life cycles of the entities (main programs of the entities, renamed when compiled for the threaded and the forked
+   engines) */
+extern int chefMain (int argc, char *argv[]);
+extern int waiterMain (int argc, char *argv[]);
+extern int groupMain (int argc, char *argv[]);
+extern int receptionistMain (int argc, char *argv[]);
+extern int staffMain (int argc, char *argv[]);
+#else
+/** \brief life cycle of an entity linked into the generator (none: entities are separate programs) */
+#define   ENTRY(f)           NULL
+#endif
+
+/** \brief intervening entity generated by the generator */
+typedef struct {
+    /** \brief process identifier */
+    pid_t pid;
+#ifdef THREADED
+    /** \brief thread identifier */
+    pthread_t thr;
+    /** \brief life cycle of the entity */
+    int (*entry) (int, char *[]);
+    /** \brief number of command line parameters */
+    int argc;
+    /** \brief command line parameters */
+    char *argv[MAXARGS + 1];
+    /** \brief copy of the command line parameters (the generator reuses its conversion buffers) */
+    char args[MAXARGS][52];
+#endif
+} ENTITY;
+
+#ifdef THREADED
+/**
+ *  \brief Thread of an entity: runs its life cycle.
+ *
+ *  \param arg pointer to the entity
+ */
+static void *entityLife (void *arg)
+{
+    ENTITY *ent = arg;
+
+    ent->entry (ent->argc, ent->argv);
+    return NULL;
+}
+
+#endif
+
+#if defined (THREADED) || defined (FORKED)
+/** \brief logging file name of the log drainer */
+static char *drainFic;
+
+/** \brief log configuration of the log drainer */
+static LOG_CONF *drainConf;
+#endif
+
+#ifdef THREADED
+/**
+ *  \brief Thread of the log drainer.
+ *
+ *  \param arg not used
+ */
+static void *drainerLife (void *arg)
+{
+    drainLog (drainFic, drainConf);
+    return NULL;
+}
+#endif
+
+#ifdef FORKED
+/** \brief number of runs of the workers of the pool */
+static int poolRuns = 1;
+
+/** \brief semaphore set access identifier of the pool */
+static int poolgid;
+
+/**
+ *  \brief Life cycle of the log drainer, run by a worker of the pool.
+ *
+ *  \param argc number of command line parameters
+ *  \param argv command line parameters (name of the program and of the error file)
+ */
+static int drainerMain (int argc, char *argv[])
+{
+    freopen (argv[1], "w", stderr);
+    setbuf (stderr, NULL);
+    drainLog (drainFic, drainConf);
+    return EXIT_SUCCESS;
+}
+
+/**
+ *  \brief Starting the next run of the workers of the pool.
+ *
+ *  \param n number of workers
+ */
+static void startPool (unsigned int n)
+{
+    SEM_OP start[] = {{POOLSTART, (int) n}};
+
+    if (semOpMulti (poolgid, start, 1) == -1) {
+        perror ("error on starting the next run");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief Waiting for the end of the run of workers of the pool.
+ *
+ *  \param n number of workers
+ */
+static void waitPool (unsigned int n)
+{
+    SEM_OP done[] = {{POOLDONE, -(int) n}};
+
+    if (semOpMulti (poolgid, done, 1) == -1) {
+        perror ("error on waiting for the end of the run");
+        exit (EXIT_FAILURE);
+    }
+}
+#endif
+
+/**
+ *  \brief Generation of an intervening entity.
+ *
+ *  The entity is a new process running program <tt>prog</tt> or, in the threaded engine, a new thread running
+ *  the life cycle <tt>entry</tt> or, in the forked engine, a new worker of the pool running the life cycle
+ *  <tt>entry</tt> once per run, with the command line parameters <tt>argv</tt> (a null terminated array). An
+ *  entity that is already a worker of the pool is not generated again: it runs when the pool is started.
+ *
+ *  \param ent pointer to the location where the entity is stored
+ *  \param prog name of the program of the entity
+ *  \param entry life cycle of the entity
+ *  \param argv command line parameters
+ *  \param what name of the entity (for error messages)
+ */
+static void startEntity (ENTITY *ent, char *prog, int (*entry) (int, char *[]), char *argv[], char *what)
+{
+#ifdef THREADED
+    pthread_attr_t attr;                                                                   /* attributes of thread */
+    int stat;
+
+    ent->entry = entry;
+    for (ent->argc = 0; (ent->argc < MAXARGS) && (argv[ent->argc] != NULL); ent->argc++) {
+        strcpy (ent->args[ent->argc], argv[ent->argc]);
+        ent->argv[ent->argc] = ent->args[ent->argc];
+    }
+    ent->argv[ent->argc] = NULL;
+    pthread_attr_init (&attr);
+    pthread_attr_setstacksize (&attr, ENTITYSTACK);
+    if ((stat = pthread_create (&ent->thr, &attr, entityLife, ent)) != 0) {
+        fprintf (stderr, "error on creating the %s thread: %s\n", what, strerror (stat));
+        exit (EXIT_FAILURE);
+    }
+    pthread_attr_destroy (&attr);
+#else
+#ifdef FORKED
+    if (ent->pid != 0) {                                                       /* already a worker of the pool */
+        return;
+    }
+    fflush (NULL);                                           /* the buffered output is not repeated by the child */
+#endif
+    if ((ent->pid = fork ()) < 0) {
+        fprintf (stderr, "error on the fork operation for the %s: %s\n", what, strerror (errno));
+        exit (EXIT_FAILURE);
+    }
+    if (ent->pid == 0) {
+#ifdef FORKED
+        int n, run;
+
+        for (n = 0; argv[n] != NULL; n++)
+            ;
+        for (run = 0; run < poolRuns; run++) {
+            if (semDown (poolgid, POOLSTART) == -1) {
+                perror ("error on waiting for the next run");
+                exit (EXIT_FAILURE);
+            }
+            entry (n, argv);
+            if (semUp (poolgid, POOLDONE) == -1) {
+                perror ("error on signaling the end of the run");
+                exit (EXIT_FAILURE);
+            }
+        }
+        exit (EXIT_SUCCESS);
+#endif
+        execv (prog, argv);
+        fprintf (stderr, "error on the generation of the %s process: %s\n", what, strerror (errno));
+        exit (EXIT_FAILURE);
+    }
+#endif
+}
+
+/**
+ *  \brief Waiting for the termination of an intervening entity.
+ *
+ *  \param ent pointer to the entity
+ */
+static void waitEntity (ENTITY *ent)
+{
+#ifdef THREADED
+    int stat;
+
+    if ((stat = pthread_join (ent->thr, NULL)) != 0) {
+        fprintf (stderr, "error on waiting for an intervening thread: %s\n", strerror (stat));
+        exit (EXIT_FAILURE);
+    }
+#else
+    int status;                                                                                    /* execution status */
+
+    if (waitpid (ent->pid, &status, 0) == -1) {
+        perror ("error on waiting for an intervening process");
+        exit (EXIT_FAILURE);
+    }
+#endif
+}
+
 /**
  *  \brief Main program.
  *
@@ -56,31 +393,328 @@ int main (int argc, char *argv[])
         semgid;                                                                     /* semaphore set access identifier */
     unsigned int  m;                                                                             /* counting variables */
     SHARED_DATA *sh;                                                                /* pointer to shared memory region */
-    int pidCH,                                                                             /* pilot process identifier */
-        pidWT,                                                                     /* hostess process identifier array */
-        pidRT,                                                                     /* hostess process identifier array */
-        pidGR[MAXGROUPS];                                                     /* passengers processes identifier array */
-    int key;                                                           /*access key to shared memory and semaphore set */
+    ENTITY *ent;                                                                         /* intervening entities array */
+    unsigned int nEnt;                                                                /* number of intervening entities */
+    char *args[MAXARGS + 1];                                                      /* command line of an entity */
+#ifdef THREADED
+    pthread_t thrLG;                                                                    /* log drainer thread identifier */
+    int stat;
+#elif defined (FORKED)
+    ENTITY drainer;                                                               /* log drainer worker of the pool */
+#else
+    int pidLG = -1;                                                                  /* log drainer process identifier */
+#endif
+    int pidCK = -1;                                                                /* clock advancer process identifier */
+    int status;                                                                                    /* execution status */
+    int key = IPC_PRIVATE;                                             /*access key to shared memory and semaphore set */
     char num[2][12];                                                     /* numeric value conversion (up to 10 digits) */
-    int status,                                                                                    /* execution status */
-        info;                                                                                               /* info id */
-    int g, t;
+    char nHosted[12];                                                /* number of groups hosted by a group process */
+    int g, h, t;
+    int opt;                                                                                   /* command line option */
+    int logMode = LOGDIRECT;                                                                              /* log mode */
+    int logFormat = LOGTEXT;                                                                            /* log format */
+    bool splitLocks = false;                                                                  /* split locks flag */
+    unsigned long ringBytes = 0;                                                        /* size of the log ring slots */
+    unsigned int ringSize = LOGRINGSIZE;                                           /* number of slots of the log ring */
+    unsigned long tablesBytes;                                         /* size of the table synchronization array */
+    unsigned long groupsBytes = 0;                                /* size of the group arrays that follow the shared data */
+    unsigned long groupsOff;                                           /* location of the group arrays (if any) */
+    int nGroups, nTables;                                                           /* number of groups and tables */
+    int nWaiters, nChefs;                                                          /* number of waiters and chefs */
+    int *startTime, *eatTime;                                               /* groups times read from config file */
+    char header[256];                                              /* line that follows the number of groups */
+    SCENARIO scenario;                                             /* scenario the groups times are expanded from */
+    int groupsPerHost = 1;                                                       /* groups hosted by a group process */
+    int nHosts;                                                                            /* number of group processes */
+    int mailboxSize = 1;                                                      /* number of slots of the mailboxes */
+    bool virtualTime = false;                                                             /* virtual clock flag */
+    unsigned long timersBytes = 0;                        /* size of the timer queue and wait descriptors of the clock */
+    unsigned long seed = 0;                                                    /* seed of the random streams */
+    bool seeded = false;                                                                  /* seed given flag */
+    int replayMode = REPLAYOFF;                                                                 /* replay mode */
+    char *orderFic = NULL;                                                  /* name of the recorded order file */
+    REPLAY_ENTRY *entries = NULL;                                       /* recorded order imposed on the entities */
+    unsigned int nEntries = 0;                                                    /* number of recorded entries */
+    unsigned int population[3];                                /* numbers of groups, waiters and chefs recorded */
+    unsigned int capacity = 0;                                                   /* maximum number of entries */
+    unsigned long replaySpace = 0;                                                /* size of the replay entries */
+    bool latencyStats = false;                                                      /* latency statistics flag */
+    unsigned int nSems;                                               /* maximum number of semaphores in the set */
+    unsigned long latencySpace = 0;                           /* size of the stamps and histograms of the statistics */
+    unsigned long latencyOff;                                    /* location of the stamps and histograms (if any) */
+    unsigned long statsBytes = 0;                                   /* size of the contention profile (if any) */
+    unsigned long statsOff;                                          /* location of the contention profile (if any) */
+    unsigned long snapOff;                                                /* location of the published state */
+    bool noLog = false;                                                                   /* no log is written */
+    bool coalesce = false;                                                        /* unchanged states are not logged */
+    bool eventStaff = false;                                /* receptionist and waiter are an event-driven entity */
+    unsigned int schedPolicy = SCHEDFIFO;                           /* scheduling policy of the waiting groups */
+    bool pipelinedKitchen = false;                     /* the chefs cook several orders at the same time */
+    bool apartGroups = false;                              /* the group arrays follow the shared data in any case */
+    unsigned long arrayBytes = 0;                                     /* size of each group array (whole lines) */
+    unsigned int placement = 0;                                               /* placement of the shared region */
+    int node = 0;                                                           /* NUMA node the region is bound to */
+    SEM_RANGE ranges[SEMRANGES];                                                     /* names of the semaphores */
+    unsigned int nRanges;                                                                    /* number of ranges */
+    int exitStat = EXIT_SUCCESS;                                                       /* generator exit status */
+    int runs = 1, run;                                                                /* number of runs and run */
+    unsigned long regionBytes;                                                     /* size of the shared region */
+    void *image = NULL;                                         /* shared region saved before the first run */
+    unsigned short *semValues = NULL;                          /* semaphore values saved before the first run */
+    struct timespec runsStart, runsEnd;                                          /* start and end of the runs */
 
-    /* getting log file name */
-    if(argc==2) {
-        strcpy(nFic, argv[1]);
+    /* getting options and log file name */
+    while ((opt = getopt (argc, argv, "rbjcndlag:m:vs:R:P:k:HupN:w:eS:K")) != -1) {
+        switch (opt) {
+            case 'r':
+                logMode = LOGRING;
+                break;
+            case 'b':
+                logFormat = LOGBINARY;
+                break;
+            case 'j':
+            case 'c':
+                logFormat = (opt == 'j') ? LOGJSON : LOGCSV;
+                logMode = LOGRING;                                          /* the drainer writes the events */
+                break;
+            case 'n':
+                noLog = true;
+                break;
+            case 'd':
+                coalesce = true;
+                break;
+            case 'l':
+                splitLocks = true;
+                break;
+            case 'a':
+                apartGroups = true;
+                break;
+            case 'g':
+                groupsPerHost = atoi (optarg);
+                break;
+            case 'm':
+                mailboxSize = atoi (optarg);
+                break;
+            case 'v':
+                virtualTime = true;
+                break;
+            case 's':
+                seed = strtoul (optarg, NULL, 0);
+                seeded = true;
+                break;
+            case 'R':
+            case 'P':
+                if (replayMode != REPLAYOFF) {
+                    fprintf (stderr, USAGE, argv[0]);
+                    exit (EXIT_FAILURE);
+                }
+                replayMode = (opt == 'R') ? REPLAYRECORD : REPLAYENFORCE;
+                orderFic = optarg;
+                break;
+            case 'k':
+                if ((key = (int) strtol (optarg, NULL, 0)) == IPC_PRIVATE) {
+                    fprintf (stderr, USAGE, argv[0]);
+                    exit (EXIT_FAILURE);
+                }
+                break;
+            case 'H':
+                latencyStats = true;
+                break;
+            case 'u':
+                placement |= SHMHUGEPAGES;
+                break;
+            case 'p':
+                placement |= SHMPREFAULT;
+                break;
+            case 'N':
+                placement &= ~(SHMINTERLEAVE | SHMBIND);
+                if (strcmp (optarg, "i") == 0) {
+                    placement |= SHMINTERLEAVE;
+                }
+                else if (sscanf (optarg, "%d", &node) == 1) {
+                    placement |= SHMBIND;
+                }
+                else {
+                    fprintf (stderr, USAGE, argv[0]);
+                    exit (EXIT_FAILURE);
+                }
+                break;
+            case 'w':
+                runs = atoi (optarg);
+                break;
+            case 'e':
+                eventStaff = true;
+                break;
+            case 'K':
+                pipelinedKitchen = true;
+                break;
+            case 'S':
+                for (schedPolicy = 0; (schedPolicy < SCHEDPOLICIES) && (strcmp (optarg, schedName[schedPolicy]) != 0);
+                     schedPolicy++)
+                    ;
+                if (schedPolicy == SCHEDPOLICIES) {
+                    fprintf (stderr, USAGE, argv[0]);
+                    exit (EXIT_FAILURE);
+                }
+                break;
+            default:
+                fprintf (stderr, USAGE, argv[0]);
+                exit (EXIT_FAILURE);
+        }
+    }
+    if ((groupsPerHost < 1) || (mailboxSize < 1) || (mailboxSize > MAXMAILBOX) || (runs < 1)) {
+        fprintf (stderr, USAGE, argv[0]);
+        exit (EXIT_FAILURE);
+    }
+#ifndef FORKED
+    if (runs > 1) {
+        fprintf (stderr, "The pool of entities requires the forked engine (make forked)!\n");
+        exit (EXIT_FAILURE);
+    }
+#endif
+#if !defined (THREADED) && !defined (FORKED)
+    if (eventStaff) {
+        fprintf (stderr, "The event-driven staff requires the threaded or the forked engine (make threaded or make forked)!\n");
+        exit (EXIT_FAILURE);
+    }
+#endif
+    if (pipelinedKitchen && (replayMode == REPLAYENFORCE) && !virtualTime) {
+        fprintf (stderr, "The food ready in the pipelined kitchen depends on the time: the recorded order can only be "
+                 "imposed with simulated time (-v)!\n");
+        exit (EXIT_FAILURE);
+    }
+    if (eventStaff && (replayMode != REPLAYOFF)) {
+        fprintf (stderr, "The order of the downs of the event-driven staff can be neither recorded nor imposed!\n");
+        exit (EXIT_FAILURE);
+    }
+    if (splitLocks && (logMode == LOGDIRECT)) {
+        logMode = LOGRING;                        /* no write is made holding the log lock, the drainer writes */
+    }
+    if (noLog) {
+        logMode = LOGNONE;
+    }
+    if (optind < argc) {
+        strcpy(nFic, argv[optind]);
     }
     else strcpy(nFic, "");
 
     /* composing command line */
-    if ((key = ftok (".", 'a')) == -1) {
-        perror ("error on generating the key");
-        exit (EXIT_FAILURE);
+    if (key == IPC_PRIVATE) {                                              /* key not given on the command line */
+#if defined (THREADED) || defined (FORKED)
+        key = (int) getpid ();                                /* shared data and semaphores are process-private */
+#else
+        if ((key = ftok (".", 'a')) == -1) {
+            perror ("error on generating the key");
+            exit (EXIT_FAILURE);
+        }
+#endif
     }
     sprintf (num[1], "%d", key);
 
+    FILE *fp = fopen("config.txt","r");
+    if(fp==NULL) {
+        perror("Could not open config file");
+        exit(EXIT_FAILURE);
+    }
+
+    /* parse config file */
+    fscanf(fp,"%*[^\n]");
+    fscanf(fp,"%d ",&nGroups);
+    if (fgets(header, sizeof (header), fp) == NULL) {
+        header[0] = '\0';
+    }
+    if ((nGroups < 1) || (nGroups > MAXPOPULATION)) {
+        fprintf(stderr, "Number of groups must be between 1 and %d!\n", MAXPOPULATION);
+        exit(EXIT_FAILURE);
+    }
+    startTime = malloc(nGroups * sizeof (int));
+    eatTime = malloc(nGroups * sizeof (int));
+    if ((startTime == NULL) || (eatTime == NULL)) {
+        perror("error on allocating the groups times");
+        exit(EXIT_FAILURE);
+    }
+    if (strncmp(header, "#arrivals", 9) == 0) {                     /* the times are expanded from a scenario */
+        if (parseScenario(header + 9, &scenario) == -1) {
+            fprintf(stderr, "Invalid scenario in config file!\n");
+            exit(EXIT_FAILURE);
+        }
+        expandScenario(&scenario, nGroups, startTime, eatTime);
+    }
+    else for(g=0;g < nGroups;g++) {
+       fscanf(fp,"%d %d", &startTime[g], &eatTime[g]);
+    }
+    if (fscanf(fp," #ntables %d", &nTables) != 1) {                                 /* number of tables is optional */
+        nTables = NUMTABLES;
+    }
+    if (fscanf(fp," #nwaiters %d", &nWaiters) != 1) {                             /* number of waiters is optional */
+        nWaiters = 1;
+    }
+    if (fscanf(fp," #nchefs %d", &nChefs) != 1) {                                   /* number of chefs is optional */
+        nChefs = 1;
+    }
+    fclose(fp);
+    if ((nTables < 1) || (nTables > MAXTABLES)) {
+        fprintf(stderr, "Number of tables must be between 1 and %d!\n", MAXTABLES);
+        exit(EXIT_FAILURE);
+    }
+    if ((nWaiters < 1) || (nWaiters > MAXSTAFF) || (nChefs < 1) || (nChefs > MAXSTAFF)) {
+        fprintf(stderr, "Number of waiters and of chefs must be between 1 and %d!\n", MAXSTAFF);
+        exit(EXIT_FAILURE);
+    }
+    if (eventStaff && (nWaiters != 1)) {
+        fprintf(stderr, "The event-driven staff requires a single waiter!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* seed of the random streams and recorded order */
+    if (replayMode == REPLAYENFORCE) {
+        if ((entries = readReplay (orderFic, &seed, population, &nEntries)) == NULL) {
+            perror ("error on reading the recorded order");
+            exit (EXIT_FAILURE);
+        }
+        if ((population[0] != nGroups) || (population[1] != nWaiters) || (population[2] != nChefs)) {
+            fprintf (stderr, "The recorded order was recorded with a different configuration!\n");
+            exit (EXIT_FAILURE);
+        }
+        capacity = nEntries;
+    }
+    else if (!seeded) {
+        seed = ((unsigned long) time (NULL) << 20) ^ (unsigned long) getpid ();
+    }
+    if (replayMode == REPLAYRECORD) {
+        capacity = REPLAYPERGROUP * (nGroups + 1) * (splitLocks ? 2 : 1);      /* and the downs of the log lock */
+    }
+    replaySpace = replayBytes (capacity);
+
     /* creating and initializing the shared memory region and the log file */
-    if ((shmid = shmemCreate (key, sizeof (SHARED_DATA))) == -1) { 
+    tablesBytes = CACHELINES (nTables * sizeof (TABLE_SYNC));
+    apartGroups = apartGroups || (nGroups > MAXGROUPS);
+    if (apartGroups) {                          /* start time, eat time, semaphore, group state and table arrays */
+        arrayBytes = CACHELINES (nGroups * sizeof (int));
+        groupsBytes = 5 * arrayBytes;
+    }
+    if (logMode == LOGRING) {
+        while ((ringSize > 64) && (logRingBytes (ringSize, nGroups) > LOGRINGMAXBYTES)) {
+            ringSize /= 2;
+        }
+        ringBytes = logRingBytes (ringSize, nGroups);
+    }
+    if (virtualTime) {
+        timersBytes = clockBytes (nGroups + nWaiters + nChefs + 1);
+    }
+    latencyOff = (sizeof (SHARED_DATA) + tablesBytes + groupsBytes + ringBytes + timersBytes + replaySpace + 7) &
+                 ~7UL;                                                         /* aligned for the histograms */
+    nSems = 13 + nGroups + 4 * nTables + 2 * (nGroups + nWaiters + nChefs + 1);     /* clock and replay at most */
+    if (latencyStats) {
+        latencySpace = latencyBytes (nGroups, nSems);
+    }
+    statsOff = (latencyOff + latencySpace + 7) & ~7UL;
+#ifdef SEMPROFILE
+    statsBytes = semStatsBytes (nSems, MEMBERKINDS);                  /* instrumented semaphore module */
+#endif
+    snapOff = statsOff + statsBytes;
+    regionBytes = snapOff + logSnapshotBytes (nGroups);
+    if ((shmid = shmemCreatePlaced (key, regionBytes, placement)) == -1) { 
         perror ("error on creating the shared memory region");
         exit (EXIT_FAILURE);
     }
@@ -88,37 +722,65 @@ int main (int argc, char *argv[])
         perror ("error on mapping the shared region on the process address space");
         exit (EXIT_FAILURE);
     }
+    if (shmemPlace (shmid, sh, placement, node) == -1) {                     /* before the region is touched */
+        perror ("error on placing the shared region");
+        exit (EXIT_FAILURE);
+    }
+    sh->placement = placement;
+    sh->schedPolicy = schedPolicy;
 
     /* initialize random generator */
     srandom ((unsigned int) getpid ());                                
 
     /* initialize problem internal status */
+    sh->fSt.nGroups             = nGroups;
+    sh->nTables                 = nTables;
+    sh->tablesOff               = sizeof (SHARED_DATA);
+    if (!apartGroups) {                            /* fixed size arrays, as expected by the reference binaries */
+        sh->groups.groupStat     = offsetof (FULL_STAT, st.groupStat);
+        sh->groups.startTime     = offsetof (FULL_STAT, startTime);
+        sh->groups.eatTime       = offsetof (FULL_STAT, eatTime);
+        sh->groups.assignedTable = offsetof (FULL_STAT, assignedTable);
+        sh->waitForTableOff      = offsetof (SHARED_DATA, waitForTable);
+    }
+    else {              /* arrays that follow the table synchronization array, those only read coming first */
+        groupsOff                = sh->tablesOff + tablesBytes;
+        sh->groups.startTime     = groupsOff;
+        sh->groups.eatTime       = groupsOff + arrayBytes;
+        sh->waitForTableOff      = groupsOff + 2 * arrayBytes;
+        sh->groups.groupStat     = groupsOff + 3 * arrayBytes;
+        sh->groups.assignedTable = groupsOff + 4 * arrayBytes;
+    }
     sh->fSt.st.chefStat         = WAIT_FOR_ORDER;                     /* the chef waits for an order */
     sh->fSt.st.waiterStat       = WAIT_FOR_REQUEST;                /* the waiter waits for a request */
     sh->fSt.st.receptionistStat = WAIT_FOR_REQUEST;          /* the receptionist waits for a request */
-    for (g = 0; g < MAXGROUPS; g++) {
-        sh->fSt.st.groupStat[g] = GOTOREST;                                /* groups are initialized */
-        sh->fSt.assignedTable[g] = -1;                                     /* groups are initialized */
+    for (g = 0; g < nGroups; g++) {
+        GROUPSTAT(g)            = GOTOREST;                                /* groups are initialized */
+        ASSIGNEDTABLE(g)        = -1;                                      /* groups are initialized */
+        STARTTIME(g)            = startTime[g];
+        EATTIME(g)              = eatTime[g];
     }
     sh->fSt.groupsWaiting=0;
-
-    FILE *fp = fopen("config.txt","r");
-    if(fp==NULL) {
-        perror("Could not open config file");
-        exit(EXIT_FAILURE);
-    }
-
-    /* parse config file */
-    fscanf(fp,"%*[^\n]");
-    fscanf(fp,"%d ",&sh->fSt.nGroups);
-    fscanf(fp,"%*[^\n]");
-    for(g=0;g < sh->fSt.nGroups;g++) {
-       fscanf(fp,"%d %d", &sh->fSt.startTime[g], &sh->fSt.eatTime[g]);
+    sh->foodReady.reqType = -1;
+    sh->foodReady.reqGroup = -1;
+    initMailbox (&sh->receptionistBox, &sh->fSt.receptionistRequest, mailboxSize);
+    initMailbox (&sh->waiterBox, &sh->fSt.waiterRequest, mailboxSize);
+    if (notifyCreate (&sh->notify, eventStaff ? NOTIFYSOURCES : 0) == -1) {  /* inherited by the entities */
+        perror ("error on creating the notification of requests");
+        exit (EXIT_FAILURE);
     }
-   
-    /* create log file */
-    createLog (nFic, &sh->fSt);                                  
-    saveState(nFic,&sh->fSt);
+    sh->nWaiters                = nWaiters;
+    sh->nChefs                  = nChefs;
+    sh->queueOrders             = (nWaiters > 1) || (nChefs > 1) ||        /* single slot of the reference binaries */
+                                  (nTables > NUMTABLES) || (mailboxSize > 1) || pipelinedKitchen;
+    sh->pipelinedKitchen        = pipelinedKitchen;
+    sh->orders.head             = 0;
+    sh->orders.count            = 0;
+    sh->orders.size             = nTables;                                      /* at most one order per table */
+    sh->requestsToServe         = 2 * nGroups;                  /* a food request and the food of each group */
+    sh->ordersToCook            = nGroups;
+    free (startTime);
+    free (eatTime);
 
     /* initialize semaphore ids */
     sh->mutex                       = MUTEX;                                /* mutual exclusion semaphore id */
@@ -128,14 +790,53 @@ int main (int argc, char *argv[])
     sh->waiterRequestPossible       = WAITERREQUESTPOSSIBLE;                                                      
     sh->waitOrder                   = WAITORDER;                                                      
     sh->orderReceived               = ORDERRECEIVED;                                                      
+    sh->foodReadyPossible           = FOODREADYPOSSIBLE;
+    sh->orderSlots                  = ORDERSLOTS;
     for(g=0;g<sh->fSt.nGroups;g++) {
-       sh->waitForTable[g]          = WAITFORTABLE+g;                                                      
+       GROUPWAIT(g)                 = WAITFORTABLE+g;                                                      
+    }
+    for(t=0;t<nTables;t++) {
+       TABLESYNC(t).foodArrived     = FOODARRIVED+t;                                                      
+       TABLESYNC(t).tableDone       = TABLEDONE+t;                                                      
+       TABLESYNC(t).requestReceived = REQUESTRECEIVED+t;                              
+    }
+    for(t=0;(t<nTables) && (t<NUMTABLES);t++) {                   /* fixed size arrays used by reference binaries */
+       sh->foodArrived[t]           = TABLESYNC(t).foodArrived;
+       sh->tableDone[t]             = TABLESYNC(t).tableDone;
+       sh->requestReceived[t]       = TABLESYNC(t).requestReceived;
+    }
+    if (splitLocks) {
+        sh->receptionLock           = RECEPTIONLOCK;
+        sh->kitchenLock             = KITCHENLOCK;
+        for(t=0;t<nTables;t++) {
+           TABLESYNC(t).tableLock   = TABLELOCK+t;
+        }
+    }
+    else {                                                    /* all locks are the mutual exclusion semaphore */
+        sh->receptionLock           = MUTEX;
+        sh->kitchenLock             = MUTEX;
+        for(t=0;t<nTables;t++) {
+           TABLESYNC(t).tableLock   = MUTEX;
+        }
+    }
+    if (virtualTime) {                                         /* all entities are members of the virtual clock */
+        initClock (&sh->clock, (char *) sh + sh->tablesOff + tablesBytes + groupsBytes + ringBytes,
+                   nGroups + nWaiters + nChefs + 1, RUNNING, WAKEUP);
+    }
+    else {
+        sh->clock.enabled           = 0;
+        sh->clock.members           = 0;
     }
-    for(t=0;t<NUMTABLES;t++) {
-       sh->foodArrived[t]           = FOODARRIVED+t;                                                      
-       sh->tableDone[t]             = TABLEDONE+t;                                                      
-       sh->requestReceived[t]       = REQUESTRECEIVED+t;                              
+    sh->seed                        = seed;
+    initReplay (&sh->replay, (char *) sh + sh->tablesOff + tablesBytes + groupsBytes + ringBytes + timersBytes,
+                replayMode, capacity, entries, nEntries, nGroups, nWaiters, nChefs, TURN);
+    free (entries);
+    initLatency (&sh->lat, latencyStats ? (char *) sh + latencyOff : NULL, nGroups, SEM_NU + 1);
+    if (statsBytes != 0) {
+        sh->statsOff = statsOff;
+        semInitStats (SEMSTATS, SEM_NU + 1, MEMBERKINDS);
     }
+    else sh->statsOff = 0;
 
     /* creating and initializing the semaphore set */
     if ((semgid = semCreate (key, SEM_NU)) == -1) { 
@@ -146,85 +847,314 @@ int main (int argc, char *argv[])
         perror ("error on executing the up operation for semaphore access");
         exit (EXIT_FAILURE);
     }
-    if (semUp (semgid, sh->waiterRequestPossible) == -1) {                   /* enabling access to critical region */
+    SEM_OP boxes[] = {{sh->waiterRequestPossible, mailboxSize}, {sh->receptionistRequestPossible, mailboxSize}};
+    if (semOpMulti (semgid, boxes, 2) == -1) {                          /* all slots of the mailboxes are vacant */
         perror ("error on executing the up operation for semaphore access");
         exit (EXIT_FAILURE);
     }
-    if (semUp (semgid, sh->receptionistRequestPossible) == -1) {                   /* enabling access to critical region */
+    if (virtualTime) {                                                      /* all entities start running */
+        SEM_OP running[] = {{sh->clock.running, sh->clock.live}};
+
+        if (semWaitZero (semgid, sh->clock.running) == -1) {           /* supported by the semaphore backend */
+            perror ("virtual clock requires the System V semaphores");
+            exit (EXIT_FAILURE);
+        }
+        if (semOpMulti (semgid, running, 1) == -1) {
+            perror ("error on executing the up operation for semaphore access");
+            exit (EXIT_FAILURE);
+        }
+    }
+    if (semUp (semgid, sh->foodReadyPossible) == -1) {                             /* enabling access to critical region */
         perror ("error on executing the up operation for semaphore access");
         exit (EXIT_FAILURE);
     }
+    if (sh->queueOrders) {                                             /* all slots of the order queue are vacant */
+        SEM_OP slots[] = {{sh->orderSlots, nTables}};
 
-    /* generation of intervening entities processes */                            
-    /* group processes */
-    strcpy (nFicErr + 6, "GR");
-    for (g = 0; g < sh->fSt.nGroups; g++) {           
-        if ((pidGR[g] = fork ()) < 0) {
-            perror ("error on the fork operation for the group");
+        if (semOpMulti (semgid, slots, 1) == -1) {
+            perror ("error on executing the up operation for semaphore access");
             exit (EXIT_FAILURE);
         }
-        sprintf(num[0],"%d",g);
-        sprintf(nFicErr+8,"%02d",g); 
-        if (pidGR[g] == 0)
-            if (execl (GROUP, GROUP, num[0], nFic, num[1], nFicErr, NULL) < 0) { 
-                perror ("error on the generation of the group process");
-                exit (EXIT_FAILURE);
-            }
     }
-    /* waiter process */
-    strcpy (nFicErr + 6, "WT");
-    if ((pidWT = fork ()) < 0)  {                            
-        perror ("error on the fork operation for the waiter");
-        exit (EXIT_FAILURE);
+    if (splitLocks) {                                          /* enabling access to split locks and the log lock */
+        SEM_OP locks[3 + MAXTABLES];
+
+        locks[0].sindex = sh->receptionLock;
+        locks[1].sindex = sh->kitchenLock;
+        locks[2].sindex = LOGLOCK;
+        for(t=0;t<nTables;t++) {
+           locks[3+t].sindex = TABLESYNC(t).tableLock;
+        }
+        for(t=0;t<3+nTables;t++) {
+           locks[t].delta = 1;
+        }
+        if (semOpMulti (semgid, locks, 3 + nTables) == -1) {
+            perror ("error on executing the up operation for semaphore access");
+            exit (EXIT_FAILURE);
+        }
     }
-    if (pidWT == 0) {
-        if (execl (WAITER, WAITER, nFic, num[1], nFicErr, NULL) < 0) {
-            perror ("error on the generation of the waiter process");
+
+    startReplay (semgid, &sh->replay);                            /* the member of the first entry gets its turn */
+
+    /* saving the shared region and the values of the semaphore set, restored before every other run */
+    if (runs > 1) {
+        if (((image = malloc (regionBytes)) == NULL) ||
+            ((semValues = malloc ((SEM_NU + 1) * sizeof (unsigned short))) == NULL)) {
+            perror ("error on allocating the saved shared region");
+            exit (EXIT_FAILURE);
+        }
+        memcpy (image, sh, regionBytes);
+        if (semGetAll (semgid, semValues) == -1) {
+            perror ("error on reading the values of the semaphore set");
             exit (EXIT_FAILURE);
         }
     }
-    /* chef process */
-    strcpy (nFicErr + 6, "CH");
-    if ((pidCH = fork ()) < 0) {               
-        perror ("error on the fork operation for the chef");
+#ifdef FORKED
+    poolRuns = runs;
+    if ((poolgid = semCreate (key ^ POOLKEYMASK, POOLDONE)) == -1) {
+        perror ("error on creating the semaphore set of the pool");
         exit (EXIT_FAILURE);
     }
-    if (pidCH == 0)
-        if (execl (CHEF, CHEF, nFic, num[1], nFicErr, NULL) < 0) { 
-            perror ("error on the generation of the chef process");
+    drainer.pid = 0;                                                             /* not a worker of the pool yet */
+#endif
+    clock_gettime (CLOCK_MONOTONIC, &runsStart);
+
+    for (run = 0; run < runs; run++) {
+        if (run > 0) {                     /* the shared region and the semaphores as before the first run */
+            memcpy (sh, image, regionBytes);
+            if (semSetAll (semgid, semValues) == -1) {
+                perror ("error on setting the values of the semaphore set");
+                exit (EXIT_FAILURE);
+            }
+            if (replayMode != REPLAYENFORCE) {
+                sh->seed = seed + run;
+            }
+        }
+
+
+        /* create log file */
+        sh->log.mode = LOGDIRECT;
+        sh->log.format = logFormat;
+        sh->log.nTables = nTables;
+        sh->log.groups = sh->groups;
+        sh->log.lockSem = splitLocks ? LOGLOCK : 0;
+        sh->log.coalesce = coalesce;
+        if (logMode == LOGRING) {
+            initLogRing (&sh->log, (char *) sh + sh->tablesOff + tablesBytes + groupsBytes, ringSize, nGroups);
+        }
+        initLogSnapshot (&sh->log, (char *) sh + snapOff, nGroups);
+        if (logMode == LOGNONE) {
+            sh->log.mode = LOGNONE;
+        }
+        else if (logFormat == LOGBINARY) {
+            createTrace (nFic, &sh->fSt, nTables);
+        }
+        else if ((logFormat == LOGJSON) || (logFormat == LOGCSV)) {
+            createEventLog (nFic, logFormat);
+        }
+        else createLog (nFic, &sh->fSt);                                  
+        openLogSession (nFic, &sh->log, semgid);
+        saveState(nFic,&sh->fSt);
+        closeLogSession ();
+
+        /* generation of intervening entities processes */                            
+    #ifdef THREADED
+        openLogSession (nFic, &sh->log, semgid);                        /* logging file shared by the sessions of the threads */
+    #endif
+        /* log drainer process */
+        if (logMode == LOGRING) {
+    #ifdef THREADED
+            drainFic = nFic;
+            drainConf = &sh->log;
+            if ((stat = pthread_create (&thrLG, NULL, drainerLife, NULL)) != 0) {
+                fprintf (stderr, "error on creating the log drainer thread: %s\n", strerror (stat));
+                exit (EXIT_FAILURE);
+            }
+    #elif defined (FORKED)
+            strcpy (nFicErr + 6, "LG");
+            drainFic = nFic;
+            drainConf = &sh->log;
+            args[0] = "drainer"; args[1] = nFicErr; args[2] = NULL;
+            startEntity (&drainer, NULL, drainerMain, args, "log drainer");
+    #else
+            strcpy (nFicErr + 6, "LG");
+            if ((pidLG = fork ()) < 0) {
+                perror ("error on the fork operation for the log drainer");
+                exit (EXIT_FAILURE);
+            }
+            if (pidLG == 0) {
+                freopen (nFicErr, "w", stderr);
+                setbuf (stderr, NULL);
+                drainLog (nFic, &sh->log);
+                exit (EXIT_SUCCESS);
+            }
+    #endif
+        }
+        /* clock advancer process */
+        if (virtualTime) {
+            strcpy (nFicErr + 6, "CK");
+            if ((pidCK = fork ()) < 0) {
+                perror ("error on the fork operation for the clock advancer");
+                exit (EXIT_FAILURE);
+            }
+            if (pidCK == 0) {
+                freopen (nFicErr, "w", stderr);
+                setbuf (stderr, NULL);
+                runClock (semgid, &sh->clock);
+                exit (EXIT_SUCCESS);
+            }
+        }
+        nHosts = (nGroups + groupsPerHost - 1) / groupsPerHost;
+        nEnt = nHosts + nChefs + (eventStaff ? 1 : nWaiters + 1);
+        if ((run == 0) && ((ent = calloc (nEnt, sizeof (ENTITY))) == NULL)) {
+            perror ("error on allocating the intervening entities");
             exit (EXIT_FAILURE);
         }
+        m = 0;
+        /* group processes */
+        strcpy (nFicErr + 6, "GR");
+        for (h = 0; h < nHosts; h++) {           
+            g = h * groupsPerHost;                                                  /* first group hosted by the process */
+            sprintf(num[0],"%d",g);
+            sprintf(nFicErr+8,"%02d",g % MAXPOPULATION); 
+            sprintf(nHosted,"%d",(nGroups - g < groupsPerHost) ? nGroups - g : groupsPerHost);
+            args[0] = GROUP; args[1] = num[0]; args[2] = nFic; args[3] = num[1]; args[4] = nFicErr;
+            args[5] = (groupsPerHost == 1) ? NULL : nHosted;
+            args[6] = NULL;
+            startEntity (&ent[m++], GROUP, ENTRY (groupMain), args, "group");
+        }
+        /* waiter processes */
+        strcpy (nFicErr + 6, "WT");
+        args[0] = WAITER; args[1] = nFic; args[2] = num[1]; args[3] = nFicErr; args[4] = NULL;
+        for (h = 0; !eventStaff && (h < nWaiters); h++) {
+            if (nWaiters > 1) {
+                sprintf(nFicErr+8,"%02d",h % MAXSTAFF);
+            }
+            startEntity (&ent[m++], WAITER, ENTRY (waiterMain), args, "waiter");
+        }
+        /* chef processes */
+        strcpy (nFicErr + 6, "CH");
+        args[0] = CHEF;
+        for (h = 0; h < nChefs; h++) {
+            if (nChefs > 1) {
+                sprintf(nFicErr+8,"%02d",h % MAXSTAFF);
+            }
+            startEntity (&ent[m++], CHEF, ENTRY (chefMain), args, "chef");
+        }
 
-    /* receptionist process */
-    strcpy (nFicErr + 6, "RT");
-    if ((pidRT = fork ()) < 0) {               
-        perror ("error on the fork operation for the chef");
-        exit (EXIT_FAILURE);
-    }
-    if (pidRT == 0)
-        if (execl (RECEPTIONIST, RECEPTIONIST, nFic, num[1], nFicErr, NULL) < 0) { 
-            perror ("error on the generation of the receptionist process");
+        /* receptionist process (or event-driven staff, receptionist and waiter) */
+        if (eventStaff) {
+            strcpy (nFicErr + 6, "ST");
+            args[0] = "staff";
+            startEntity (&ent[m++], NULL, ENTRY (staffMain), args, "event-driven staff");
+        }
+        else {
+            strcpy (nFicErr + 6, "RT");
+            args[0] = RECEPTIONIST;
+            startEntity (&ent[m++], RECEPTIONIST, ENTRY (receptionistMain), args, "receptionist");
+        }
+    #ifdef FORKED
+        startPool (nEnt + (logMode == LOGRING));                          /* the workers of the pool start the run */
+    #endif
+
+        /* signaling start of operations */
+        if (semSignal (semgid) == -1) {
+            perror ("error on signaling start of operations");
             exit (EXIT_FAILURE);
         }
 
-    /* signaling start of operations */
-    if (semSignal (semgid) == -1) {
-        perror ("error on signaling start of operations");
+        /* waiting for the termination of the intervening entities processes (for the end of the run, in the pool) */
+    #ifdef FORKED
+        waitPool (nEnt);
+    #else
+        for (m = 0; m < nEnt; m++) {
+            waitEntity (&ent[m]);
+        }
+        free (ent);
+    #endif
+
+        /* waiting for the log drainer to write the remaining snapshots */
+        if (logMode == LOGRING) {
+            stopLogDrainer (&sh->log);
+    #ifdef THREADED
+            if ((stat = pthread_join (thrLG, NULL)) != 0) {
+                fprintf (stderr, "error on waiting for the log drainer: %s\n", strerror (stat));
+                exit (EXIT_FAILURE);
+            }
+    #elif defined (FORKED)
+            waitPool (1);
+    #else
+            if (waitpid (pidLG, &status, 0) == -1) {
+                perror ("error on waiting for the log drainer");
+                exit (EXIT_FAILURE);
+            }
+    #endif
+        }
+    #ifdef THREADED
+        closeLogSession ();
+    #endif
+
+        /* waiting for the clock advancer */
+        if (pidCK != -1) {
+            if (waitpid (pidCK, &status, 0) == -1) {
+                perror ("error on waiting for the clock advancer");
+                exit (EXIT_FAILURE);
+            }
+        }
+
+        /* printing the coalesced state saves, the latency statistics and the contention profile */
+        if (coalesce) {
+            fprintf (stderr, "%lu of %lu state saves coalesced\n", sh->log.snap.coalesced,
+                     sh->log.snap.states + sh->log.snap.coalesced);
+        }
+        nRanges = semRanges (sh, ranges);
+        if (latencyStats) {
+            printLatency (stderr, &sh->lat, ranges, nRanges);
+            printUtilization (stderr, &sh->lat, sh->nTables, schedName[sh->schedPolicy]);
+        }
+        if (sh->statsOff != 0) {
+            printContention (stderr, SEMSTATS, ranges, nRanges);
+        }
+
+        /* writing the recorded order or checking that the whole recorded order was imposed */
+        if ((replayMode == REPLAYRECORD) && (writeReplay (&sh->replay, orderFic, sh->seed) == -1)) {
+            perror ("error on writing the recorded order");
+            exitStat = EXIT_FAILURE;
+        }
+        if ((replayMode == REPLAYENFORCE) && (sh->replay.next != sh->replay.length)) {
+            fprintf (stderr, "The run diverged from the recorded order (%u of %u downs imposed)!\n",
+                     sh->replay.next, sh->replay.length);
+            exitStat = EXIT_FAILURE;
+        }
+
+    }
+    clock_gettime (CLOCK_MONOTONIC, &runsEnd);
+    free (image);
+    free (semValues);
+#ifdef FORKED
+
+    /* waiting for the termination of the workers of the pool */
+    for (m = 0; m < nEnt; m++) {
+        waitEntity (&ent[m]);
+    }
+    free (ent);
+    if (logMode == LOGRING) {
+        waitEntity (&drainer);
+    }
+    if (semDestroy (poolgid) == -1) {
+        perror ("error on destructing the semaphore set of the pool");
         exit (EXIT_FAILURE);
     }
+#endif
+    if (runs > 1) {
+        double elapsed = (runsEnd.tv_sec - runsStart.tv_sec) + (runsEnd.tv_nsec - runsStart.tv_nsec) / 1e9;
+
+        fprintf (stderr, "%d runs in %.3f s (%.3f ms per run)\n", runs, elapsed, elapsed * 1000 / runs);
+    }
 
-    /* waiting for the termination of the intervening entities processes */
-    m = 0;
-    do {
-        info = wait (&status);
-        if (info == -1) { 
-            perror ("error on aiting for an intervening process");
-            exit (EXIT_FAILURE);
-        }
-        m += 1;
-    } while (m < 3+sh->fSt.nGroups);
 
-    /* destruction of semaphore set and shared region */
+    /* destruction of the notification of requests, semaphore set and shared region */
+    notifyDestroy (&sh->notify);
     if (semDestroy (semgid) == -1) {
         perror ("error on destructing the semaphore set");
         exit (EXIT_FAILURE);
@@ -238,5 +1168,5 @@ int main (int argc, char *argv[])
         exit (EXIT_FAILURE);
     }
 
-    return EXIT_SUCCESS;
+    return exitStat;
 }
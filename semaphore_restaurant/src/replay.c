@@ -0,0 +1,281 @@
+/**
+ *  \file replay.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Record and replay of the order of the downs.
+ *
+ *  Operations defined on the replay:
+ *     \li size of the entries
+ *     \li initialization and start of the imposed order
+ *     \li joining the replay and leaving it
+ *     \li writing the recorded order to a file and reading it back.
+ *
+ *  The downs of a member are sequenced by the semaphore module. When the order is imposed, the member waits on its
+ *  turn semaphore before each down; once the down is carried out, the turn is passed to the member of the next
+ *  entry. Every member owns at most one turn at a time, so that a turn semaphore is never above one, except when
+ *  the order is no longer imposed and every member is released.
+ *
+ *  The file holds a header line (seed, numbers of groups, waiters and chefs, number of entries) and one line per
+ *  entry (member and number of downs, -1 for a blocking down).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "semaphore.h"
+#include "replay.h"
+
+/** \brief entries of the replay */
+#define  ENTRIES(rp)     ((REPLAY_ENTRY *) ((char *) (rp) + (rp)->entriesOff))
+
+/** \brief member of the replay of the calling thread */
+static __thread int member = -1;
+
+/** \brief semaphore set access identifier of the calling thread */
+static __thread int semgidRP;
+
+/** \brief sequencer of the downs of the calling thread */
+static __thread SEM_SEQUENCER sequencer;
+
+/* internal functions */
+
+static void release (REPLAY *rp)
+{
+    unsigned int m;
+
+    if (__atomic_exchange_n (&rp->done, 1, __ATOMIC_SEQ_CST)) {
+        return;
+    }
+    for (m = 0; m < rp->members; m++) {                         /* members waiting for their turn are released */
+        if (semUp (semgidRP, rp->turn + m) == -1) {
+            perror ("error on the up operation for the turn semaphore");
+            exit (EXIT_FAILURE);
+        }
+    }
+}
+
+static int enterTurn (void *arg, int max)
+{
+    REPLAY *rp = arg;
+    REPLAY_ENTRY *e;
+
+    if ((rp->mode != REPLAYENFORCE) || __atomic_load_n (&rp->done, __ATOMIC_SEQ_CST)) {
+        return -1;
+    }
+    if (semDown (semgidRP, rp->turn + member) == -1) {                                  /* wait for its turn */
+        perror ("error on the down operation for the turn semaphore");
+        exit (EXIT_FAILURE);
+    }
+    if (__atomic_load_n (&rp->done, __ATOMIC_SEQ_CST)) {
+        return -1;
+    }
+    e = &ENTRIES (rp)[rp->next];
+    if ((e->member != member) || ((e->result < 0) != (max < 0)) || (e->result > max)) {
+        fprintf (stderr, "replay: the run diverged from the recorded order at entry %u\n", rp->next);
+        release (rp);
+        return -1;
+    }
+    return e->result;
+}
+
+static void leaveTurn (void *arg, int result)
+{
+    REPLAY *rp = arg;
+    unsigned int pos;
+
+    if (rp->mode == REPLAYRECORD) {
+        if ((pos = __atomic_fetch_add (&rp->length, 1, __ATOMIC_SEQ_CST)) < rp->capacity) {
+            ENTRIES (rp)[pos].member = member;
+            ENTRIES (rp)[pos].result = result;
+        }
+    }
+    else if ((rp->mode == REPLAYENFORCE) && !__atomic_load_n (&rp->done, __ATOMIC_SEQ_CST)) {
+        if (++rp->next == rp->length) {                                        /* every entry was imposed */
+            release (rp);
+        }
+        else if (semUp (semgidRP, rp->turn + ENTRIES (rp)[rp->next].member) == -1) {           /* pass the turn */
+            perror ("error on the up operation for the turn semaphore");
+            exit (EXIT_FAILURE);
+        }
+    }
+}
+
+/* external functions */
+
+/**
+ *  \brief Size of the entries of the replay.
+ *
+ *  \param capacity maximum number of entries
+ *
+ *  \return number of bytes required by the entries
+ */
+unsigned long replayBytes (unsigned int capacity)
+{
+    return capacity * sizeof (REPLAY_ENTRY);
+}
+
+/**
+ *  \brief Replay initialization.
+ *
+ *  \param rp pointer to the replay
+ *  \param space pointer to the space reserved for the entries (in shared memory)
+ *  \param mode replay mode (REPLAYOFF, REPLAYRECORD or REPLAYENFORCE)
+ *  \param capacity maximum number of entries
+ *  \param entries entries to be imposed (REPLAYENFORCE mode)
+ *  \param length number of entries to be imposed
+ *  \param nGroups number of groups
+ *  \param nWaiters number of waiters
+ *  \param nChefs number of chefs
+ *  \param turn identification of the turn semaphore of the first member
+ */
+void initReplay (REPLAY *rp, void *space, int mode, unsigned int capacity, REPLAY_ENTRY *entries,
+                 unsigned int length, unsigned int nGroups, unsigned int nWaiters, unsigned int nChefs,
+                 unsigned int turn)
+{
+    rp->mode = mode;
+    rp->members = (mode == REPLAYOFF) ? 0 : nGroups + nWaiters + nChefs + 1;
+    rp->turn = turn;
+    rp->first[MEMBERGROUP] = 0;
+    rp->first[MEMBERWAITER] = nGroups;
+    rp->first[MEMBERCHEF] = nGroups + nWaiters;
+    rp->first[MEMBERRECEPTIONIST] = nGroups + nWaiters + nChefs;
+    memset (rp->joined, 0, sizeof (rp->joined));
+    rp->capacity = capacity;
+    rp->length = (mode == REPLAYENFORCE) ? length : 0;
+    rp->next = 0;
+    rp->done = (mode != REPLAYENFORCE) || (length == 0);
+    rp->entriesOff = (char *) space - (char *) rp;
+    if (mode == REPLAYENFORCE) {
+        memcpy (ENTRIES (rp), entries, length * sizeof (REPLAY_ENTRY));
+    }
+}
+
+/**
+ *  \brief Start of the imposed order: the member of the first entry gets its turn.
+ *
+ *  \param semgid semaphore set access identifier
+ *  \param rp pointer to the replay
+ */
+void startReplay (int semgid, REPLAY *rp)
+{
+    if ((rp->mode == REPLAYENFORCE) && !rp->done && (semUp (semgid, rp->turn + ENTRIES (rp)[0].member) == -1)) {
+        perror ("error on the up operation for the turn semaphore");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief Joining the replay: the downs of the calling thread are recorded or imposed from now on.
+ *
+ *  \param semgid semaphore set access identifier
+ *  \param rp pointer to the replay
+ *  \param kind kind of the member (MEMBERGROUP, MEMBERWAITER, MEMBERCHEF or MEMBERRECEPTIONIST)
+ *  \param id group id (-1 for the other entities, which are numbered as they join)
+ */
+void joinReplay (int semgid, REPLAY *rp, unsigned int kind, int id)
+{
+    if (rp->mode == REPLAYOFF) {
+        return;
+    }
+    member = rp->first[kind] + ((id >= 0) ? (unsigned int) id : __atomic_fetch_add (&rp->joined[kind], 1,
+                                                                                     __ATOMIC_RELAXED));
+    semgidRP = semgid;
+    sequencer.enter = enterTurn;
+    sequencer.leave = leaveTurn;
+    sequencer.arg = rp;
+    semSequence (&sequencer);
+}
+
+/**
+ *  \brief Leaving the replay: the downs of the calling thread are no longer recorded or imposed.
+ *
+ *  \param rp pointer to the replay
+ */
+void leaveReplay (REPLAY *rp)
+{
+    if (rp->mode == REPLAYOFF) {
+        return;
+    }
+    semSequence (NULL);
+    member = -1;
+}
+
+/**
+ *  \brief Writing the recorded order to a file.
+ *
+ *  The function fails with <tt>errno</tt> set to <tt>EOVERFLOW</tt> if more downs were carried out than there
+ *  are entries.
+ *
+ *  \param rp pointer to the replay
+ *  \param name name of the file
+ *  \param seed seed of the run
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int writeReplay (REPLAY *rp, char *name, unsigned long seed)
+{
+    FILE *fp;
+    unsigned int e;
+
+    if (rp->length > rp->capacity) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    if ((fp = fopen (name, "w")) == NULL) {
+        return -1;
+    }
+    fprintf (fp, "%lu %u %u %u %u\n", seed, rp->first[MEMBERWAITER], rp->first[MEMBERCHEF] - rp->first[MEMBERWAITER],
+             rp->first[MEMBERRECEPTIONIST] - rp->first[MEMBERCHEF], rp->length);
+    for (e = 0; e < rp->length; e++) {
+        fprintf (fp, "%u %d\n", ENTRIES (rp)[e].member, ENTRIES (rp)[e].result);
+    }
+    return fclose (fp);
+}
+
+/**
+ *  \brief Reading a recorded order from a file.
+ *
+ *  \param name name of the file
+ *  \param pSeed pointer to the location where the seed of the recorded run is stored
+ *  \param population pointer to the location where the numbers of groups, waiters and chefs are stored
+ *  \param pLength pointer to the location where the number of entries is stored
+ *
+ *  \return entries (allocated in the heap), upon success
+ *  \return \c NULL, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+REPLAY_ENTRY *readReplay (char *name, unsigned long *pSeed, unsigned int population[3], unsigned int *pLength)
+{
+    FILE *fp;
+    REPLAY_ENTRY *entries;
+    unsigned int e;
+
+    if ((fp = fopen (name, "r")) == NULL) {
+        return NULL;
+    }
+    if (fscanf (fp, "%lu %u %u %u %u", pSeed, &population[0], &population[1], &population[2], pLength) != 5) {
+        fclose (fp);
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((entries = malloc ((*pLength + 1) * sizeof (REPLAY_ENTRY))) == NULL) {
+        fclose (fp);
+        return NULL;
+    }
+    for (e = 0; e < *pLength; e++) {
+        if ((fscanf (fp, "%u %d", &entries[e].member, &entries[e].result) != 2) ||
+            (entries[e].member >= population[0] + population[1] + population[2] + 1)) {
+            free (entries);
+            fclose (fp);
+            errno = EINVAL;
+            return NULL;
+        }
+    }
+    fclose (fp);
+    return entries;
+}
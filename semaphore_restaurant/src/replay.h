@@ -0,0 +1,112 @@
+/**
+ *  \file replay.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Record and replay of the order of the downs.
+ *
+ *  Operations defined on the replay:
+ *     \li size of the entries
+ *     \li initialization and start of the imposed order
+ *     \li joining the replay and leaving it
+ *     \li writing the recorded order to a file and reading it back.
+ *
+ *  When recording, every <em>down</em> of a member (entering a critical region, waiting for a request, a table,
+ *  food or a wake-up) is appended to the entries as soon as it completes, by the member itself, so that the
+ *  recorded order agrees with the order in which the semaphores were actually taken. Non blocking <em>downs</em>
+ *  are recorded with the number of <em>downs</em> carried out.
+ *
+ *  When replaying, a member only carries out a <em>down</em> on its turn, which is passed along the recorded
+ *  order, and a non blocking <em>down</em> carries out the recorded number of <em>downs</em>. Together with the
+ *  seed of the recorded run, which gives the same times, the run goes through the same interleaving. If a member
+ *  carries out a <em>down</em> that does not agree with its entry, or every entry was imposed, the order is no
+ *  longer imposed.
+ */
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include "probDataStruct.h"
+
+/**
+ *  \brief Size of the entries of the replay.
+ *
+ *  \param capacity maximum number of entries
+ *
+ *  \return number of bytes required by the entries
+ */
+extern unsigned long replayBytes (unsigned int capacity);
+
+/**
+ *  \brief Replay initialization.
+ *
+ *  \param rp pointer to the replay
+ *  \param space pointer to the space reserved for the entries (in shared memory)
+ *  \param mode replay mode (REPLAYOFF, REPLAYRECORD or REPLAYENFORCE)
+ *  \param capacity maximum number of entries
+ *  \param entries entries to be imposed (REPLAYENFORCE mode)
+ *  \param length number of entries to be imposed
+ *  \param nGroups number of groups
+ *  \param nWaiters number of waiters
+ *  \param nChefs number of chefs
+ *  \param turn identification of the turn semaphore of the first member
+ */
+extern void initReplay (REPLAY *rp, void *space, int mode, unsigned int capacity, REPLAY_ENTRY *entries,
+                        unsigned int length, unsigned int nGroups, unsigned int nWaiters, unsigned int nChefs,
+                        unsigned int turn);
+
+/**
+ *  \brief Start of the imposed order: the member of the first entry gets its turn.
+ *
+ *  \param semgid semaphore set access identifier
+ *  \param rp pointer to the replay
+ */
+extern void startReplay (int semgid, REPLAY *rp);
+
+/**
+ *  \brief Joining the replay: the downs of the calling thread are recorded or imposed from now on.
+ *
+ *  \param semgid semaphore set access identifier
+ *  \param rp pointer to the replay
+ *  \param kind kind of the member (MEMBERGROUP, MEMBERWAITER, MEMBERCHEF or MEMBERRECEPTIONIST)
+ *  \param id group id (-1 for the other entities, which are numbered as they join)
+ */
+extern void joinReplay (int semgid, REPLAY *rp, unsigned int kind, int id);
+
+/**
+ *  \brief Leaving the replay: the downs of the calling thread are no longer recorded or imposed.
+ *
+ *  \param rp pointer to the replay
+ */
+extern void leaveReplay (REPLAY *rp);
+
+/**
+ *  \brief Writing the recorded order to a file.
+ *
+ *  The function fails with <tt>errno</tt> set to <tt>EOVERFLOW</tt> if more downs were carried out than there
+ *  are entries.
+ *
+ *  \param rp pointer to the replay
+ *  \param name name of the file
+ *  \param seed seed of the run
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int writeReplay (REPLAY *rp, char *name, unsigned long seed);
+
+/**
+ *  \brief Reading a recorded order from a file.
+ *
+ *  \param name name of the file
+ *  \param pSeed pointer to the location where the seed of the recorded run is stored
+ *  \param population pointer to the location where the numbers of groups, waiters and chefs are stored
+ *  \param pLength pointer to the location where the number of entries is stored
+ *
+ *  \return entries (allocated in the heap), upon success
+ *  \return \c NULL, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern REPLAY_ENTRY *readReplay (char *name, unsigned long *pSeed, unsigned int population[3],
+                                 unsigned int *pLength);
+
+#endif /* REPLAY_H_ */
@@ -0,0 +1,205 @@
+/**
+ *  \file scenario.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Scenarios: start and eat times of the groups drawn from an arrival pattern and an eat time distribution.
+ *
+ *  Operations defined on a scenario:
+ *     \li parsing of its description
+ *     \li expansion into the start and eat times of the groups
+ *     \li writing of its description.
+ *
+ *  Exponential times are drawn by inversion of the distribution function; times beyond the range of the start and
+ *  eat times of the configuration are cut at its maximum.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "probConst.h"
+#include "prng.h"
+#include "scenario.h"
+
+/** \brief names of the arrival patterns */
+static const char *arrivalName[] = { "uniform", "poisson", "bursty" };
+
+/** \brief names of the eat time distributions */
+static const char *eatName[] = { "fixed", "uniform", "exponential" };
+
+/* internal functions */
+
+static int nameIndex (const char *names[], int n, char *word)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        if ((word != NULL) && (strcmp (names[i], word) == 0)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool number (char *word, double *value)
+{
+    char *end;
+
+    if (word == NULL) {
+        return false;
+    }
+    *value = strtod (word, &end);
+    return (end != word) && (*end == '\0') && (*value >= 0.0);
+}
+
+static double exponential (PRNG *rng, double mean)
+{
+    return -log (1.0 - prngUniform (rng)) * mean;
+}
+
+static int usTime (double t)
+{
+    return (t < (double) INT_MAX) ? (int) t : INT_MAX;
+}
+
+/* external functions */
+
+/**
+ *  \brief Parsing of the description of a scenario.
+ *
+ *  \param spec description (what follows <tt>\#arrivals</tt>)
+ *  \param sc pointer to the location where the scenario is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when the description is not valid
+ */
+int parseScenario (char spec[], SCENARIO *sc)
+{
+    char buf[256];
+    char *word;
+    double value;
+
+    strncpy (buf, spec, sizeof (buf) - 1);
+    buf[sizeof (buf) - 1] = '\0';
+    sc->burst = BURSTSIZE;
+    sc->eatSecond = 0.0;
+    sc->seed = 1;
+
+    if ((sc->arrival = nameIndex (arrivalName, 3, strtok (buf, " \t\r\n"))) == -1) {
+        return -1;
+    }
+    if (!number (strtok (NULL, " \t\r\n"), &sc->rate) || (sc->rate <= 0.0)) {
+        return -1;
+    }
+    word = strtok (NULL, " \t\r\n");
+    if ((word != NULL) && (strcmp (word, "burst") == 0)) {
+        if ((sc->arrival != ARRIVEBURSTY) || !number (strtok (NULL, " \t\r\n"), &value) || (value < 1.0)) {
+            return -1;
+        }
+        sc->burst = (unsigned int) value;
+        word = strtok (NULL, " \t\r\n");
+    }
+    if ((word == NULL) || (strcmp (word, "eat") != 0)) {
+        return -1;
+    }
+    if ((sc->eat = nameIndex (eatName, 3, strtok (NULL, " \t\r\n"))) == -1) {
+        return -1;
+    }
+    if (!number (strtok (NULL, " \t\r\n"), &sc->eatFirst)) {
+        return -1;
+    }
+    if ((sc->eat == EATUNIFORM) && (!number (strtok (NULL, " \t\r\n"), &sc->eatSecond) ||
+                                    (sc->eatSecond < sc->eatFirst))) {
+        return -1;
+    }
+    word = strtok (NULL, " \t\r\n");
+    if ((word != NULL) && (strcmp (word, "seed") == 0)) {
+        if (!number (strtok (NULL, " \t\r\n"), &value)) {
+            return -1;
+        }
+        sc->seed = (unsigned long) value;
+        word = strtok (NULL, " \t\r\n");
+    }
+    return (word == NULL) ? 0 : -1;
+}
+
+/**
+ *  \brief Expansion of a scenario into the start and eat times of the groups.
+ *
+ *  \param sc pointer to the scenario
+ *  \param nGroups number of groups
+ *  \param startTime array where the start times are stored (in us)
+ *  \param eatTime array where the eat times are stored (in us)
+ */
+void expandScenario (SCENARIO *sc, int nGroups, int startTime[], int eatTime[])
+{
+    PRNG arrivals, eats;                                              /* streams of the arrival and eat times */
+    double gap = 1e6 / sc->rate;                                               /* mean interarrival time (us) */
+    double t = 0.0;                                                                  /* time of the arrival */
+    int g;
+
+    prngInit (&arrivals, sc->seed, ARRIVALSTREAM);
+    prngInit (&eats, sc->seed, EATSTREAM);
+    for (g = 0; g < nGroups; g++) {
+        switch (sc->arrival) {
+            case ARRIVEUNIFORM:
+                t += gap;
+                break;
+            case ARRIVEPOISSON:
+                t += exponential (&arrivals, gap);
+                break;
+            case ARRIVEBURSTY:
+                if (g % sc->burst == 0) {
+                    t += exponential (&arrivals, gap * sc->burst);
+                }
+                break;
+        }
+        startTime[g] = usTime (t);
+        switch (sc->eat) {
+            case EATFIXED:
+                eatTime[g] = usTime (sc->eatFirst);
+                break;
+            case EATUNIFORM:
+                eatTime[g] = usTime (sc->eatFirst + (sc->eatSecond - sc->eatFirst) * prngUniform (&eats));
+                break;
+            case EATEXPONENTIAL:
+                eatTime[g] = usTime (exponential (&eats, sc->eatFirst));
+                break;
+        }
+    }
+}
+
+/**
+ *  \brief Mean eat time of a scenario.
+ *
+ *  \param sc pointer to the scenario
+ *
+ *  \return mean eat time (in us)
+ */
+double scenarioEatMean (SCENARIO *sc)
+{
+    return (sc->eat == EATUNIFORM) ? (sc->eatFirst + sc->eatSecond) / 2 : sc->eatFirst;
+}
+
+/**
+ *  \brief Writing of the description of a scenario, as a line of <tt>config.txt</tt>.
+ *
+ *  \param fp stream the description is written to
+ *  \param sc pointer to the scenario
+ */
+void writeScenario (FILE *fp, SCENARIO *sc)
+{
+    fprintf (fp, "#arrivals %s %g", arrivalName[sc->arrival], sc->rate);
+    if (sc->arrival == ARRIVEBURSTY) {
+        fprintf (fp, " burst %u", sc->burst);
+    }
+    fprintf (fp, " eat %s %g", eatName[sc->eat], sc->eatFirst);
+    if (sc->eat == EATUNIFORM) {
+        fprintf (fp, " %g", sc->eatSecond);
+    }
+    fprintf (fp, " seed %lu\n", sc->seed);
+}
@@ -0,0 +1,107 @@
+/**
+ *  \file scenario.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Scenarios: start and eat times of the groups drawn from an arrival pattern and an eat time distribution.
+ *
+ *  A scenario replaces the start and eat times of every group in <tt>config.txt</tt> by a single line, expanded
+ *  when the configuration is loaded:
+ *
+ *  <tt>\#arrivals pattern rate [burst n] eat distribution parameters [seed n]</tt>
+ *
+ *  where the pattern is <tt>uniform</tt> (evenly spaced arrivals), <tt>poisson</tt> (exponential interarrival times)
+ *  or <tt>bursty</tt> (bursts of <tt>n</tt> groups arriving together, 10 by default, the bursts being Poisson
+ *  arrivals), at <tt>rate</tt> groups per second, and the eat time distribution is <tt>fixed time</tt>,
+ *  <tt>uniform min max</tt> or <tt>exponential mean</tt> (times in us). The times only depend on the scenario
+ *  and its seed (1 by default), not on the seed of the run: the arrivals are drawn from a stream of their own and
+ *  the eat times from another one, so that the same seed gives the same arrivals with any eat time distribution
+ *  and arrivals scaled in time with any rate.
+ *
+ *  Operations defined on a scenario:
+ *     \li parsing of its description
+ *     \li expansion into the start and eat times of the groups
+ *     \li writing of its description.
+ */
+
+#ifndef SCENARIO_H_
+#define SCENARIO_H_
+
+#include <stdio.h>
+
+/** \brief evenly spaced arrivals */
+#define  ARRIVEUNIFORM    0
+/** \brief arrivals of a Poisson process */
+#define  ARRIVEPOISSON    1
+/** \brief bursts of groups, the bursts being arrivals of a Poisson process */
+#define  ARRIVEBURSTY     2
+
+/** \brief every group eats for the same time */
+#define  EATFIXED         0
+/** \brief eat times uniformly distributed */
+#define  EATUNIFORM       1
+/** \brief eat times exponentially distributed */
+#define  EATEXPONENTIAL   2
+
+/** \brief default number of groups of a burst */
+#define  BURSTSIZE       10
+
+/**
+ *  \brief Definition of the <em>scenario</em> data type.
+ */
+typedef struct {
+    /** \brief arrival pattern (ARRIVEUNIFORM, ARRIVEPOISSON or ARRIVEBURSTY) */
+    int arrival;
+    /** \brief mean number of arrivals per second */
+    double rate;
+    /** \brief number of groups of a burst (ARRIVEBURSTY) */
+    unsigned int burst;
+    /** \brief eat time distribution (EATFIXED, EATUNIFORM or EATEXPONENTIAL) */
+    int eat;
+    /** \brief eat time (EATFIXED), minimum eat time (EATUNIFORM) or mean eat time (EATEXPONENTIAL), in us */
+    double eatFirst;
+    /** \brief maximum eat time (EATUNIFORM), in us */
+    double eatSecond;
+    /** \brief seed of the scenario */
+    unsigned long seed;
+} SCENARIO;
+
+/**
+ *  \brief Parsing of the description of a scenario.
+ *
+ *  \param spec description (what follows <tt>\#arrivals</tt>)
+ *  \param sc pointer to the location where the scenario is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when the description is not valid
+ */
+extern int parseScenario (char spec[], SCENARIO *sc);
+
+/**
+ *  \brief Expansion of a scenario into the start and eat times of the groups.
+ *
+ *  \param sc pointer to the scenario
+ *  \param nGroups number of groups
+ *  \param startTime array where the start times are stored (in us)
+ *  \param eatTime array where the eat times are stored (in us)
+ */
+extern void expandScenario (SCENARIO *sc, int nGroups, int startTime[], int eatTime[]);
+
+/**
+ *  \brief Mean eat time of a scenario.
+ *
+ *  \param sc pointer to the scenario
+ *
+ *  \return mean eat time (in us)
+ */
+extern double scenarioEatMean (SCENARIO *sc);
+
+/**
+ *  \brief Writing of the description of a scenario, as a line of <tt>config.txt</tt>.
+ *
+ *  \param fp stream the description is written to
+ *  \param sc pointer to the scenario
+ */
+extern void writeScenario (FILE *fp, SCENARIO *sc);
+
+#endif /* SCENARIO_H_ */
@@ -0,0 +1,111 @@
+/**
+ *  \file scengen.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  Generator of configuration files of large scenarios.
+ *
+ *  The configuration (<tt>config.txt</tt> format) of a scenario is written to the standard output: the number of
+ *  groups, the <tt>\#arrivals</tt> line of the scenario, expanded by the generator of the simulation when the file
+ *  is read, and the numbers of tables, waiters and chefs. The scenario is given by the arguments, the words of the
+ *  <tt>\#arrivals</tt> line (see scenario.h), e.g.
+ *
+ *  <tt>scengen -g 5000 -t 20 poisson 200 eat exponential 50000</tt>
+ *
+ *  Options:
+ *    \li <tt>-g n</tt> number of groups (<tt>MAXGROUPS</tt> by default, up to <tt>MAXPOPULATION</tt>)
+ *    \li <tt>-t n</tt> number of tables (<tt>NUMTABLES</tt> by default)
+ *    \li <tt>-w n</tt> number of waiters (one by default)
+ *    \li <tt>-c n</tt> number of chefs (one by default)
+ *    \li <tt>-x</tt> the start and eat times of every group are written instead of the scenario, so that the file
+ *        is read by the reference binaries as well.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "probConst.h"
+#include "scenario.h"
+
+/* internal functions */
+
+static void usage (char *name)
+{
+    fprintf (stderr, "Usage: %s [-g groups] [-t tables] [-w waiters] [-c chefs] [-x] scenario\n", name);
+    fprintf (stderr, "  scenario: uniform|poisson|bursty rate [burst n] "
+                     "eat fixed time|uniform min max|exponential mean [seed n]\n");
+    exit (EXIT_FAILURE);
+}
+
+/**
+ *  \brief Main program.
+ *
+ *  Its role is to write the configuration of a scenario.
+ */
+int main (int argc, char *argv[])
+{
+    int nGroups = MAXGROUPS, nTables = NUMTABLES, nWaiters = 1, nChefs = 1;
+    bool expand = false;                                                 /* times of every group written */
+    char spec[256] = "";                                                          /* description of the scenario */
+    SCENARIO sc;
+    int *startTime, *eatTime;
+    int g, opt;
+
+    while ((opt = getopt (argc, argv, "g:t:w:c:x")) != -1) {
+        switch (opt) {
+            case 'g':
+                nGroups = atoi (optarg);
+                break;
+            case 't':
+                nTables = atoi (optarg);
+                break;
+            case 'w':
+                nWaiters = atoi (optarg);
+                break;
+            case 'c':
+                nChefs = atoi (optarg);
+                break;
+            case 'x':
+                expand = true;
+                break;
+            default:
+                usage (argv[0]);
+        }
+    }
+    for (; optind < argc; optind++) {
+        if (strlen (spec) + strlen (argv[optind]) + 2 > sizeof (spec)) {
+            usage (argv[0]);
+        }
+        strcat (spec, " ");
+        strcat (spec, argv[optind]);
+    }
+    if ((nGroups < 1) || (nGroups > MAXPOPULATION) || (nTables < 1) || (nTables > MAXTABLES) ||
+        (nWaiters < 1) || (nWaiters > MAXSTAFF) || (nChefs < 1) || (nChefs > MAXSTAFF) ||
+        (parseScenario (spec, &sc) == -1)) {
+        usage (argv[0]);
+    }
+
+    printf ("#ngroups\n%d\n", nGroups);
+    if (expand) {
+        startTime = malloc (nGroups * sizeof (int));
+        eatTime = malloc (nGroups * sizeof (int));
+        if ((startTime == NULL) || (eatTime == NULL)) {
+            perror ("error on allocating the groups times");
+            exit (EXIT_FAILURE);
+        }
+        expandScenario (&sc, nGroups, startTime, eatTime);
+        printf ("#startTime timeToEat\n");
+        for (g = 0; g < nGroups; g++) {
+            printf ("%d %d\n", startTime[g], eatTime[g]);
+        }
+        free (startTime);
+        free (eatTime);
+    }
+    else writeScenario (stdout, &sc);
+    printf ("#ntables\n%d\n#nwaiters\n%d\n#nchefs\n%d\n", nTables, nWaiters, nChefs);
+
+    return EXIT_SUCCESS;
+}
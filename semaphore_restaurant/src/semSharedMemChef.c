@@ -10,6 +10,11 @@
  *     \li waitForOrder
  *     \li processOrder
  *
+ *  In the pipelined kitchen (<tt>-K</tt>), the cooking of an order starts when the waiter places it: the chef
+ *  receives every queued order without waiting for the food of the previous ones (receiveOrders), sleeps
+ *  until the earliest of the orders being cooked is ready and hands all the food that is ready, in batches of
+ *  as many vacant slots of the mailbox of the waiter as there are (deliverFood).
+ *
  *  \author Nuno Lau - December 2023
  */
 
@@ -30,6 +35,12 @@
 #include "sharedDataSync.h"
 #include "semaphore.h"
 #include "sharedMemory.h"
+#include "mailbox.h"
+#include "virtualClock.h"
+#include "replay.h"
+#include "latency.h"
+#include "notify.h"
+#include "prng.h"
 
 
 /** \brief logging file name */
@@ -41,14 +52,28 @@ static int shmid;
 /** \brief semaphore set access identifier */
 static int semgid;
 
-/** \brief group that requested cooking food */
-static int lastGroup;
+/** \brief group that requested cooking food (one per chef thread in the threaded engine) */
+static __thread int lastGroup;
+
+/** \brief time the order of lastGroup was placed (us) */
+static __thread unsigned long lastPlaced;
+
+/** \brief groups whose orders are being cooked by the chef (pipelined kitchen) */
+static __thread int cooking[MAXTABLES];
+
+/** \brief time the food of each order being cooked is ready (us) */
+static __thread unsigned long readyAt[MAXTABLES];
+
+/** \brief number of orders being cooked by the chef */
+static __thread int nCooking;
 
 /** \brief pointer to shared memory region */
 static SHARED_DATA *sh;
 
-static void waitForOrder ();
+static bool waitForOrder ();
 static void processOrder ();
+static bool receiveOrders ();
+static void deliverFood ();
 
 /**
  *  \brief Main program.
@@ -67,10 +92,12 @@ int main (int argc, char *argv[])
         fprintf (stderr, "Number of parameters is incorrect!\n");
         return EXIT_FAILURE;
     }
-    else {
+#ifndef THREADED
+    else {                                          /* the threaded engine keeps the stderr of the generator */
        freopen (argv[3], "w", stderr);
        setbuf(stderr,NULL);
     }
+#endif
     strcpy (nFic, argv[1]);
     key = (unsigned int) strtol (argv[2], &tinp, 0);
     if (*tinp != '\0') {
@@ -92,19 +119,39 @@ int main (int argc, char *argv[])
         perror ("error on mapping the shared region on the process address space");
         return EXIT_FAILURE;
     }
+    if ((sh->placement & SHMPREFAULT) && (shmemPlace (shmid, sh, SHMPREFAULT, 0) == -1)) {
+        perror ("error on faulting the shared region in");
+        return EXIT_FAILURE;
+    }
 
-    /* initialize random generator */
-    srandom ((unsigned int) getpid ());                                      
+    /* open log session */
+    openLogSession (nFic, &sh->log, semgid);
+    logEntity (&sh->log, MEMBERCHEF, -1);
 
-    /* simulation of the life cycle of the chef */
+    /* join the virtual clock, the replay and the latency statistics */
+    joinClock (semgid, &sh->clock, -1);
+    joinReplay (semgid, &sh->replay, MEMBERCHEF, -1);
+    joinLatency (&sh->lat);
+    semProfile (SEMSTATS, MEMBERCHEF);
 
-    int nOrders=0;
-    while(nOrders < sh->fSt.nGroups) {
-       waitForOrder();
-       processOrder();
+    /* simulation of the life cycle of the chef (until all orders are received by the chefs) */
 
-       nOrders++;
+    if (sh->pipelinedKitchen) {
+       nCooking = 0;                                 /* the life cycle may run again in the same process (pool) */
+       while(receiveOrders()) {
+          deliverFood();
+       }
+    }
+    else while(waitForOrder()) {
+       processOrder();
     }
+    semProfile (NULL, 0);
+    leaveLatency (&sh->lat);
+    leaveReplay (&sh->replay);
+    leaveClock (semgid, &sh->clock);
+
+    /* close log session */
+    closeLogSession ();
 
     /* unmapping the shared region off the process address space */
 
@@ -122,52 +169,86 @@ int main (int argc, char *argv[])
  *  The chef waits for the food request that will be provided by the waiter.
  *  Updates its state and saves internal state.
  *  Received order should be acknowledged.
+ *
+ *  With the order queue, the oldest order is taken from the queue and its slot is released.
+ *  When all orders are received, the chef receiving the last one wakes up the other chefs, so that
+ *  they terminate.
+ *
+ *  \return \c true, if an order was received
+ *  \return \c false, when there are no more orders
  */
-static void waitForOrder ()
+static bool waitForOrder ()
 {
-    if (semDown (semgid, sh->mutex) == -1) {                                                      /* enter critical region */
+    SEM_OP enter[] = {{sh->waitOrder, -1}, {sh->kitchenLock, -1}};
+    SEM_OP leave[] = {{sh->kitchenLock, 1}, {sh->orderReceived, 1}, {sh->waitOrder, sh->nChefs - 1}};
+
+    if (sh->queueOrders) {
+        leave[1].sindex = sh->orderSlots;
+    }
+
+    if (semDown (semgid, sh->kitchenLock) == -1) {                                                      /* enter critical region */
         perror ("error on the down operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
+    // Terminar se todos os pedidos já foram recebidos
+    if (sh->ordersToCook == 0) {
+        if (semUp (semgid, sh->kitchenLock) == -1) {                                                  /* exit critical region */
+            perror ("error on the up operation for semaphore access (PT)");
+            exit (EXIT_FAILURE);
+        }
+        return false;
+    }
+
     // Muda o estado do chef para WAIT_FOR_ORDER
     sh->fSt.st.chefStat = WAIT_FOR_ORDER;
     saveState(nFic, &sh->fSt); 
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                      /* exit critical region */
+    if (semUp (semgid, sh->kitchenLock) == -1) {                                                      /* exit critical region */
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
     
-    // Espera que o Waiter dê inforções da comida
-    if (semDown (semgid, sh->waitOrder) == -1) {
+    // Espera que o Waiter dê inforções da comida e entra na região crítica
+    if (semOpMulti (semgid, enter, 2) == -1) {                                                    /* enter critical region */
         perror ("error on the down operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                      /* enter critical region */
-        perror ("error on the down operation for semaphore access (PT)");
-        exit (EXIT_FAILURE);
+    // Terminar se o Chef foi acordado por outro Chef depois de todos os pedidos serem recebidos
+    if (sh->ordersToCook == 0) {
+        if (semUp (semgid, sh->kitchenLock) == -1) {                                                  /* exit critical region */
+            perror ("error on the up operation for semaphore access (PT)");
+            exit (EXIT_FAILURE);
+        }
+        return false;
     }
 
-    // Indicar que o pedido foi recebido
-    sh->fSt.foodOrder = 0;
+    if (sh->queueOrders) {
+        // Retira o pedido mais antigo da fila de pedidos e guarda o grupo que pediu comida e o instante do pedido
+        lastGroup = sh->orders.group[sh->orders.head];
+        lastPlaced = sh->orders.placed[sh->orders.head];
+        sh->orders.head = (sh->orders.head + 1) % sh->orders.size;
+        sh->orders.count--;
+        sh->fSt.foodOrder = sh->orders.count;
+    }
+    else {
+        // Indicar que o pedido foi recebido
+        sh->fSt.foodOrder = 0;
+        // Guarda o grupo que pediu comida
+        lastGroup=sh->fSt.foodGroup ;
+    }
     // Muda o estado do Chef para COOK
     sh->fSt.st.chefStat = COOK;
-    // Guarda o grupo que pediu comida
-    lastGroup=sh->fSt.foodGroup ;
+    sh->ordersToCook--;
     saveState(nFic, &sh->fSt);
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                      /* exit critical region */
-        perror ("error on the up operation for semaphore access (PT)");
-        exit (EXIT_FAILURE);
-    }
-
-    // Desbloqueia o Waiter pois já recebeu e guardou a informação do pedido
-    if (semUp (semgid, sh->orderReceived) == -1) {
+    // Sai da região crítica e desbloqueia o Waiter pois já recebeu e guardou a informação do pedido (acordando os outros Chefs depois do último pedido)
+    if (semOpMulti (semgid, leave, ((sh->ordersToCook == 0) && (sh->nChefs > 1)) ? 3 : 2) == -1) {                                                  /* exit critical region */
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
+    return true;
 }
 
 /**
@@ -177,18 +258,27 @@ static void waitForOrder ()
  *  ready (this may only happen when waiter is available)
  *  then updates its state.
  *  The internal state should be saved.
+ *
+ *  With the order queue, the food is handed in the request slot of the chefs, so that the chef does not wait for
+ *  the request slot of the groups. Otherwise the request slot of the groups is used, as expected by the reference
+ *  waiter.
  */
 static void processOrder ()
 {
-    usleep((unsigned int) floor ((MAXCOOK * random ()) / RAND_MAX + 100.0));
+    bool ownSlot = sh->queueOrders;                                              /* food handed in the chef slot */
+    PRNG rng;                                                  /* random stream of the cooking time of the food */
+    SEM_OP enter[] = {{sh->waiterRequestPossible, -1}, {sh->kitchenLock, -1}};
+    SEM_OP leave[] = {{sh->kitchenLock, 1}, {sh->waiterRequest, 1}};
 
-    // Espera que o Waiter esteja disponivel para receber um pedido
-    if (semDown(semgid, sh->waiterRequestPossible) == -1) {
-            perror ("error on the down operation for semaphore access (PT)");
-            exit (EXIT_FAILURE);
-        }
+    if (ownSlot) {
+        enter[0].sindex = sh->foodReadyPossible;
+    }
+
+    prngInit(&rng, sh->seed, COOKSTREAM(lastGroup));
+    clockSleep(semgid, &sh->clock, (unsigned int) floor (MAXCOOK * prngUniform (&rng) + 100.0));
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                      /* enter critical region */
+    // Espera que o Waiter esteja disponivel para receber a comida e entra na região crítica
+    if (semOpMulti (semgid, enter, 2) == -1) {                                                    /* enter critical region */
         perror ("error on the down operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
@@ -196,19 +286,188 @@ static void processOrder ()
     // Muda o estado do Chef para REST
     sh->fSt.st.chefStat = REST; 
 
-    // Guarda no waiterRequest o type FOODREADY para o Waiter saber que tem de receber a comida e o grupo guardado que pediu a comida
-    sh->fSt.waiterRequest.reqType = FOODREADY;
-    sh->fSt.waiterRequest.reqGroup = lastGroup;
+    // Guarda no pedido o type FOODREADY para o Waiter saber que tem de receber a comida e o grupo guardado que pediu a comida
+    if (ownSlot) {
+        sh->foodReady.reqType = FOODREADY;
+        sh->foodReady.reqGroup = lastGroup;
+    }
+    else {
+        postRequest (&sh->waiterBox, &sh->fSt.waiterRequest, FOODREADY, lastGroup);
+    }
     saveState(nFic, &sh->fSt);
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                      /* exit critical region */
+    // Sai da região crítica e liberta o Waiter para processar o pedido
+    if (semOpMulti (semgid, leave, 2) == -1) {                                                  /* exit critical region */
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
-    // Liberta o Waiter para processar o pedido
-    if (semUp (semgid, sh->waiterRequest) == -1) {
+    // Notifica a comida pronta ao staff orientado a eventos (se existir)
+    if (notifyPost (&sh->notify, NOTIFYKITCHEN) == -1) {
+        perror ("error on notifying the request (PT)");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief chef starts cooking an order (pipelined kitchen)
+ *
+ *  The food is ready the cooking time after the order was placed.
+ *
+ *  \param group group that requested the food
+ *  \param placed time the order was placed (us)
+ */
+static void startCooking (int group, unsigned long placed)
+{
+    PRNG rng;                                                  /* random stream of the cooking time of the food */
+
+    prngInit(&rng, sh->seed, COOKSTREAM(group));
+    cooking[nCooking] = group;
+    readyAt[nCooking++] = placed + (unsigned long) floor (MAXCOOK * prngUniform (&rng) + 100.0);
+}
+
+/**
+ *  \brief chef receives the food orders (pipelined kitchen)
+ *
+ *  When the chef is not cooking, it waits for an order. Then every other queued order is received without
+ *  blocking: the orders are taken from the queue, their slots are released and the chef starts cooking them.
+ *  The downs of the semaphore of the orders that are not matched by a queued order are the wake-ups of the chefs
+ *  after the last order, and are given back.
+ *
+ *  \return \c true, if the chef has orders to cook
+ *  \return \c false, when there are no more orders
+ */
+static bool receiveOrders ()
+{
+    SEM_OP leave[3] = {{sh->kitchenLock, 1}};
+    int nOps = 1;
+    int n, r;
+
+    // Esperar por um pedido, se o Chef não estiver a cozinhar
+    if (nCooking == 0) {
+        if (!waitForOrder()) {
+            return false;
+        }
+        startCooking(lastGroup, lastPlaced);
+    }
+
+    // Reservar, sem bloquear, os restantes pedidos e entrar na região crítica
+    if ((n = semTryDown (semgid, sh->waitOrder, MAXTABLES)) == -1) {
+        perror ("error on the down operation for semaphore access (PT)");
+        exit (EXIT_FAILURE);
+    }
+    if (n == 0) {
+        return true;
+    }
+    if (semDown (semgid, sh->kitchenLock) == -1) {                                                      /* enter critical region */
+        perror ("error on the down operation for semaphore access (PT)");
+        exit (EXIT_FAILURE);
+    }
+
+    // Retira os pedidos mais antigos da fila de pedidos e começa a cozinhá-los
+    for (r = 0; (r < n) && (sh->orders.count > 0); r++) {
+        startCooking(sh->orders.group[sh->orders.head], sh->orders.placed[sh->orders.head]);
+        sh->orders.head = (sh->orders.head + 1) % sh->orders.size;
+        sh->orders.count--;
+        sh->ordersToCook--;
+    }
+    if (r > 0) {
+        // Muda o estado do Chef para COOK
+        sh->fSt.foodOrder = sh->orders.count;
+        sh->fSt.st.chefStat = COOK;
+        saveState(nFic, &sh->fSt);
+        leave[nOps].sindex = sh->orderSlots;
+        leave[nOps++].delta = r;
+    }
+
+    // Devolver os despertares dos Chefs e acordar os outros Chefs depois do último pedido
+    if ((n - r) + (((r > 0) && (sh->ordersToCook == 0)) ? sh->nChefs - 1 : 0) > 0) {
+        leave[nOps].sindex = sh->waitOrder;
+        leave[nOps++].delta = (n - r) + (((r > 0) && (sh->ordersToCook == 0)) ? sh->nChefs - 1 : 0);
+    }
+
+    // Sai da região crítica e liberta as posições dos pedidos recebidos na fila de pedidos
+    if (semOpMulti (semgid, leave, nOps) == -1) {                                                  /* exit critical region */
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
+    return true;
+}
+
+/**
+ *  \brief chef delivers the food that is ready to the waiter (pipelined kitchen)
+ *
+ *  The chef sleeps until the earliest of the orders being cooked is ready, then hands every food that is ready:
+ *  it waits for a vacant slot of the mailbox of the waiter and takes, without blocking, the other vacant slots
+ *  that are needed, so that each batch is posted with a single state save and wake-up of the waiter.
+ *  The internal state should be saved.
+ */
+static void deliverFood ()
+{
+    SEM_OP enter[] = {{sh->waiterRequestPossible, -1}, {sh->kitchenLock, -1}};
+    SEM_OP leave[] = {{sh->kitchenLock, 1}, {sh->waiterRequest, 1}};
+    unsigned long now, earliest;
+    int c, ready, extra;
+
+    // Dormir até que a comida mais cedo esteja pronta
+    for (earliest = readyAt[0], c = 1; c < nCooking; c++) {
+        if (readyAt[c] < earliest) {
+            earliest = readyAt[c];
+        }
+    }
+    if (earliest > (now = clockNow(&sh->clock) / 1000)) {
+        clockSleep(semgid, &sh->clock, (unsigned int) (earliest - now));
+    }
+    now = clockNow(&sh->clock) / 1000;
+
+    // Juntar no início as comidas que estão prontas
+    for (ready = 0, c = 0; c < nCooking; c++) {
+        if ((readyAt[c] <= now) || (readyAt[c] == earliest)) {
+            int group = cooking[c];
+            unsigned long at = readyAt[c];
+
+            cooking[c] = cooking[ready];
+            readyAt[c] = readyAt[ready];
+            cooking[ready] = group;
+            readyAt[ready++] = at;
+        }
+    }
+
+    while (ready > 0) {
+        // Espera que o Waiter esteja disponivel para receber a comida, reserva as outras posições livres e entra na região crítica
+        if (semOpMulti (semgid, enter, 2) == -1) {                                                    /* enter critical region */
+            perror ("error on the down operation for semaphore access (PT)");
+            exit (EXIT_FAILURE);
+        }
+        if ((ready > 1) && ((extra = semTryDown (semgid, sh->waiterRequestPossible, ready - 1)) == -1)) {
+            perror ("error on the down operation for semaphore access (PT)");
+            exit (EXIT_FAILURE);
+        }
+        leave[1].delta = 1 + ((ready > 1) ? extra : 0);
+
+        // Guarda nos pedidos o type FOODREADY e os grupos das comidas prontas, retirando-as das que estão a ser cozinhadas
+        for (c = 0; c < leave[1].delta; c++) {
+            postRequest (&sh->waiterBox, &sh->fSt.waiterRequest, FOODREADY, cooking[--ready]);
+            cooking[ready] = cooking[--nCooking];
+            readyAt[ready] = readyAt[nCooking];
+        }
+
+        // Muda o estado do Chef para REST, se não estiver a cozinhar outros pedidos
+        if (nCooking == 0) {
+            sh->fSt.st.chefStat = REST;
+        }
+        saveState(nFic, &sh->fSt);
+
+        // Sai da região crítica e liberta o Waiter para processar os pedidos
+        if (semOpMulti (semgid, leave, 2) == -1) {                                                  /* exit critical region */
+            perror ("error on the up operation for semaphore access (PT)");
+            exit (EXIT_FAILURE);
+        }
+
+        // Notifica a comida pronta ao staff orientado a eventos (se existir)
+        if (notifyPost (&sh->notify, NOTIFYKITCHEN) == -1) {
+            perror ("error on notifying the request (PT)");
+            exit (EXIT_FAILURE);
+        }
+    }
 }
\ No newline at end of file
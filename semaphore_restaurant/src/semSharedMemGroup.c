@@ -14,6 +14,8 @@
  *     \li eat
  *     \li checkOutAtReception
  *
+ *  A group process may host several groups with consecutive ids, each one living in its own thread.
+ *
  *  \author Nuno Lau - December 2023
  */
 
@@ -24,6 +26,8 @@
 #include <sys/types.h>
 #include <string.h>
 #include <math.h>
+#include <errno.h>
+#include <pthread.h>
 
 #include "probConst.h"
 #include "probDataStruct.h"
@@ -31,6 +35,12 @@
 #include "sharedDataSync.h"
 #include "semaphore.h"
 #include "sharedMemory.h"
+#include "mailbox.h"
+#include "virtualClock.h"
+#include "replay.h"
+#include "latency.h"
+#include "notify.h"
+#include "prng.h"
 
 /** \brief logging file name */
 static char nFic[51];
@@ -44,6 +54,13 @@ static int semgid;
 /** \brief pointer to shared memory region */
 static SHARED_DATA *sh;
 
+/** \brief random stream of the start and eat times (one per group thread) */
+static __thread PRNG rng;
+
+/** \brief stack size of the threads hosting groups */
+#define  GROUPSTACK      (64*1024)
+
+static void *groupLife (void *arg);
 static void goToRestaurant (int id);
 static void checkInAtReception (int id);
 static void orderFood (int id);
@@ -56,15 +73,21 @@ static void checkOutAtReception (int id);
  *  \brief Main program.
  *
  *  Its role is to generate the life cycle of one of intervening entities in the problem: the group.
+ *  When a number of groups is given as fifth parameter, the process hosts that many groups, starting at the
+ *  given id, each one in its own thread.
  */
 int main (int argc, char *argv[])
 {
     int key;                                         /*access key to shared memory and semaphore set */
     char *tinp;                                                    /* numerical parameters test flag */
     int n;
+    int nHosted = 1;                                                     /* number of groups hosted */
+    pthread_t *thr;                                                 /* threads hosting the groups */
+    pthread_attr_t attr;                                                  /* attributes of threads */
+    int g, stat;
 
     /* validation of command line parameters */
-    if (argc != 5) { 
+    if ((argc != 5) && (argc != 6)) { 
         freopen ("error_GR", "a", stderr);
         fprintf (stderr, "Number of parameters is incorrect!\n");
         return EXIT_FAILURE;
@@ -75,10 +98,17 @@ int main (int argc, char *argv[])
     }
 
     n = (unsigned int) strtol (argv[1], &tinp, 0);
-    if ((*tinp != '\0') || (n >= MAXGROUPS )) { 
+    if ((*tinp != '\0') || (n >= MAXPOPULATION )) { 
         fprintf (stderr, "Group process identification is wrong!\n");
         return EXIT_FAILURE;
     }
+    if (argc == 6) {
+        nHosted = (unsigned int) strtol (argv[5], &tinp, 0);
+        if ((*tinp != '\0') || (nHosted < 1) || (n + nHosted > MAXPOPULATION)) { 
+            fprintf (stderr, "Number of hosted groups is wrong!\n");
+            return EXIT_FAILURE;
+        }
+    }
     strcpy (nFic, argv[2]);
     key = (unsigned int) strtol (argv[3], &tinp, 0);
     if (*tinp != '\0') { 
@@ -100,18 +130,51 @@ int main (int argc, char *argv[])
         perror ("error on mapping the shared region on the process address space");
         return EXIT_FAILURE;
     }
+    if ((sh->placement & SHMPREFAULT) && (shmemPlace (shmid, sh, SHMPREFAULT, 0) == -1)) {
+        perror ("error on faulting the shared region in");
+        return EXIT_FAILURE;
+    }
+
+    /* open log session */
+    openLogSession (nFic, &sh->log, semgid);
 
-    /* initialize random generator */
-    srandom ((unsigned int) getpid ());                                                 
 
+    if (n + nHosted > sh->fSt.nGroups) {
+        fprintf (stderr, "Group process identification is wrong!\n");
+        return EXIT_FAILURE;
+    }
 
-    /* simulation of the life cycle of the group */
-    goToRestaurant(n);
-    checkInAtReception(n);
-    orderFood(n);
-    waitFood(n);
-    eat(n);
-    checkOutAtReception(n);
+    /* simulation of the life cycle of the groups */
+    if (nHosted == 1) {
+        groupLife ((void *) (long) n);
+    }
+    else {
+        if ((thr = malloc (nHosted * sizeof (pthread_t))) == NULL) {
+            perror ("error on allocating the group threads");
+            return EXIT_FAILURE;
+        }
+        pthread_attr_init (&attr);
+        pthread_attr_setstacksize (&attr, GROUPSTACK);
+        for (g = 0; g < nHosted; g++) {
+            if ((stat = pthread_create (&thr[g], &attr, groupLife, (void *) (long) (n + g))) != 0) {
+                errno = stat;
+                perror ("error on creating the group thread");
+                return EXIT_FAILURE;
+            }
+        }
+        for (g = 0; g < nHosted; g++) {
+            if ((stat = pthread_join (thr[g], NULL)) != 0) {
+                errno = stat;
+                perror ("error on waiting for the group thread");
+                return EXIT_FAILURE;
+            }
+        }
+        pthread_attr_destroy (&attr);
+        free (thr);
+    }
+
+    /* close log session */
+    closeLogSession ();
 
     /* unmapping the shared region off the process address space */
     if (shmemDettach (sh) == -1) {
@@ -122,10 +185,39 @@ int main (int argc, char *argv[])
     return EXIT_SUCCESS;
 }
 
+/**
+ *  \brief life cycle of a group.
+ *
+ *  \param arg group id
+ */
+static void *groupLife (void *arg)
+{
+    int id = (int) (long) arg;
+
+    logEntity(&sh->log, MEMBERGROUP, id);
+    prngInit(&rng, sh->seed, GROUPSTREAM(id));
+    joinClock(semgid, &sh->clock, id);
+    joinReplay(semgid, &sh->replay, MEMBERGROUP, id);
+    joinLatency(&sh->lat);
+    semProfile(SEMSTATS, MEMBERGROUP);
+    goToRestaurant(id);
+    checkInAtReception(id);
+    orderFood(id);
+    waitFood(id);
+    eat(id);
+    checkOutAtReception(id);
+    semProfile(NULL, 0);
+    leaveLatency(&sh->lat);
+    leaveReplay(&sh->replay);
+    leaveClock(semgid, &sh->clock);
+
+    return NULL;
+}
+
 /**
  *  \brief normal distribution generator with zero mean and stddev deviation. 
  *
- *  Generates random number according to normal distribution.
+ *  Generates random number according to normal distribution, from the random stream of the group.
  * 
  *  \param stddev controls standard deviation of distribution
  */
@@ -135,7 +227,7 @@ static double normalRand(double stddev)
 
    double r=0.0;
    for (i=0;i<12;i++) {
-       r += random()/(RAND_MAX+1.0);
+       r += prngUniform(&rng);
    }
    r -= 6.0;
 
@@ -151,10 +243,10 @@ static double normalRand(double stddev)
  */
 static void goToRestaurant (int id)
 {
-    double startTime = sh->fSt.startTime[id] + normalRand(STARTDEV);
+    double startTime = STARTTIME(id) + normalRand(STARTDEV);
     
     if (startTime > 0.0) {
-        usleep((unsigned int) startTime );
+        clockSleep(semgid, &sh->clock, (unsigned int) startTime );
     }
 }
 
@@ -167,10 +259,10 @@ static void goToRestaurant (int id)
  */
 static void eat (int id)
 {
-    double eatTime = sh->fSt.eatTime[id] + normalRand(EATDEV);
+    double eatTime = EATTIME(id) + normalRand(EATDEV);
     
     if (eatTime > 0.0) {
-        usleep((unsigned int) eatTime );
+        clockSleep(semgid, &sh->clock, (unsigned int) eatTime );
     }
 }
 
@@ -188,40 +280,40 @@ static void eat (int id)
  */
 static void checkInAtReception(int id)
 {
-    // Espera que o rececionsita esteja disponível para receber um pedido
-    if (semDown (semgid, sh->receptionistRequestPossible) == -1) {
-        perror ("error on the down operation for semaphore access (CT)");
-        exit (EXIT_FAILURE);
-    }
+    SEM_OP enter[] = {{sh->receptionistRequestPossible, -1}, {sh->receptionLock, -1}};
+    SEM_OP leave[] = {{sh->receptionistReq, 1}, {sh->receptionLock, 1}};
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                  /* enter critical region */
+    // Espera que o rececionsita esteja disponível para receber um pedido e entra na região crítica
+    if (semOpMulti (semgid, enter, 2) == -1) {                                                /* enter critical region */
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
     // Muda o estado do grupo Nº(id) para ATRECEPTION
-    sh->fSt.st.groupStat[id] = ATRECEPTION;
+    GROUPSTAT(id) = ATRECEPTION;
+    stampGroup(&sh->lat, &sh->clock, id, ATRECEPTION);
     // Guarda no receptionistRequest o id do grupo e o type TABLEREQ para pedir uma mesa
-    sh->fSt.receptionistRequest.reqGroup = id;
-    sh->fSt.receptionistRequest.reqType = TABLEREQ;
+    postRequest(&sh->receptionistBox, &sh->fSt.receptionistRequest, TABLEREQ, id);
     saveState(nFic, &sh->fSt);
 
-    // Liberta o rececionista para processar o request (pedido de mesa)
-    if (semUp (semgid, sh->receptionistReq) == -1) {
+    // Liberta o rececionista para processar o request (pedido de mesa) e sai da região crítica
+    if (semOpMulti (semgid, leave, 2) == -1) {                                                  /* exit critical region */
         perror ("error on the up operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                      /* exit critical region */
-        perror ("error on the up operation for semaphore access (CT)");
+    // Notifica o pedido de mesa ao staff orientado a eventos (se existir)
+    if (notifyPost (&sh->notify, NOTIFYRECEPTION) == -1) {
+        perror ("error on notifying the request (CT)");
         exit (EXIT_FAILURE);
     }
 
     // O grupo espera que lhe seja atribuída uma mesa
-    if (semDown (semgid, sh->waitForTable[id]) == -1) {
+    if (semDown (semgid, GROUPWAIT(id)) == -1) {
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
+    stampGroup(&sh->lat, &sh->clock, id, GOTTABLE);
 }
 
 /**
@@ -236,36 +328,35 @@ static void checkInAtReception(int id)
  */
 static void orderFood (int id)
 {
-    // Espera que o Waiter esteja disponivel para receber um request
-    if (semDown (semgid, sh->waiterRequestPossible) == -1) {
-        perror ("error on the down operation for semaphore access (CT)");
-        exit (EXIT_FAILURE);
-    }
+    SEM_OP enter[] = {{sh->waiterRequestPossible, -1}, {sh->kitchenLock, -1}};
+    SEM_OP leave[] = {{sh->kitchenLock, 1}, {sh->waiterRequest, 1}};
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                  /* enter critical region */
+    // Espera que o Waiter esteja disponivel para receber um request e entra na região crítica
+    if (semOpMulti (semgid, enter, 2) == -1) {                                                /* enter critical region */
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
     // Muda o estado do grupo Nº(id) para FOOD_REQUEST
-    sh->fSt.st.groupStat[id] = FOOD_REQUEST;
+    GROUPSTAT(id) = FOOD_REQUEST;
+    stampGroup(&sh->lat, &sh->clock, id, FOOD_REQUEST);
     // Guarda no waiterRequest o id do grupo e o type FOODREQ para pedir comida
-    sh->fSt.waiterRequest.reqGroup = id;
-    sh->fSt.waiterRequest.reqType = FOODREQ;
+    postRequest(&sh->waiterBox, &sh->fSt.waiterRequest, FOODREQ, id);
     saveState(nFic, &sh->fSt);
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                     /* exit critical region */
+    // Sai da região crítica e liberta o Waiter para prcessar o request(pedido da comida)
+    if (semOpMulti (semgid, leave, 2) == -1) {                                                 /* exit critical region */
         perror ("error on the up operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
-    // Liberta o Waiter para prcessar o request(pedido da comida)
-    if (semUp (semgid, sh->waiterRequest) == -1) {
-        perror ("error on the up operation for semaphore access (CT)");
+    // Notifica o pedido de comida ao staff orientado a eventos (se existir)
+    if (notifyPost (&sh->notify, NOTIFYKITCHEN) == -1) {
+        perror ("error on notifying the request (CT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semDown(semgid, sh->requestReceived[sh->fSt.assignedTable[id]]) == -1) { 
+    if (semDown(semgid, TABLESYNC(ASSIGNEDTABLE(id)).requestReceived) == -1) { 
         perror ("error on the down operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
@@ -282,36 +373,36 @@ static void orderFood (int id)
  */
 static void waitFood (int id)
 {  
-    if (semDown (semgid, sh->mutex) == -1) {                                                  /* enter critical region */
+    int table = ASSIGNEDTABLE(id);                                                   /* table where the group is seated */
+    SEM_OP enter[] = {{TABLESYNC(table).foodArrived, -1}, {TABLESYNC(table).tableLock, -1}};
+
+    if (semDown (semgid, TABLESYNC(table).tableLock) == -1) {                                                  /* enter critical region */
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
     // Muda o estado do grupo Nº(id) para WAIT_FOR_FOOD
-    sh->fSt.st.groupStat[id] = WAIT_FOR_FOOD;
+    GROUPSTAT(id) = WAIT_FOR_FOOD;
+    stampGroup(&sh->lat, &sh->clock, id, WAIT_FOR_FOOD);
     saveState(nFic, &sh->fSt);
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                  /* exit critical region */
+    if (semUp (semgid, TABLESYNC(table).tableLock) == -1) {                                                  /* exit critical region */
         perror ("error on the up operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
-    // Espera que pela comida que será trazida pelo Waiter
-    if (semDown (semgid, sh->foodArrived[sh->fSt.assignedTable[id]]) == -1) {
-        perror ("error on the down operation for semaphore access (CT)");
-        exit (EXIT_FAILURE);
-    }
-
-    if (semDown (semgid, sh->mutex) == -1) {                                                  /* enter critical region */
+    // Espera que pela comida que será trazida pelo Waiter e entra na região crítica
+    if (semOpMulti (semgid, enter, 2) == -1) {                                                /* enter critical region */
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
     // Muda o estado do grupo(id) para EAT
-    sh->fSt.st.groupStat[id] = EAT;
+    GROUPSTAT(id) = EAT;
+    stampGroup(&sh->lat, &sh->clock, id, EAT);
     saveState(nFic, &sh->fSt);
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                  /* exit critical region */
+    if (semUp (semgid, TABLESYNC(table).tableLock) == -1) {                                                  /* exit critical region */
         perror ("error on the up operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
@@ -330,51 +421,52 @@ static void waitFood (int id)
  */
 static void checkOutAtReception (int id)
 {
-    // Espera que o receptionist esteja disponivel para receber um request
-   if (semDown (semgid, sh->receptionistRequestPossible) == -1) {
-        perror ("error on the down operation for semaphore access (CT)");
-        exit (EXIT_FAILURE);
-    }
+    int table;                                                    /* table being released by the group */
+    SEM_OP enter[] = {{sh->receptionistRequestPossible, -1}, {sh->receptionLock, -1}};
+    SEM_OP leave[] = {{sh->receptionistReq, 1}, {sh->receptionLock, 1}};
+    SEM_OP done[2] = {{0, -1}, {0, -1}};
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                  /* enter critical region */
+    // Espera que o receptionist esteja disponivel para receber um request e entra na região crítica
+    if (semOpMulti (semgid, enter, 2) == -1) {                                                /* enter critical region */
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
     // Muda o estado do grupo Nº(id) para CHECKOUT
-    sh->fSt.st.groupStat[id] = CHECKOUT;
+    GROUPSTAT(id) = CHECKOUT;
+    stampGroup(&sh->lat, &sh->clock, id, CHECKOUT);
     //Guarda no receptionistRequest o id do grupo e o type BILLREQ para pedir para pagar 
-    sh->fSt.receptionistRequest.reqGroup = id;
-    sh->fSt.receptionistRequest.reqType = BILLREQ;
+    postRequest(&sh->receptionistBox, &sh->fSt.receptionistRequest, BILLREQ, id);
+    // Guarda a mesa antes de o receptionist a libertar
+    table = ASSIGNEDTABLE(id);
     saveState(nFic, &sh->fSt);
     
-    // Liberta o receptionist para ir buscar o pagamento
-    if (semUp (semgid, sh->receptionistReq) == -1) {
+    // Liberta o receptionist para ir buscar o pagamento e sai da região crítica
+    if (semOpMulti (semgid, leave, 2) == -1) {                                              /* exit critical region */
         perror ("error on the up operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                  /* exit critical region */
-        perror ("error on the up operation for semaphore access (CT)");
-        exit (EXIT_FAILURE);
-    }
-
-    // Espera que receptionist libere a mesa em que está.
-    if (semDown (semgid, sh->tableDone[sh->fSt.assignedTable[id]]) == -1) {
-        perror ("error on the down operation for semaphore access (CT)");
+    // Notifica o pedido de pagamento ao staff orientado a eventos (se existir)
+    if (notifyPost (&sh->notify, NOTIFYRECEPTION) == -1) {
+        perror ("error on notifying the request (CT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                  /* enter critical region */
+    // Espera que receptionist libere a mesa em que está e entra na região crítica
+    done[0].sindex = TABLESYNC(table).tableDone;
+    done[1].sindex = TABLESYNC(table).tableLock;
+    if (semOpMulti (semgid, done, 2) == -1) {                                               /* enter critical region */
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
     // Muda o estado do grupo Nº(id) para LEAVING
-    sh->fSt.st.groupStat[id] = LEAVING;
+    GROUPSTAT(id) = LEAVING;
+    stampGroup(&sh->lat, &sh->clock, id, LEAVING);
     saveState(nFic, &sh->fSt);
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                  /* exit critical region */
+    if (semUp (semgid, TABLESYNC(table).tableLock) == -1) {                                                  /* exit critical region */
         perror ("error on the up operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
@@ -11,6 +11,17 @@
  *     \li provideTableOrWaitingRoom
  *     \li receivePayment
  *
+ *  The groups waiting for a table are seated, when one gets vacant, according to the scheduling policy of the
+ *  simulation: in order of arrival (a queue), by shortest expected eat time first or by earliest deadline first,
+ *  the deadline of a group being its expected arrival plus its expected eat time (a binary heap ordered by the
+ *  eat time or the deadline, ties in order of arrival). The expected times are those of the full state, so the
+ *  decisions do not depend on the timing of the run.
+ *
+ *  In the threaded and the forked engines, the receptionist may also be a role of the event-driven staff (see
+ *  semSharedMemStaff.c), which joins the simulation, serves the pending requests without blocking whenever they
+ *  are notified and leaves the simulation through <tt>receptionistJoin</tt>, <tt>receptionistPoll</tt> and
+ *  <tt>receptionistLeave</tt>.
+ *
  *  \author Nuno Lau - December 2023
  */
 
@@ -29,6 +40,10 @@
 #include "sharedDataSync.h"
 #include "semaphore.h"
 #include "sharedMemory.h"
+#include "mailbox.h"
+#include "virtualClock.h"
+#include "replay.h"
+#include "latency.h"
 
 /** \brief logging file name */
 static char nFic[51];
@@ -49,10 +64,96 @@ static SHARED_DATA *sh;
 #define DONE 3
 
 /** \brief receptioninst view on each group evolution (useful to decide table binding) */
-static int groupRecord[MAXGROUPS];
+static int *groupRecord;
 
-/** \brief receptionist waits for next request */
-static request waitForGroup();
+/** \brief number of 64 bit words of the free table bitmap */
+#define TABLEWORDS ((MAXTABLES + 63) / 64)
+
+#if TABLEWORDS > 64
+#error "the summary word of the free table bitmap only covers 64 words (MAXTABLES up to 4096)"
+#endif
+
+/** \brief receptionist view on each table (bit t is set while table t is vacant) */
+static unsigned long long freeTables[TABLEWORDS];
+
+/** \brief summary of the free table bitmap (bit w is set while word w of freeTables has a vacant table) */
+static unsigned long long freeWords = 0;
+
+/** \brief receptionist view on the waiting room (groups in order of arrival, ring buffer with nGroups slots, or
+ *  binary heap of the groups ordered by their keys) */
+static int *waitQueue;
+
+/** \brief position of the first waiting group in waitQueue (order of arrival) */
+static int waitHead = 0;
+
+/** \brief number of groups in waitQueue */
+static int waitCount = 0;
+
+/** \brief key of each group in the heap (expected eat time or deadline, in us) */
+static unsigned long *waitKey;
+
+/** \brief order of arrival of each group at the waiting room (ties of the heap) */
+static int *waitSeq;
+
+/** \brief order of arrival of the next group at the waiting room */
+static int nextSeq = 0;
+
+/**
+ *  \brief Definition of the <em>scheduling policy</em> of the waiting groups.
+ */
+typedef struct {
+    /** \brief puts a group in the waiting room */
+    void (*push) (int n);
+    /** \brief takes the next group to be seated out of the waiting room (-1 if it is empty) */
+    int (*pop) (void);
+} SCHED_POLICY;
+
+/** \brief marks table t as vacant in the free table bitmap */
+static void vacateTable(int t);
+
+/** \brief marks table t as occupied in the free table bitmap */
+static void occupyTable(int t);
+
+/** \brief waiting room in order of arrival: a group is put in the waiting room */
+static void queuePush(int n);
+
+/** \brief waiting room in order of arrival: the oldest group is taken out */
+static int queuePop(void);
+
+/** \brief waiting room ordered by key: a group is put in the waiting room */
+static void heapPush(int n);
+
+/** \brief waiting room ordered by key: the group with the lowest key is taken out */
+static int heapPop(void);
+
+/** \brief scheduling policies (indexed by SCHEDFIFO, SCHEDSEF and SCHEDEDF) */
+static const SCHED_POLICY policy[SCHEDPOLICIES] = {{queuePush, queuePop}, {heapPush, heapPop}, {heapPush, heapPop}};
+
+/** \brief number of requests taken so far */
+static int requestsTaken = 0;
+
+/** \brief receptionist joins the simulation */
+static int joinRestaurant(int argc, char *argv[]);
+
+/** \brief receptionist leaves the simulation */
+static int leaveRestaurant(void);
+
+/** \brief receptionist waits for next requests */
+static int waitForGroup(request req[]);
+
+/** \brief receptionist updates its state to wait for requests */
+static void startWaiting(void);
+
+/** \brief receptionist takes the requests claimed */
+static int takeRequests(request req[], int n);
+
+#if defined (THREADED) || defined (FORKED)
+/** \brief receptionist takes, without blocking, the pending requests */
+static int pollForGroup(request req[]);
+#endif
+
+/** \brief receptionist serves the requests taken */
+static void serveRequests(request req[], int n);
 
 /** \brief receptionist waits for next request */
 static void provideTableOrWaitingRoom(int n);
@@ -66,6 +167,84 @@ static void receivePayment(int n);
  *  Its role is to generate the life cycle of one of intervening entities in the problem: the receptionist.
  */
 int main(int argc, char *argv[])
+{
+    if (joinRestaurant(argc, argv) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+
+    /* simulation of the life cycle of the receptionist */
+    request req[MAXMAILBOX];
+    while (requestsTaken < sh->fSt.nGroups * 2)
+    {
+        serveRequests(req, waitForGroup(req));
+    }
+
+    return leaveRestaurant();
+}
+
+#if defined (THREADED) || defined (FORKED)
+/**
+ *  \brief Joining the simulation as a role of the event-driven staff.
+ *
+ *  \param argc number of command line parameters
+ *  \param argv command line parameters (those of the receptionist)
+ *
+ *  \return \c EXIT_SUCCESS, upon success
+ *  \return \c EXIT_FAILURE, when an error occurs
+ */
+int receptionistJoin(int argc, char *argv[])
+{
+    return joinRestaurant(argc, argv);
+}
+
+/**
+ *  \brief Serving the pending requests as a role of the event-driven staff.
+ *
+ *  The requests counted by the receptionist semaphore are taken and served without blocking; if there were any
+ *  and there are more requests to come, the receptionist waits for requests again.
+ *
+ *  \return true while there are requests still to be taken
+ */
+bool receptionistPoll(void)
+{
+    request req[MAXMAILBOX];
+    int n = pollForGroup(req);
+
+    serveRequests(req, n);
+    if (requestsTaken == sh->fSt.nGroups * 2)
+    {
+        return false;
+    }
+    if (n > 0)
+    {
+        startWaiting();
+    }
+    return true;
+}
+
+/**
+ *  \brief Leaving the simulation as a role of the event-driven staff.
+ *
+ *  \return \c EXIT_SUCCESS, upon success
+ *  \return \c EXIT_FAILURE, when an error occurs
+ */
+int receptionistLeave(void)
+{
+    return leaveRestaurant();
+}
+#endif
+
+/**
+ *  \brief receptionist joins the simulation
+ *
+ *  The command line parameters are validated, the shared region is mapped, the log session is opened, the clock,
+ *  the replay and the statistics are joined and the internal receptionist memory is initialized.
+ *
+ *  \return \c EXIT_SUCCESS, upon success
+ *  \return \c EXIT_FAILURE, when an error occurs
+ */
+static int joinRestaurant(int argc, char *argv[])
 {
     int key;    /*access key to shared memory and semaphore set */
     char *tinp; /* numerical parameters test flag */
@@ -77,11 +256,13 @@ int main(int argc, char *argv[])
         fprintf(stderr, "Number of parameters is incorrect!\n");
         return EXIT_FAILURE;
     }
+#ifndef THREADED
     else
-    {
+    {                                               /* the threaded engine keeps the stderr of the generator */
         freopen(argv[3], "w", stderr);
         setbuf(stderr, NULL);
     }
+#endif
 
     strcpy(nFic, argv[1]);
     key = (unsigned int)strtol(argv[2], &tinp, 0);
@@ -108,34 +289,78 @@ int main(int argc, char *argv[])
         perror("error on mapping the shared region on the process address space");
         return EXIT_FAILURE;
     }
+    if ((sh->placement & SHMPREFAULT) && (shmemPlace(shmid, sh, SHMPREFAULT, 0) == -1))
+    {
+        perror("error on faulting the shared region in");
+        return EXIT_FAILURE;
+    }
 
     /* initialize random generator */
     srandom((unsigned int)getpid());
 
+    /* open log session */
+    openLogSession(nFic, &sh->log, semgid);
+    logEntity(&sh->log, MEMBERRECEPTIONIST, 0);
+
+    /* join the virtual clock, the replay and the latency statistics */
+    joinClock(semgid, &sh->clock, -1);
+    joinReplay(semgid, &sh->replay, MEMBERRECEPTIONIST, 0);
+    joinLatency(&sh->lat);
+    semProfile(SEMSTATS, MEMBERRECEPTIONIST);
+
     /* initialize internal receptionist memory */
     int g;
+    if ((groupRecord = malloc(sh->fSt.nGroups * sizeof(int))) == NULL)
+    {
+        perror("error on allocating the receptionist view on groups");
+        return EXIT_FAILURE;
+    }
     for (g = 0; g < sh->fSt.nGroups; g++)
     {
         groupRecord[g] = TOARRIVE;
     }
-
-    /* simulation of the life cycle of the receptionist */
-    int nReq = 0;
-    request req;
-    while (nReq < sh->fSt.nGroups * 2)
+    if ((waitQueue = malloc(sh->fSt.nGroups * sizeof(int))) == NULL)
     {
-        req = waitForGroup();
-        switch (req.reqType)
-        {
-        case TABLEREQ:
-            provideTableOrWaitingRoom(req.reqGroup); // TODO param should be groupid
-            break;
-        case BILLREQ:
-            receivePayment(req.reqGroup);
-            break;
-        }
-        nReq++;
+        perror("error on allocating the receptionist view on the waiting room");
+        return EXIT_FAILURE;
+    }
+    if (((waitKey = malloc(sh->fSt.nGroups * sizeof(unsigned long))) == NULL) ||
+        ((waitSeq = malloc(sh->fSt.nGroups * sizeof(int))) == NULL))
+    {
+        perror("error on allocating the receptionist view on the waiting room");
+        return EXIT_FAILURE;
     }
+    waitHead = waitCount = nextSeq = 0;       /* the life cycle may run again in the same process (pool) */
+    requestsTaken = 0;
+    int t;
+    for (t = 0; t < sh->nTables; t++)
+    {
+        vacateTable(t);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ *  \brief receptionist leaves the simulation
+ *
+ *  The statistics, the replay and the clock are left, the log session is closed and the shared region is unmapped.
+ *
+ *  \return \c EXIT_SUCCESS, upon success
+ *  \return \c EXIT_FAILURE, when an error occurs
+ */
+static int leaveRestaurant(void)
+{
+    /* leave the latency statistics, the replay and the virtual clock and close log session */
+    semProfile(NULL, 0);
+    leaveLatency(&sh->lat);
+    leaveReplay(&sh->replay);
+    leaveClock(semgid, &sh->clock);
+    closeLogSession();
+    free(groupRecord);
+    free(waitQueue);
+    free(waitKey);
+    free(waitSeq);
 
     /* unmapping the shared region off the process address space */
     if (shmemDettach(sh) == -1)
@@ -148,10 +373,37 @@ int main(int argc, char *argv[])
     return EXIT_SUCCESS;
 }
 
+/**
+ *  \brief receptionist serves the requests taken
+ *
+ *  \param req requests taken
+ *  \param n number of requests
+ */
+static void serveRequests(request req[], int n)
+{
+    int r;
+
+    for (r = 0; r < n; r++)
+    {
+        switch (req[r].reqType)
+        {
+        case TABLEREQ:
+            provideTableOrWaitingRoom(req[r].reqGroup);
+            break;
+        case BILLREQ:
+            receivePayment(req[r].reqGroup);
+            break;
+        }
+    }
+}
+
 /**
  *  \brief decides table to occupy for group n or if it must wait.
  *
  *  Checks current state of tables and groups in order to decide table or wait.
+ *  The vacant table with the lowest id is found in constant time: the summary word gives the first word of the
+ *  free table bitmap with a vacant table and that word gives the table (the tables are alike, so the occupancy
+ *  only depends on the scheduling policy, when a table gets vacant).
  *
  *  \return table id or -1 (in case of wait decision)
  */
@@ -160,111 +412,286 @@ int decideTableOrWait(int n)
 
     // ID da mesa em que o grupo se irá sentar
     int tableID = -1;
-    // Numero de mesa a atribuir (0 ou 1) e váriavel para saber se a mesa esta em uso
-    int numTable, notInUse;
-
-    // Ciclos para verificar se existem mesas disponiveis ou nao
-    for (numTable = 0; numTable < NUMTABLES; numTable++){
-        notInUse = 1;
-        for (int i = 0; i < sh->fSt.nGroups; i++){
-            if (sh->fSt.assignedTable[i] == numTable){
-                notInUse = 0;
-                break;
-            }
-        }
-        if (notInUse){
-            // Se existirem mesas disponiveis, atribuir ao ID o número disponivel (0 ou 1)
-            tableID = numTable;
-            break;
-        }
+
+    // Verificar se existem mesas disponiveis (o resumo indica as palavras de freeTables com mesas disponiveis)
+    if (freeWords != 0){
+        // Se existirem mesas disponiveis, atribuir ao ID o número do primeiro bit a 1 da primeira palavra com mesas
+        int w = __builtin_ctzll(freeWords);
+        tableID = w * 64 + __builtin_ctzll(freeTables[w]);
     }
 
     return tableID;
 
 }
 
+/**
+ *  \brief marks table t as vacant in the free table bitmap.
+ *
+ *  The bit of the table and the bit of its word in the summary word are set.
+ *
+ *  \param t table id
+ */
+static void vacateTable(int t)
+{
+    freeTables[t / 64] |= 1ULL << (t % 64);
+    freeWords |= 1ULL << (t / 64);
+}
+
+/**
+ *  \brief marks table t as occupied in the free table bitmap.
+ *
+ *  The bit of the table is cleared, and the bit of its word in the summary word, if no table of the word is vacant.
+ *
+ *  \param t table id
+ */
+static void occupyTable(int t)
+{
+    freeTables[t / 64] &= ~(1ULL << (t % 64));
+    if (freeTables[t / 64] == 0) {
+        freeWords &= ~(1ULL << (t / 64));
+    }
+}
+
 /**
  *  \brief called when a table gets vacant and there are waiting groups
  *         to decide which group (if any) should occupy it.
  *
  *  Checks current state of tables and groups in order to decide group.
+ *  Waiting groups are served according to the scheduling policy.
  *
  *  \return group id or -1 (in case of wait decision)
  */
 static int decideNextGroup()
 {
 
-    // Próximo grupo a ser atendido
-    int nextGroup = -1;
+    // Retirar da sala de espera o próximo grupo segundo a política de escalonamento (-1 se estiver vazia)
+    return policy[sh->schedPolicy].pop();
 
-    // Ciclo para verificar se existem grupos à espera
-    for (int i = 0; i < sh->fSt.nGroups; i++){
-        if (groupRecord[i] == WAIT){
-            // Se existirem grupos a espera, atribuir ao nextGroup o número do grupo
-            nextGroup = i;
-            break;
-        }
+}
+
+/**
+ *  \brief waiting room in order of arrival: a group is put in the waiting room
+ *
+ *  \param n group id
+ */
+static void queuePush(int n)
+{
+    // Colocar o grupo no fim da fila de espera
+    waitQueue[(waitHead + waitCount) % sh->fSt.nGroups] = n;
+    waitCount++;
+}
+
+/**
+ *  \brief waiting room in order of arrival: the oldest group is taken out
+ *
+ *  \return group id or -1 (if there are no waiting groups)
+ */
+static int queuePop(void)
+{
+    int n = -1;
+
+    // Verificar se existem grupos à espera e retirar o mais antigo da fila
+    if (waitCount > 0){
+        n = waitQueue[waitHead];
+        waitHead = (waitHead + 1) % sh->fSt.nGroups;
+        waitCount--;
     }
+    return n;
+}
 
-    return nextGroup;
+/**
+ *  \brief the group in slot a of the heap is seated before the group in slot b
+ */
+static bool heapBefore(int a, int b)
+{
+    int ga = waitQueue[a], gb = waitQueue[b];
 
+    return (waitKey[ga] < waitKey[gb]) || ((waitKey[ga] == waitKey[gb]) && (waitSeq[ga] < waitSeq[gb]));
 }
 
 /**
- *  \brief receptionist waits for next request
+ *  \brief the groups in slots a and b of the heap are swapped
+ */
+static void heapSwap(int a, int b)
+{
+    int g = waitQueue[a];
+
+    waitQueue[a] = waitQueue[b];
+    waitQueue[b] = g;
+}
+
+/**
+ *  \brief waiting room ordered by key: a group is put in the waiting room
+ *
+ *  The key of the group is its expected eat time (SCHEDSEF) or its deadline, the expected arrival plus the expected
+ *  eat time (SCHEDEDF).
+ *
+ *  \param n group id
+ */
+static void heapPush(int n)
+{
+    int c, p;
+
+    // Calcular a chave do grupo e colocá-lo no fim do heap
+    waitKey[n] = (unsigned long) EATTIME(n) + ((sh->schedPolicy == SCHEDEDF) ? (unsigned long) STARTTIME(n) : 0);
+    waitSeq[n] = nextSeq++;
+    waitQueue[c = waitCount++] = n;
+
+    // Subir o grupo no heap enquanto deve ser sentado antes do seu pai
+    while ((c > 0) && heapBefore(c, p = (c - 1) / 2)){
+        heapSwap(c, p);
+        c = p;
+    }
+}
+
+/**
+ *  \brief waiting room ordered by key: the group with the lowest key is taken out
  *
- *  Receptionist updates state and waits for request from group, then reads request,
- *  and signals availability for new request.
+ *  \return group id or -1 (if there are no waiting groups)
+ */
+static int heapPop(void)
+{
+    int n, c, p = 0;
+
+    if (waitCount == 0){
+        return -1;
+    }
+
+    // Retirar a raiz do heap e colocar no seu lugar o último grupo
+    n = waitQueue[0];
+    waitQueue[0] = waitQueue[--waitCount];
+
+    // Descer o grupo no heap enquanto algum filho deve ser sentado antes dele
+    while ((c = 2 * p + 1) < waitCount){
+        if ((c + 1 < waitCount) && heapBefore(c + 1, c)){
+            c++;
+        }
+        if (!heapBefore(c, p)){
+            break;
+        }
+        heapSwap(c, p);
+        p = c;
+    }
+    return n;
+}
+
+/**
+ *  \brief receptionist waits for next requests
+ *
+ *  Receptionist updates state and waits for request from group, then reads request
+ *  and all the other pending requests (saving the state once), and signals availability for new requests.
  *  The internal state should be saved.
  *
- *  \return request submitted by group
+ *  \param req array where the requests submitted by groups are stored (up to <tt>MAXMAILBOX</tt>)
+ *
+ *  \return number of requests
  */
-static request waitForGroup()
+static int waitForGroup(request req[])
 {
-    request ret;
+    SEM_OP enter[] = {{sh->receptionistReq, -1}, {sh->receptionLock, -1}};
+    int extra;
+
+    startWaiting();
 
-    if (semDown(semgid, sh->mutex) == -1){                                                  /* enter critical region */
+    // Bloquear o rececionista até que um grupo faça um pedido e entrar na região crítica
+    if (semOpMulti(semgid, enter, 2) == -1){                                                /* enter critical region */
         perror("error on the down operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
 
-    // Aualizar e guardar estado do rececionista para esperar por um pedido
-    sh->fSt.st.receptionistStat = WAIT_FOR_REQUEST;
-    saveState(nFic, &sh->fSt);
+    // Reservar, sem bloquear, os restantes pedidos pendentes
+    extra = pendingRequests(&sh->receptionistBox, &sh->fSt.receptionistRequest) - 1;
+    if ((extra > 0) && ((extra = semTryDown(semgid, sh->receptionistReq, extra)) == -1)){
+        perror("error on the down operation for semaphore access (WT)");
+        exit(EXIT_FAILURE);
+    }
 
-    if (semUp(semgid, sh->mutex) == -1){                                             /* exit critical region */
-        perror("error on the up operation for semaphore access (WT)");
+    return takeRequests(req, 1 + extra);
+}
+
+#if defined (THREADED) || defined (FORKED)
+/**
+ *  \brief receptionist takes, without blocking, the pending requests
+ *
+ *  Receptionist claims the requests counted by its semaphore, without blocking, then reads them (saving the state
+ *  once), and signals availability for new requests (event-driven staff).
+ *
+ *  \param req array where the requests submitted by groups are stored (up to <tt>MAXMAILBOX</tt>)
+ *
+ *  \return number of requests (0 if there were none)
+ */
+static int pollForGroup(request req[])
+{
+    int n;
+
+    // Reservar, sem bloquear, os pedidos pendentes
+    if ((n = semTryDown(semgid, sh->receptionistReq, MAXMAILBOX)) == -1){
+        perror("error on the down operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
+    if (n == 0){
+        return 0;
+    }
 
-    // Bloquear o rececionista até que um grupo faça um pedido
-    if (semDown(semgid, sh->receptionistReq) == -1){
+    if (semDown(semgid, sh->receptionLock) == -1){                                                  /* enter critical region */
         perror("error on the down operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
+    return takeRequests(req, n);
+}
+#endif
 
-    if (semDown(semgid, sh->mutex) == -1){                                                  /* enter critical region */
+/**
+ *  \brief receptionist updates its state to wait for requests
+ *
+ *  The internal state should be saved.
+ */
+static void startWaiting(void)
+{
+    if (semDown(semgid, sh->receptionLock) == -1){                                                  /* enter critical region */
         perror("error on the down operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
 
-    // Atualizar a variavel ret com o pedido do grupo e reiniciar o pedido do rececionista, guardando-o
-    ret = sh->fSt.receptionistRequest;
-    sh->fSt.receptionistRequest.reqType = -1;
-    sh->fSt.receptionistRequest.reqGroup = -1;
+    // Aualizar e guardar estado do rececionista para esperar por um pedido
+    sh->fSt.st.receptionistStat = WAIT_FOR_REQUEST;
     saveState(nFic, &sh->fSt);
 
-    if (semUp(semgid, sh->mutex) == -1){                                             /* exit critical region */
+    if (semUp(semgid, sh->receptionLock) == -1){                                             /* exit critical region */
         perror("error on the up operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
+}
+
+/**
+ *  \brief receptionist takes the requests claimed
+ *
+ *  Called within the critical region, once the requests were claimed; the critical region is left.
+ *
+ *  \param req array where the requests are stored
+ *  \param n number of requests claimed
+ *
+ *  \return number of requests
+ */
+static int takeRequests(request req[], int n)
+{
+    SEM_OP leave[] = {{sh->receptionLock, 1}, {sh->receptionistRequestPossible, 1}};
+    int r;
+
+    // Atualizar a variavel req com os pedidos dos grupos e reiniciar o pedido do rececionista, guardando-o
+    for (r = 0; r < n; r++){
+        req[r] = takeRequest(&sh->receptionistBox, &sh->fSt.receptionistRequest);
+    }
+    leave[1].delta = n;
+    requestsTaken += n;
+    saveState(nFic, &sh->fSt);
 
-    // Aualizar o semáforo para sinalizar que o rececionista pode receber um pedido
-    if (semUp(semgid, sh->receptionistRequestPossible) == -1){
+    // Sair da região crítica e sinalizar que o rececionista pode receber um pedido
+    if (semOpMulti(semgid, leave, 2) == -1){                                         /* exit critical region */
         perror("error on the up operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
-    return ret;
+    return n;
 }
 
 /**
@@ -278,7 +705,7 @@ static request waitForGroup()
  */
 static void provideTableOrWaitingRoom(int n)
 {
-    if (semDown(semgid, sh->mutex) == -1){                                                  /* enter critical region */
+    if (semDown(semgid, sh->receptionLock) == -1){                                                  /* enter critical region */
         perror("error on the down operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
@@ -292,11 +719,15 @@ static void provideTableOrWaitingRoom(int n)
 
     // Verificar se existem mesas disponiveis
     if (table != -1){
-        // Se existirem mesas disponiveis, atribuir ao grupo a mesa disponivel e atualizar o estado deste
-        sh->fSt.assignedTable[n] = table;
+        // Se existirem mesas disponiveis, atribuir ao grupo a mesa disponivel e atualizar o estado deste (saindo da espera, se estava à espera)
+        if (groupRecord[n] == WAIT) {
+            sh->fSt.groupsWaiting--;
+        }
+        ASSIGNEDTABLE(n) = table;
         groupRecord[n] = ATTABLE;
+        occupyTable(table);
         // Sinalizar que o grupo pode prosseguir
-        if (semUp(semgid, sh->waitForTable[n]) == -1){
+        if (semUp(semgid, GROUPWAIT(n)) == -1){
             perror("error on the up operation for semaphore access (WT)");
             exit(EXIT_FAILURE);
         }
@@ -305,9 +736,11 @@ static void provideTableOrWaitingRoom(int n)
         // Se não existirem mesas disponiveis, atualizar o estado do grupo para WAIT e incrementar o numero de grupos à espera
         sh->fSt.groupsWaiting++;
         groupRecord[n] = WAIT;
+        // Colocar o grupo na sala de espera segundo a política de escalonamento
+        policy[sh->schedPolicy].push(n);
     }
 
-    if (semUp(semgid, sh->mutex) == -1){                                             /* exit critical region */
+    if (semUp(semgid, sh->receptionLock) == -1){                                             /* exit critical region */
         perror("error on the up operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
@@ -325,7 +758,9 @@ static void provideTableOrWaitingRoom(int n)
 
 static void receivePayment(int n)
 {
-    if (semDown(semgid, sh->mutex) == -1){                                                  /* enter critical region */
+    SEM_OP leave[] = {{TABLESYNC(ASSIGNEDTABLE(n)).tableDone, 1}, {sh->receptionLock, 1}};
+
+    if (semDown(semgid, sh->receptionLock) == -1){                                                  /* enter critical region */
         perror("error on the down operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
@@ -334,18 +769,14 @@ static void receivePayment(int n)
     sh->fSt.st.receptionistStat = RECVPAY;
     saveState(nFic, &sh->fSt);
 
-    // Libertar a mesa que o grupo estava a ocupar
-    if (semUp(semgid, sh->tableDone[sh->fSt.assignedTable[n]]) == -1){
-        perror("error on the up operation for semaphore access (WT)");
-        exit(EXIT_FAILURE);
-    }
-
     // Sinalizar que a mesa está disponivel e atualizar o estado do grupo
-    sh->fSt.assignedTable[n] = -1;
+    vacateTable(ASSIGNEDTABLE(n));
+    ASSIGNEDTABLE(n) = -1;
     groupRecord[n] = DONE;
     saveState(nFic, &sh->fSt);
 
-    if (semUp(semgid, sh->mutex) == -1){                                             /* exit critical region */
+    // Libertar a mesa que o grupo estava a ocupar e sair da região crítica
+    if (semOpMulti(semgid, leave, 2) == -1){                                         /* exit critical region */
         perror("error on the up operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
@@ -357,7 +788,6 @@ static void receivePayment(int n)
     if (group != -1){
         // Se existirem grupos à espera, atribuir uma mesa ao grupo e atualizar o estado deste
         provideTableOrWaitingRoom(group);
-        sh->fSt.groupsWaiting--;
     }
 
     // Se não existirem grupos à espera o programa termina
@@ -0,0 +1,92 @@
+/**
+ *  \file semSharedMemStaff.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  Synchronization based on semaphores and shared memory.
+ *
+ *  Life cycle of the event-driven staff: a single entity that is both the receptionist and the (single) waiter,
+ *  in the threaded and the forked engines (<tt>-e</tt>). Instead of blocking on the semaphore of one mailbox, it
+ *  waits for the notification of any of them (see notify.h) and then serves, without blocking, every pending
+ *  request of the ready ones: the requests of the groups to the receptionist (<tt>waitForGroup</tt>) and those of
+ *  the groups and the chefs to the waiter (<tt>waitForClientOrChef</tt>). A lightly loaded staff thus costs one
+ *  wake-up for all the requests posted meanwhile, instead of one wake-up of each entity per request.
+ *
+ *  The operations of each role are carried out by the receptionist and the waiter code, under their own locks;
+ *  only the orders of the waiter to the chefs may block, while the order queue is full or the chef has not
+ *  received the previous order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "logging.h"
+#include "sharedDataSync.h"
+#include "semaphore.h"
+#include "sharedMemory.h"
+#include "notify.h"
+
+/* roles of the staff (receptionist and waiter code compiled for the threaded and the forked engines) */
+extern int receptionistJoin (int argc, char *argv[]);
+extern bool receptionistPoll (void);
+extern int receptionistLeave (void);
+extern int waiterJoin (int argc, char *argv[]);
+extern bool waiterPoll (void);
+extern int waiterLeave (void);
+
+/**
+ *  \brief Life cycle of the event-driven staff.
+ *
+ *  \param argc number of command line parameters
+ *  \param argv command line parameters (name of the program, logging file, access key and error file, as those of
+ *         the receptionist and the waiter)
+ */
+int staffMain (int argc, char *argv[])
+{
+    int key;                                                      /* access key to shared memory and semaphore set */
+    char *tinp;                                                                  /* numerical parameters test flag */
+    int shmid;                                                                 /* shared memory access identifier */
+    SHARED_DATA *sh;                                                            /* pointer to shared memory region */
+    bool reception = true, kitchen = true;                           /* roles with requests still to be served */
+    unsigned int ready;                                                                   /* sources notified */
+
+    if ((receptionistJoin (argc, argv) == EXIT_FAILURE) || (waiterJoin (argc, argv) == EXIT_FAILURE)) {
+        return EXIT_FAILURE;
+    }
+    key = (unsigned int) strtol (argv[2], &tinp, 0);
+    if (((shmid = shmemConnect (key)) == -1) || (shmemAttach (shmid, (void **) &sh) == -1)) {
+        perror ("error on mapping the shared region on the process address space");
+        return EXIT_FAILURE;
+    }
+
+    /* simulation of the life cycle of the staff (until both roles have served all their requests) */
+    while (reception || kitchen) {
+        if (notifyWait (&sh->notify, &ready) == -1) {
+            perror ("error on waiting for the notification of requests");
+            return EXIT_FAILURE;
+        }
+        if (reception && (ready & (1u << NOTIFYRECEPTION))) {
+            logEntity (&sh->log, MEMBERRECEPTIONIST, 0);                   /* states saved by each role as its own */
+            semProfile (SEMSTATS, MEMBERRECEPTIONIST);
+            reception = receptionistPoll ();
+        }
+        if (kitchen && (ready & (1u << NOTIFYKITCHEN))) {
+            logEntity (&sh->log, MEMBERWAITER, 0);
+            semProfile (SEMSTATS, MEMBERWAITER);
+            kitchen = waiterPoll ();
+        }
+    }
+
+    if (shmemDettach (sh) == -1) {
+        perror ("error on unmapping the shared region off the process address space");
+        return EXIT_FAILURE;
+    }
+    if ((waiterLeave () == EXIT_FAILURE) || (receptionistLeave () == EXIT_FAILURE)) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -11,6 +11,11 @@
  *     \li informChef
  *     \li takeFoodToTable
  *
+ *  In the threaded and the forked engines, the waiter may also be a role of the event-driven staff (see
+ *  semSharedMemStaff.c), which joins the simulation, serves the pending requests without blocking whenever they
+ *  are notified and leaves the simulation through <tt>waiterJoin</tt>, <tt>waiterPoll</tt> and
+ *  <tt>waiterLeave</tt>.
+ *
  *  \author Nuno Lau - December 2023
  */
 
@@ -29,6 +34,10 @@
 #include "sharedDataSync.h"
 #include "semaphore.h"
 #include "sharedMemory.h"
+#include "mailbox.h"
+#include "virtualClock.h"
+#include "replay.h"
+#include "latency.h"
 
 /** \brief logging file name */
 static char nFic[51];
@@ -42,8 +51,31 @@ static int semgid;
 /** \brief pointer to shared memory region */
 static SHARED_DATA *sh;
 
-/** \brief waiter waits for next request */
-static request waitForClientOrChef();
+/** \brief set while the chef has not acknowledged the last food order (one per waiter thread in the threaded engine) */
+static __thread bool orderPending = false;
+
+/** \brief waiter joins the simulation */
+static int joinRestaurant(int argc, char *argv[]);
+
+/** \brief waiter leaves the simulation */
+static int leaveRestaurant(void);
+
+/** \brief waiter waits for next requests */
+static int waitForClientOrChef(request req[]);
+
+#if defined (THREADED) || defined (FORKED)
+/** \brief waiter takes, without blocking, the pending requests */
+static int pollForClientOrChef(request req[]);
+#endif
+
+/** \brief waiter updates its state to wait for requests */
+static bool startWaiting(void);
+
+/** \brief waiter takes the requests claimed */
+static int takeRequests(request req[], int n);
+
+/** \brief waiter serves the requests taken */
+static void serveRequests(request req[], int n);
 
 /** \brief waiter takes food order to chef */
 static void informChef(int group);
@@ -57,6 +89,77 @@ static void takeFoodToTable(int group);
  *  Its role is to generate the life cycle of one of intervening entities in the problem: the waiter.
  */
 int main(int argc, char *argv[])
+{
+    if (joinRestaurant(argc, argv) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+
+    /* simulation of the life cycle of the waiter (until all requests are served by the waiters) */
+    request req[MAXMAILBOX + 1];
+    int nReq;
+    while ((nReq = waitForClientOrChef(req)) > 0)
+    {
+        serveRequests(req, nReq);
+    }
+
+    return leaveRestaurant();
+}
+
+#if defined (THREADED) || defined (FORKED)
+/**
+ *  \brief Joining the simulation as a role of the event-driven staff.
+ *
+ *  \param argc number of command line parameters
+ *  \param argv command line parameters (those of the waiter)
+ *
+ *  \return \c EXIT_SUCCESS, upon success
+ *  \return \c EXIT_FAILURE, when an error occurs
+ */
+int waiterJoin(int argc, char *argv[])
+{
+    return joinRestaurant(argc, argv);
+}
+
+/**
+ *  \brief Serving the pending requests as a role of the event-driven staff.
+ *
+ *  The requests counted by the waiter semaphore are taken and served without blocking; if there were any and
+ *  there are more requests to come, the waiter waits for requests again.
+ *
+ *  \return true while there are requests still to be served
+ */
+bool waiterPoll(void)
+{
+    request req[MAXMAILBOX + 1];
+    int n = pollForClientOrChef(req);
+
+    serveRequests(req, n);
+    return (n > 0) ? startWaiting() : (sh->requestsToServe > 0);
+}
+
+/**
+ *  \brief Leaving the simulation as a role of the event-driven staff.
+ *
+ *  \return \c EXIT_SUCCESS, upon success
+ *  \return \c EXIT_FAILURE, when an error occurs
+ */
+int waiterLeave(void)
+{
+    return leaveRestaurant();
+}
+#endif
+
+/**
+ *  \brief waiter joins the simulation
+ *
+ *  The command line parameters are validated, the shared region is mapped, the log session is opened and the
+ *  clock, the replay and the statistics are joined.
+ *
+ *  \return \c EXIT_SUCCESS, upon success
+ *  \return \c EXIT_FAILURE, when an error occurs
+ */
+static int joinRestaurant(int argc, char *argv[])
 {
     int key;    /*access key to shared memory and semaphore set */
     char *tinp; /* numerical parameters test flag */
@@ -68,11 +171,13 @@ int main(int argc, char *argv[])
         fprintf(stderr, "Number of parameters is incorrect!\n");
         return EXIT_FAILURE;
     }
+#ifndef THREADED
     else
-    {
+    {                                               /* the threaded engine keeps the stderr of the generator */
         freopen(argv[3], "w", stderr);
         setbuf(stderr, NULL);
     }
+#endif
 
     strcpy(nFic, argv[1]);
     key = (unsigned int)strtol(argv[2], &tinp, 0);
@@ -99,27 +204,47 @@ int main(int argc, char *argv[])
         perror("error on mapping the shared region on the process address space");
         return EXIT_FAILURE;
     }
+    if ((sh->placement & SHMPREFAULT) && (shmemPlace(shmid, sh, SHMPREFAULT, 0) == -1))
+    {
+        perror("error on faulting the shared region in");
+        return EXIT_FAILURE;
+    }
 
     /* initialize random generator */
     srandom((unsigned int)getpid());
 
-    /* simulation of the life cycle of the waiter */
-    int nReq = 0;
-    request req;
-    while (nReq < sh->fSt.nGroups * 2)
-    {
-        req = waitForClientOrChef();
-        switch (req.reqType)
-        {
-        case FOODREQ:
-            informChef(req.reqGroup);
-            break;
-        case FOODREADY:
-            takeFoodToTable(req.reqGroup);
-            break;
-        }
-        nReq++;
-    }
+    /* open log session */
+    openLogSession(nFic, &sh->log, semgid);
+    logEntity(&sh->log, MEMBERWAITER, -1);
+
+    /* join the virtual clock, the replay and the latency statistics */
+    joinClock(semgid, &sh->clock, -1);
+    joinReplay(semgid, &sh->replay, MEMBERWAITER, -1);
+    joinLatency(&sh->lat);
+    semProfile(SEMSTATS, MEMBERWAITER);
+
+    /* no order was placed yet (the life cycle may run again in the same process, see the pool of the forked engine) */
+    orderPending = false;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ *  \brief waiter leaves the simulation
+ *
+ *  The statistics, the replay and the clock are left, the log session is closed and the shared region is unmapped.
+ *
+ *  \return \c EXIT_SUCCESS, upon success
+ *  \return \c EXIT_FAILURE, when an error occurs
+ */
+static int leaveRestaurant(void)
+{
+    /* leave the latency statistics, the replay and the virtual clock and close log session */
+    semProfile(NULL, 0);
+    leaveLatency(&sh->lat);
+    leaveReplay(&sh->replay);
+    leaveClock(semgid, &sh->clock);
+    closeLogSession();
 
     /* unmapping the shared region off the process address space */
     if (shmemDettach(sh) == -1)
@@ -133,60 +258,193 @@ int main(int argc, char *argv[])
 }
 
 /**
- *  \brief waiter waits for next request
+ *  \brief waiter serves the requests taken
  *
- *  Waiter updates state and waits for request from group or from chef, then reads request.
+ *  \param req requests taken
+ *  \param n number of requests
+ */
+static void serveRequests(request req[], int n)
+{
+    int r;
+
+    for (r = 0; r < n; r++)
+    {
+        switch (req[r].reqType)
+        {
+        case FOODREQ:
+            informChef(req[r].reqGroup);
+            break;
+        case FOODREADY:
+            takeFoodToTable(req[r].reqGroup);
+            break;
+        }
+    }
+}
+
+/**
+ *  \brief waiter waits for next requests
+ *
+ *  Waiter updates state and waits for request from group or from chef, then reads request
+ *  and all the other pending requests it may take (saving the state once).
  *  The waiter should signal that new requests are possible.
  *  The internal state should be saved.
  *
- *  \return request submitted by group or chef
+ *  Food handed by the chef is served first; the chef has its own request slot, which does not take
+ *  the request slot of the groups.
+ *
+ *  When all requests are served, the waiter serving the last one wakes up the other waiters, so that
+ *  they terminate.
+ *
+ *  \param req array where the requests submitted by groups or chef are stored (up to <tt>MAXMAILBOX + 1</tt>)
+ *
+ *  \return number of requests (0 when there are no more requests)
  */
-static request waitForClientOrChef()
+static int waitForClientOrChef(request req[])
 {
-    request req;
+    SEM_OP enter[] = {{sh->waiterRequest, -1}, {sh->kitchenLock, -1}};
+    int extra;
+
+    // Terminar se todos os pedidos já foram servidos
+    if (!startWaiting()){
+        return 0;
+    }
 
-    if (semDown(semgid, sh->mutex) == -1){                                                      /* enter critical region */
+    // Bloquear o Waiter até que haja um pedido e entrar na região crítica
+    if (semOpMulti(semgid, enter, 2) == -1){                                                    /* enter critical region */
         perror("error on the down operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
 
-    // Atualizar e guardar o estado do Waiter para WAIT_FOR_REQUEST
-    sh->fSt.st.waiterStat = WAIT_FOR_REQUEST;
-    saveState(nFic, &sh->fSt);
+    // Terminar se o Waiter foi acordado por outro Waiter depois de todos os pedidos serem servidos
+    if (sh->requestsToServe == 0){
+        if (semUp(semgid, sh->kitchenLock) == -1){                                                  /* exit critical region */
+            perror("error on the up operation for semaphore access (WT)");
+            exit(EXIT_FAILURE);
+        }
+        return 0;
+    }
 
-    if (semUp(semgid, sh->mutex) == -1){                                                      /* exit critical region */
-        perror("error on the up operation for semaphore access (WT)");
+    // Reservar, sem bloquear, os restantes pedidos pendentes
+    extra = (sh->foodReady.reqType == FOODREADY) + pendingRequests(&sh->waiterBox, &sh->fSt.waiterRequest) - 1;
+    if ((extra > 0) && ((extra = semTryDown(semgid, sh->waiterRequest, extra)) == -1)){
+        perror("error on the down operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
 
-    // Bloquear o Waiter até que haja um pedido
-    if (semDown(semgid, sh->waiterRequest) == -1){
+    return takeRequests(req, 1 + extra);
+}
+
+#if defined (THREADED) || defined (FORKED)
+/**
+ *  \brief waiter takes, without blocking, the pending requests
+ *
+ *  Waiter claims the requests counted by its semaphore, without blocking, then reads them (saving the state once)
+ *  and signals that new requests are possible (event-driven staff, a single waiter).
+ *
+ *  \param req array where the requests submitted by groups or chef are stored (up to <tt>MAXMAILBOX + 1</tt>)
+ *
+ *  \return number of requests (0 if there were none)
+ */
+static int pollForClientOrChef(request req[])
+{
+    int n;
+
+    // Reservar, sem bloquear, os pedidos pendentes
+    if ((n = semTryDown(semgid, sh->waiterRequest, MAXMAILBOX + 1)) == -1){
         perror("error on the down operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
+    if (n == 0){
+        return 0;
+    }
 
-    if (semDown(semgid, sh->mutex) == -1){                                                      /* enter critical region */
+    if (semDown(semgid, sh->kitchenLock) == -1){                                                      /* enter critical region */
         perror("error on the down operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
+    return takeRequests(req, n);
+}
+#endif
 
-    // Atualizar a variável req com o pedido com o pedido do grupo e reiniciar o pedido do Waiter, guardando o estado
-    req = sh->fSt.waiterRequest;
-    sh->fSt.waiterRequest.reqType = -1;
-    sh->fSt.waiterRequest.reqGroup = -1;
-    saveState(nFic, &sh->fSt);
+/**
+ *  \brief waiter updates its state to wait for requests
+ *
+ *  The internal state should be saved, unless all requests were served.
+ *
+ *  \return true if there are requests still to be served, false otherwise
+ */
+static bool startWaiting(void)
+{
+    bool more;
 
-    if (semUp(semgid, sh->mutex) == -1){                                                      /* exit critical region */
+    if (semDown(semgid, sh->kitchenLock) == -1){                                                      /* enter critical region */
+        perror("error on the down operation for semaphore access (WT)");
+        exit(EXIT_FAILURE);
+    }
+
+    // Atualizar e guardar o estado do Waiter para WAIT_FOR_REQUEST, se houver pedidos por servir
+    if ((more = (sh->requestsToServe > 0))){
+        sh->fSt.st.waiterStat = WAIT_FOR_REQUEST;
+        saveState(nFic, &sh->fSt);
+    }
+
+    if (semUp(semgid, sh->kitchenLock) == -1){                                                      /* exit critical region */
         perror("error on the up operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
+    return more;
+}
 
-    // Sinalizar que o Waiter pode receber pedidos
-    if (semUp(semgid, sh->waiterRequestPossible) == -1){
+/**
+ *  \brief waiter takes the requests claimed
+ *
+ *  Called within the critical region, once the requests were claimed; the critical region is left.
+ *  Food handed by the chef is taken first.
+ *
+ *  \param req array where the requests are stored
+ *  \param n number of requests claimed
+ *
+ *  \return number of requests
+ */
+static int takeRequests(request req[], int n)
+{
+    SEM_OP leave[4] = {{sh->kitchenLock, 1}};
+    int nOps = 1;
+    int nReq, fromBox = 0;
+
+    // Atualizar a variável req com o pedido do Chef, se existir, e com os pedidos dos grupos e reiniciar os pedidos, guardando o estado
+    for (nReq = 0; nReq < n; nReq++){
+        if (sh->foodReady.reqType == FOODREADY){
+            req[nReq] = sh->foodReady;
+            sh->foodReady.reqType = -1;
+            sh->foodReady.reqGroup = -1;
+            leave[nOps].sindex = sh->foodReadyPossible;
+            leave[nOps++].delta = 1;
+        }
+        else{
+            req[nReq] = takeRequest(&sh->waiterBox, &sh->fSt.waiterRequest);
+            fromBox++;
+        }
+    }
+    if (fromBox > 0){
+        leave[nOps].sindex = sh->waiterRequestPossible;
+        leave[nOps++].delta = fromBox;
+    }
+    sh->requestsToServe -= nReq;
+    saveState(nFic, &sh->fSt);
+
+    // Acordar os outros Waiters depois do último pedido
+    if ((sh->requestsToServe == 0) && (sh->nWaiters > 1)){
+        leave[nOps].sindex = sh->waiterRequest;
+        leave[nOps++].delta = sh->nWaiters - 1;
+    }
+
+    // Sair da região crítica e sinalizar que o Waiter pode receber pedidos
+    if (semOpMulti(semgid, leave, nOps) == -1){                                                  /* exit critical region */
         perror("error on the up operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
-    return req;
+    return nReq;
 }
 
 /**
@@ -197,42 +455,57 @@ static request waitForClientOrChef()
  *  Waiter should wait for chef receiving request.
  *  The internal state should be saved.
  *
+ *  The waiter waits for the chef to receive the previous order before placing a new one, instead of waiting
+ *  after placing it, so that it keeps serving the food handed by the chef in the meantime.
+ *  With the order queue, the waiter only waits for a vacant slot of the queue (and <tt>foodOrder</tt> is the
+ *  number of queued orders).
  */
 static void informChef(int n)
 {
-    if (semDown(semgid, sh->mutex) == -1){                                                      /* enter critical region */
-        perror("error on the down operation for semaphore access (WT)");
-        exit(EXIT_FAILURE);
+    SEM_OP enter[] = {{sh->orderSlots, -1}, {sh->kitchenLock, -1}};
+    SEM_OP leave[] = {{sh->kitchenLock, 1}, {TABLESYNC(ASSIGNEDTABLE(n)).requestReceived, 1}, {sh->waitOrder, 1}};
+
+    if (sh->queueOrders){
+        // Bloquear o Waiter até que haja uma posição livre na fila de pedidos e entrar na região crítica
+        if (semOpMulti(semgid, enter, 2) == -1){                                                /* enter critical region */
+            perror("error on the down operation for semaphore access (WT)");
+            exit(EXIT_FAILURE);
+        }
+    }
+    else{
+        // Bloquear o Waiter até que o Chef receba o pedido anterior
+        if (orderPending && (semDown(semgid, sh->orderReceived) == -1)){
+            perror("error on the down operation for semaphore access (WT)");
+            exit(EXIT_FAILURE);
+        }
+
+        if (semDown(semgid, sh->kitchenLock) == -1){                                                  /* enter critical region */
+            perror("error on the down operation for semaphore access (WT)");
+            exit(EXIT_FAILURE);
+        }
     }
 
     // Atualizar o estado do Waiter para INFORM_CHEF, indicar que há um pedido de comida e qual o grupo que o pediu e guardar os respetivos estados
     sh->fSt.st.waiterStat = INFORM_CHEF;
-    sh->fSt.foodOrder = 1;
-    sh->fSt.foodGroup = n;
-    saveState(nFic, &sh->fSt);
-
-    if (semUp(semgid, sh->mutex) == -1){                                                      /* exit critical region */
-        perror("error on the up operation for semaphore access (WT)");
-        exit(EXIT_FAILURE);
+    if (sh->queueOrders){
+        // Colocar o pedido no fim da fila de pedidos, com o instante em que foi feito
+        sh->orders.group[(sh->orders.head + sh->orders.count) % sh->orders.size] = n;
+        sh->orders.placed[(sh->orders.head + sh->orders.count) % sh->orders.size] = clockNow(&sh->clock) / 1000;
+        sh->orders.count++;
+        sh->fSt.foodOrder = sh->orders.count;
     }
-
-    // Sinalizar que o pedido do grupo foi recebido pelo Waiter
-    if (semUp(semgid, sh->requestReceived[sh->fSt.assignedTable[n]]) == -1){
-        perror("error on the up operation for semaphore access (WT)");
-        exit(EXIT_FAILURE);
+    else{
+        sh->fSt.foodOrder = 1;
     }
+    sh->fSt.foodGroup = n;
+    saveState(nFic, &sh->fSt);
 
-    // Informar o Chef que há um pedido de comida
-    if (semUp(semgid, sh->waitOrder) == -1){
+    // Sair da região crítica, sinalizar que o pedido do grupo foi recebido pelo Waiter e informar o Chef que há um pedido de comida
+    if (semOpMulti(semgid, leave, 3) == -1){                                                  /* exit critical region */
         perror("error on the up operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
-
-    // Bloquear o Waiter até que o Chef receba o pedido
-    if (semDown(semgid, sh->orderReceived) == -1){
-        perror("error on the down operation for semaphore access (WT)");
-        exit(EXIT_FAILURE);
-    }
+    orderPending = !sh->queueOrders;
 }
 
 /**
@@ -246,7 +519,9 @@ static void informChef(int n)
 
 static void takeFoodToTable(int n)
 {
-    if (semDown(semgid, sh->mutex) == -1){                                                      /* enter critical region */
+    SEM_OP leave[] = {{TABLESYNC(ASSIGNEDTABLE(n)).foodArrived, 1}, {sh->kitchenLock, 1}};
+
+    if (semDown(semgid, sh->kitchenLock) == -1){                                                      /* enter critical region */
         perror("error on the down operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
@@ -255,13 +530,8 @@ static void takeFoodToTable(int n)
     sh->fSt.st.waiterStat = TAKE_TO_TABLE;
     saveState(nFic, &sh->fSt);
 
-    // Informar o grupo que a comida chegou
-    if (semUp(semgid, sh->foodArrived[sh->fSt.assignedTable[n]]) == -1){
-        perror("error on the up operation for semaphore access (WT)");
-        exit(EXIT_FAILURE);
-    }
-
-    if (semUp(semgid, sh->mutex) == -1){                                                      /* exit critical region */
+    // Informar o grupo que a comida chegou e sair da região crítica
+    if (semOpMulti(semgid, leave, 2) == -1){                                                  /* exit critical region */
         perror("error on the up operation for semaphore access (WT)");
         exit(EXIT_FAILURE);
     }
@@ -9,20 +9,206 @@
  *     \li destruction of a previously created set of semaphores
  *     \li signalling start of operations
  *     \li <em>down</em> of a semaphore within the set
- *     \li <em>up</em> of a semaphore within the set.
+ *     \li <em>up</em> of a semaphore within the set
+ *     \li several <em>downs</em> and <em>ups</em> of semaphores within the set in a single operation
+ *     \li tracking of the blocking operations of a thread
+ *     \li counting the blocked threads that may proceed, reading the value of a semaphore and waiting for it to
+ *         be zero
+ *     \li reading and setting the values of all semaphores of the set
+ *     \li sequencing the <em>downs</em> of a thread
+ *     \li timing the <em>downs</em> of a thread
+ *     \li profiling the contention of the <em>downs</em> of a thread.
  *
  *  \author António Rui Borges - October 1995
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/sem.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
 #include <assert.h>
 
+#include "semaphore.h"
+
 /** \brief access permission: user r-w */
 #define  MASK           0600
 
+/** \brief semaphore counting the tracked threads that are not blocked (0 while the thread is not tracked) */
+static __thread unsigned short runSem = 0;
+
+/** \brief wait descriptor of the thread (in shared memory) */
+static __thread SEM_WAIT *waitDesc = NULL;
+
+/** \brief counter of blocking operations (in shared memory) */
+static __thread unsigned int *blockCount = NULL;
+
+/** \brief sequencer of the downs of the thread (NULL if they are not sequenced) */
+static __thread SEM_SEQUENCER *sequencer = NULL;
+
+/** \brief histograms of the downs of the thread, indexed by semaphore location (NULL if they are not timed) */
+static __thread HISTOGRAM *waitTimes = NULL;
+
+#ifdef SEMPROFILE
+/** \brief contention profile the downs of the thread are counted in (NULL if they are not profiled) */
+static __thread SEM_STATS *profile = NULL;
+
+/** \brief caller the downs of the thread are counted for */
+static __thread unsigned int profCaller = 0;
+#endif
+
+/** \brief argument of semctl */
+union semun {
+    int val;
+    struct semid_ds *buf;
+    unsigned short *array;
+};
+
+/* internal functions */
+
+/*
+ *  Operations that may block: when blocking operations are tracked, the operations are tried first without
+ *  blocking; if they would block, they are stored in the wait descriptor, the thread leaves the running semaphore
+ *  and waits for the operations and its return to the running semaphore, which take place atomically.
+ *  Array sops has room for one more operation.
+ */
+
+static int blockingOp (int semgid, struct sembuf sops[], unsigned int nops)
+{
+  struct sembuf leave = { 0, -1, 0 };                                            /* leaving the running semaphore */
+  unsigned int n;
+  int stat;
+
+  if (runSem == 0)
+     return semop (semgid, sops, nops);
+  for (n = 0; n < nops; n++)
+    sops[n].sem_flg = IPC_NOWAIT;
+  if (((stat = semop (semgid, sops, nops)) == 0) || (errno != EAGAIN))
+     return stat;
+  assert(nops<=MAXWAITOPS);
+  for (n = 0; n < nops; n++)
+  { sops[n].sem_flg = 0;
+    waitDesc->ops[n].sindex = sops[n].sem_num;
+    waitDesc->ops[n].delta = sops[n].sem_op;
+  }
+  waitDesc->nops = nops;
+  __atomic_add_fetch (blockCount, 1, __ATOMIC_SEQ_CST);
+  leave.sem_num = runSem;
+  if (semop (semgid, &leave, 1) == -1)
+     return -1;
+  sops[nops].sem_num = runSem;
+  sops[nops].sem_op = 1;
+  sops[nops].sem_flg = 0;
+  return semop (semgid, sops, nops + 1);
+}
+
+#ifdef SEMPROFILE
+/*
+ *  Profiled blocking operations: the operations are tried first without blocking; if they would block, the first
+ *  semaphore in red state (the awaited event comes before the locks) is contended and the time blocked is added
+ *  to its counters (to the first semaphore decremented, if none still is). Every semaphore decremented is
+ *  acquired.
+ */
+
+static int profiledOp (int semgid, struct sembuf sops[], unsigned int nops)
+{
+  bool red[nops];                                                   /* semaphores that could not be decremented */
+  bool found = false;                                                        /* some semaphore was in red state */
+  struct timespec start, end;
+  unsigned long blocked;                                                                         /* time blocked */
+  unsigned int n, d;
+  int stat;
+
+  for (d = 0; (d < nops - 1) && (sops[d].sem_op >= 0); d++)
+    ;
+  if (profile == NULL)
+     return blockingOp (semgid, sops, nops);
+  for (n = 0; n < nops; n++)
+    sops[n].sem_flg = IPC_NOWAIT;
+  stat = semop (semgid, sops, nops);
+  for (n = 0; n < nops; n++)
+  { sops[n].sem_flg = 0;
+    red[n] = false;
+  }
+  if (stat == -1) {
+     if (errno != EAGAIN)
+        return -1;
+     for (n = 0; (n < nops) && !found; n++)
+       if ((sops[n].sem_op < 0) && (semctl (semgid, sops[n].sem_num, GETVAL) < -sops[n].sem_op))
+          found = red[n] = true;
+     if (!found)
+        red[d] = true;
+     clock_gettime (CLOCK_MONOTONIC, &start);
+     if (blockingOp (semgid, sops, nops) == -1)
+        return -1;
+     clock_gettime (CLOCK_MONOTONIC, &end);
+  }
+  blocked = (stat == -1) ? (end.tv_sec - start.tv_sec) * 1000000000UL + end.tv_nsec - start.tv_nsec : 0;
+  for (n = 0; n < nops; n++)
+    if ((sops[n].sem_op < 0) && (sops[n].sem_num < profile->nSems)) {
+       SEM_COUNTERS *cnt = &SEMCOUNTERS (profile, sops[n].sem_num, profCaller);
+
+       __atomic_add_fetch (&cnt->acquires, 1, __ATOMIC_RELAXED);
+       if (red[n]) {
+          __atomic_add_fetch (&cnt->contended, 1, __ATOMIC_RELAXED);
+          __atomic_add_fetch (&cnt->blocked, blocked, __ATOMIC_RELAXED);
+       }
+    }
+  return 0;
+}
+#else
+#define  profiledOp     blockingOp
+#endif
+
+/*
+ *  Timed blocking operations: the time is recorded for the first semaphore decremented.
+ */
+
+static int timedOp (int semgid, struct sembuf sops[], unsigned int nops)
+{
+  struct timespec start, end;
+  unsigned int n;
+  int stat;
+
+  if (waitTimes == NULL)
+     return profiledOp (semgid, sops, nops);
+  for (n = 0; (n < nops - 1) && (sops[n].sem_op >= 0); n++)
+    ;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  if ((stat = profiledOp (semgid, sops, nops)) == 0) {
+     clock_gettime (CLOCK_MONOTONIC, &end);
+     histRecord (&waitTimes[sops[n].sem_num],
+                 (end.tv_sec - start.tv_sec) * 1000000000UL + end.tv_nsec - start.tv_nsec);
+  }
+  return stat;
+}
+
+/*
+ *  Sequenced blocking operations: the functions of the sequencer are called around the operations, with
+ *  sequencing suspended, so that their own operations are not sequenced.
+ */
+
+static int sequencedOp (int semgid, struct sembuf sops[], unsigned int nops)
+{
+  SEM_SEQUENCER *seq = sequencer;
+  int stat;
+
+  if (seq == NULL)
+     return timedOp (semgid, sops, nops);
+  sequencer = NULL;
+  seq->enter (seq->arg, -1);
+  if ((stat = timedOp (semgid, sops, nops)) == 0)
+     seq->leave (seq->arg, -1);
+  sequencer = seq;
+  return stat;
+}
+
+/* external functions */
+
 /**
  *  \brief Creation of a set of semaphores.
  *
@@ -112,11 +298,11 @@ int semSignal (int semgid)
 
 int semDown (int semgid, unsigned int sindex)
 {
-  struct sembuf down = { 0, -1, 0 };                                                      /* specific down operation */
+  struct sembuf down[2] = {{ 0, -1, 0 }};                                                 /* specific down operation */
 
   assert(sindex>0);
-  down.sem_num = (unsigned short) sindex;
-  return semop (semgid, &down, 1);
+  down[0].sem_num = (unsigned short) sindex;
+  return sequencedOp (semgid, down, 1);
 }
 
 /**
@@ -139,3 +325,343 @@ int semUp (int semgid, unsigned int sindex)
   up.sem_num = (unsigned short) sindex;
   return semop (semgid, &up, 1);
 }
+
+/**
+ *  \brief Several <em>downs</em> of a semaphore within the set, without blocking.
+ *
+ *  Up to <tt>max</tt> <em>downs</em> are carried out, while the semaphore is in <em>green state</em>.
+ *  When the <em>downs</em> of the thread are sequenced, the sequencer may impose the number of <em>downs</em>,
+ *  which are then carried out blocking if needed.
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param max maximum number of downs
+ *
+ *  \return number of downs carried out, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semTryDown (int semgid, unsigned int sindex, unsigned int max)
+{
+  struct sembuf down[2] = {{ 0, -1, IPC_NOWAIT }};                               /* specific non blocking down */
+  SEM_SEQUENCER *seq = sequencer;
+  int forced = -1;                                                     /* number of downs imposed by the sequencer */
+  int stat = 0;
+  unsigned int n;
+
+  assert(sindex>0);
+  down[0].sem_num = (unsigned short) sindex;
+  if (seq != NULL) {
+     sequencer = NULL;
+     forced = seq->enter (seq->arg, (int) max);
+  }
+  if (forced >= 0) {                                              /* imposed number of downs, blocking if needed */
+     down[0].sem_flg = 0;
+     for (n = 0; (n < (unsigned int) forced) && ((stat = timedOp (semgid, down, 1)) == 0); n++)
+       ;
+  }
+  else for (n = 0; n < max; n++)
+         if ((stat = semop (semgid, down, 1)) == -1) {
+            if (errno == EAGAIN)
+               stat = 0;
+            break;
+         }
+#ifdef SEMPROFILE
+  if ((forced < 0) && (profile != NULL) && (sindex < profile->nSems))     /* non blocking downs are not contended */
+     __atomic_add_fetch (&SEMCOUNTERS (profile, sindex, profCaller).acquires, n, __ATOMIC_RELAXED);
+#endif
+  if (seq != NULL) {
+     if (stat == 0)
+        seq->leave (seq->arg, (int) n);
+     sequencer = seq;
+  }
+  return (stat == 0) ? (int) n : -1;
+}
+
+/**
+ *  \brief Several <em>downs</em> and <em>ups</em> of semaphores within the set in a single operation.
+ *
+ *  The operations are carried out atomically by a single <tt>semop</tt>: the process blocks until all
+ *  <em>downs</em> can take place.
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param ops operations to be carried out
+ *  \param nops number of operations (>= 1)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semOpMulti (int semgid, SEM_OP ops[], unsigned int nops)
+{
+  struct sembuf sops[nops+1];                                                           /* all operations at once */
+  bool downs = false;                                                          /* some operation is a down */
+  unsigned int n;
+
+  assert(nops>0);
+  for (n = 0; n < nops; n++)
+  { assert(ops[n].sindex>0);
+    sops[n].sem_num = (unsigned short) ops[n].sindex;
+    sops[n].sem_op = (short) ops[n].delta;
+    sops[n].sem_flg = 0;
+    if (ops[n].delta < 0)
+       downs = true;
+  }
+  return downs ? sequencedOp (semgid, sops, nops) : semop (semgid, sops, nops);
+}
+
+/**
+ *  \brief Tracking of the blocking operations of the calling thread.
+ *
+ *  From now on, when a <em>down</em> of the calling thread has to block, its operations are stored in the wait
+ *  descriptor pointed by <tt>wait</tt>, the counter pointed by <tt>pCount</tt> is incremented and the semaphore
+ *  <tt>sindex</tt> is decremented before blocking; it is incremented again by the same operation that unblocks
+ *  the thread. So, the semaphore counts the tracked threads that are not blocked.
+ *  Tracking stops when <tt>wait</tt> is a null pointer.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param wait pointer to the wait descriptor of the thread (in shared memory)
+ *  \param pCount pointer to the counter of blocking operations (in shared memory)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semTrackBlocking (int semgid, unsigned int sindex, SEM_WAIT *wait, unsigned int *pCount)
+{
+  if (wait == NULL) {
+     runSem = 0;
+     waitDesc = NULL;
+     blockCount = NULL;
+     return 0;
+  }
+  assert(sindex>0);
+  if (semctl (semgid, sindex, GETVAL) == -1)
+     return -1;
+  wait->nops = 0;
+  waitDesc = wait;
+  blockCount = pCount;
+  runSem = (unsigned short) sindex;
+  return 0;
+}
+
+/**
+ *  \brief Counting the wait descriptors whose operations may take place with the current values of the semaphores.
+ *
+ *  The operations of each descriptor are carried out, in order, on a copy of the values of the semaphores: they
+ *  would block if a value became negative.
+ *
+ *  \param semgid set identifier
+ *  \param waits wait descriptors
+ *  \param n number of wait descriptors
+ *
+ *  \return number of wait descriptors whose operations would not block, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semUnblockable (int semgid, SEM_WAIT waits[], unsigned int n)
+{
+  static unsigned short *val = NULL;                                                  /* values of the semaphores */
+  static unsigned int nval = 0;
+  struct semid_ds ds;                                                                         /* set information */
+  union semun arg;                                                                             /* semctl argument */
+  unsigned int w, k, j;
+  int count = 0, v;
+
+  arg.buf = &ds;
+  if (semctl (semgid, 0, IPC_STAT, arg) == -1)
+     return -1;
+  if (nval < ds.sem_nsems) {
+     free (val);
+     nval = ds.sem_nsems;
+     if ((val = malloc (nval * sizeof (unsigned short))) == NULL)
+        return -1;
+  }
+  arg.array = val;
+  if (semctl (semgid, 0, GETALL, arg) == -1)
+     return -1;
+  for (w = 0; w < n; w++)
+  { for (k = 0; k < waits[w].nops; k++)
+    { v = val[waits[w].ops[k].sindex];
+      for (j = 0; j < k; j++)
+        if (waits[w].ops[j].sindex == waits[w].ops[k].sindex)
+           v += waits[w].ops[j].delta;
+      if (v + waits[w].ops[k].delta < 0)
+         break;
+    }
+    if ((waits[w].nops > 0) && (k == waits[w].nops))
+       count += 1;
+  }
+  return count;
+}
+
+/**
+ *  \brief Reading the value of a semaphore within the set.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return value of the semaphore, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semValue (int semgid, unsigned int sindex)
+{
+  assert(sindex>0);
+  return semctl (semgid, sindex, GETVAL);
+}
+
+/**
+ *  \brief Reading the values of all semaphores of the set.
+ *
+ *  The values of the semaphores at locations 0 (start of operations) to snum are stored in <tt>values</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param values array of snum + 1 values
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semGetAll (int semgid, unsigned short values[])
+{
+  union semun arg;                                                                             /* semctl argument */
+
+  arg.array = values;
+  return semctl (semgid, 0, GETALL, arg);
+}
+
+/**
+ *  \brief Setting the values of all semaphores of the set.
+ *
+ *  The semaphores at locations 0 (start of operations) to snum take the values stored in <tt>values</tt>, as
+ *  read by <tt>semGetAll</tt>. No thread may be blocked on a semaphore of the set.
+ *
+ *  \param semgid set identifier
+ *  \param values array of snum + 1 values
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semSetAll (int semgid, unsigned short values[])
+{
+  union semun arg;                                                                             /* semctl argument */
+
+  arg.array = values;
+  return semctl (semgid, 0, SETALL, arg);
+}
+
+/**
+ *  \brief Waiting for a semaphore within the set to be zero.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semWaitZero (int semgid, unsigned int sindex)
+{
+  struct sembuf zero = { 0, 0, 0 };                                                   /* specific wait for zero */
+
+  assert(sindex>0);
+  zero.sem_num = (unsigned short) sindex;
+  return semop (semgid, &zero, 1);
+}
+
+/**
+ *  \brief Sequencing the <em>downs</em> of the calling thread.
+ *
+ *  From now on, the functions of the sequencer pointed by <tt>seq</tt> are called around every <em>down</em>
+ *  (including the operations of several semaphores with at least one <em>down</em>) of the calling thread.
+ *  Sequencing stops when <tt>seq</tt> is a null pointer.
+ *
+ *  \param seq pointer to the sequencer
+ *
+ *  \return \c 0, upon success
+ */
+
+int semSequence (SEM_SEQUENCER *seq)
+{
+  sequencer = seq;
+  return 0;
+}
+
+/**
+ *  \brief Timing the <em>downs</em> of the calling thread.
+ *
+ *  From now on, the time (in nanoseconds of the monotonic clock) the calling thread takes to carry out a
+ *  <em>down</em> that may block is recorded in <tt>waits[sindex]</tt>. The time of several operations in a single
+ *  operation is recorded for the first semaphore decremented.
+ *  Timing stops when <tt>waits</tt> is a null pointer.
+ *
+ *  \param waits histograms of the downs of each semaphore within the set (indexed by semaphore location)
+ *
+ *  \return \c 0, upon success
+ */
+
+int semTimeWaits (HISTOGRAM waits[])
+{
+  waitTimes = waits;
+  return 0;
+}
+
+/**
+ *  \brief Size of a contention profile.
+ *
+ *  \param nSems number of semaphores (including the start of operations semaphore)
+ *  \param nCallers number of callers
+ *
+ *  \return number of bytes required by the profile
+ */
+
+unsigned long semStatsBytes (unsigned int nSems, unsigned int nCallers)
+{
+  return sizeof (SEM_STATS) + (unsigned long) nSems * nCallers * sizeof (SEM_COUNTERS);
+}
+
+/**
+ *  \brief Initialization of a contention profile: every counter is zeroed.
+ *
+ *  \param stats pointer to the profile
+ *  \param nSems number of semaphores (including the start of operations semaphore)
+ *  \param nCallers number of callers
+ */
+
+void semInitStats (SEM_STATS *stats, unsigned int nSems, unsigned int nCallers)
+{
+  memset (stats, 0, semStatsBytes (nSems, nCallers));
+  stats->nSems = nSems;
+  stats->nCallers = nCallers;
+}
+
+/**
+ *  \brief Profiling the contention of the <em>downs</em> of the calling thread.
+ *
+ *  From now on, every <em>down</em> of the calling thread is counted in the counters of the semaphore and
+ *  <tt>caller</tt>; a <em>down</em> that may block is tried first without blocking and, when it would block,
+ *  counted as contended and the time blocked is added. Every semaphore decremented by several operations in a
+ *  single operation is counted; the contended one is the first in red state when the operations were tried.
+ *  Profiling stops when <tt>stats</tt> is a null pointer; it has no effect unless compiled with <tt>SEMPROFILE</tt>
+ *  defined.
+ *
+ *  \param stats pointer to the profile
+ *  \param caller caller the downs are counted for (0 .. nCallers-1)
+ *
+ *  \return \c 0, upon success
+ */
+
+int semProfile (SEM_STATS *stats, unsigned int caller)
+{
+#ifdef SEMPROFILE
+  assert((stats==NULL)||(caller<stats->nCallers));
+  profile = stats;
+  profCaller = caller;
+#endif
+  return 0;
+}
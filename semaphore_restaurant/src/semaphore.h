@@ -9,7 +9,18 @@
  *     \li destruction of a previously created set of semaphores
  *     \li signalling start of operations
  *     \li <em>down</em> of a semaphore within the set
- *     \li <em>up</em> of a semaphore within the set.
+ *     \li <em>up</em> of a semaphore within the set
+ *     \li several <em>downs</em> and <em>ups</em> of semaphores within the set in a single operation
+ *     \li tracking of the blocking operations of a thread
+ *     \li counting the blocked threads that may proceed, reading the value of a semaphore and waiting for it to
+ *         be zero
+ *     \li reading and setting the values of all semaphores of the set
+ *     \li sequencing the <em>downs</em> of a thread
+ *     \li timing the <em>downs</em> of a thread
+ *     \li profiling the contention of the <em>downs</em> of a thread.
+ *
+ *  Tracking, counting and waiting for zero support the virtual clock and are only provided by the System V backend.
+ *  Profiling is only carried out when the backend is compiled with <tt>SEMPROFILE</tt> defined (<tt>make profile</tt>).
  *
  *  \author António Rui Borges - October 1995
  */
@@ -17,6 +28,75 @@
 #ifndef SEMAPHORE_H_
 #define SEMAPHORE_H_
 
+#include "histogram.h"
+
+/**
+ *  \brief Definition of an operation on a semaphore within the set.
+ */
+typedef struct {
+    /** \brief semaphore location in the set (1 .. snum) */
+    unsigned int sindex;
+    /** \brief value added to the semaphore (negative for <em>down</em>, positive for <em>up</em>) */
+    int delta;
+} SEM_OP;
+
+/** \brief maximum number of operations of a tracked blocking operation */
+#define  MAXWAITOPS     8
+
+/**
+ *  \brief Definition of a <em>wait descriptor</em>: operations a tracked thread is blocked on.
+ */
+typedef struct {
+    /** \brief number of operations (0 if the thread is not blocked) */
+    unsigned int nops;
+    /** \brief operations */
+    SEM_OP ops[MAXWAITOPS];
+} SEM_WAIT;
+
+/**
+ *  \brief Definition of a <em>sequencer</em>: functions called around the <em>downs</em> of a thread, to record
+ *  or impose their order.
+ *
+ *  The operations carried out by the functions are not sequenced themselves.
+ */
+typedef struct {
+    /** \brief called before a down with -1 (blocking down) or the maximum number of downs (non blocking down);
+     *  returns -1 or, for a non blocking down, the number of downs to be carried out, blocking if needed */
+    int (*enter) (void *arg, int max);
+    /** \brief called after the down, with -1 (blocking down) or the number of downs carried out */
+    void (*leave) (void *arg, int result);
+    /** \brief argument of the functions */
+    void *arg;
+} SEM_SEQUENCER;
+
+/**
+ *  \brief Definition of the <em>contention counters</em> of a semaphore within the set and a caller.
+ */
+typedef struct {
+    /** \brief number of downs carried out */
+    unsigned long acquires;
+    /** \brief number of downs that could not be carried out at once (the semaphore was in red state) */
+    unsigned long contended;
+    /** \brief time blocked on the contended downs (nanoseconds of the monotonic clock) */
+    unsigned long blocked;
+} SEM_COUNTERS;
+
+/**
+ *  \brief Definition of a <em>contention profile</em>: counters of each semaphore within the set and each caller,
+ *  updated concurrently by every profiled thread (in shared memory).
+ */
+typedef struct {
+    /** \brief number of semaphores (including the start of operations semaphore) */
+    unsigned int nSems;
+    /** \brief number of callers */
+    unsigned int nCallers;
+    /** \brief counters, semaphore after semaphore */
+    SEM_COUNTERS counters[];
+} SEM_STATS;
+
+/** \brief counters of semaphore <tt>sindex</tt> and caller <tt>caller</tt> of a contention profile */
+#define  SEMCOUNTERS(stats, sindex, caller)   ((stats)->counters[(sindex) * (stats)->nCallers + (caller)])
+
 /**
  *  \brief Creation of a set of semaphores.
  *
@@ -99,4 +179,197 @@ extern int semDown (int semgid, unsigned int sindex);
 
 extern int semUp (int semgid, unsigned int sindex);
 
+/**
+ *  \brief Several <em>downs</em> of a semaphore within the set, without blocking.
+ *
+ *  Up to <tt>max</tt> <em>downs</em> are carried out, while the semaphore is in <em>green state</em>.
+ *  When the <em>downs</em> of the thread are sequenced, the sequencer may impose the number of <em>downs</em>,
+ *  which are then carried out blocking if needed.
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param max maximum number of downs
+ *
+ *  \return number of downs carried out, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semTryDown (int semgid, unsigned int sindex, unsigned int max);
+
+/**
+ *  \brief Several <em>downs</em> and <em>ups</em> of semaphores within the set in a single operation.
+ *
+ *  With the System V backend the operations are carried out atomically by a single <tt>semop</tt>:
+ *  the process blocks until all <em>downs</em> can take place.
+ *  With the POSIX backend they are carried out one after the other, in the given order.
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param ops operations to be carried out
+ *  \param nops number of operations (>= 1)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semOpMulti (int semgid, SEM_OP ops[], unsigned int nops);
+
+/**
+ *  \brief Tracking of the blocking operations of the calling thread.
+ *
+ *  From now on, when a <em>down</em> of the calling thread has to block, its operations are stored in the wait
+ *  descriptor pointed by <tt>wait</tt>, the counter pointed by <tt>pCount</tt> is incremented and the semaphore
+ *  <tt>sindex</tt> is decremented before blocking; it is incremented again by the same operation that unblocks
+ *  the thread. So, the semaphore counts the tracked threads that are not blocked.
+ *  Tracking stops when <tt>wait</tt> is a null pointer.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param wait pointer to the wait descriptor of the thread (in shared memory)
+ *  \param pCount pointer to the counter of blocking operations (in shared memory)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semTrackBlocking (int semgid, unsigned int sindex, SEM_WAIT *wait, unsigned int *pCount);
+
+/**
+ *  \brief Counting the wait descriptors whose operations may take place with the current values of the semaphores.
+ *
+ *  \param semgid set identifier
+ *  \param waits wait descriptors
+ *  \param n number of wait descriptors
+ *
+ *  \return number of wait descriptors whose operations would not block, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semUnblockable (int semgid, SEM_WAIT waits[], unsigned int n);
+
+/**
+ *  \brief Reading the value of a semaphore within the set.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return value of the semaphore, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semValue (int semgid, unsigned int sindex);
+
+/**
+ *  \brief Reading the values of all semaphores of the set.
+ *
+ *  The values of the semaphores at locations 0 (start of operations) to snum are stored in <tt>values</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param values array of snum + 1 values
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semGetAll (int semgid, unsigned short values[]);
+
+/**
+ *  \brief Setting the values of all semaphores of the set.
+ *
+ *  The semaphores at locations 0 (start of operations) to snum take the values stored in <tt>values</tt>, as
+ *  read by <tt>semGetAll</tt>. No thread may be blocked on a semaphore of the set.
+ *
+ *  \param semgid set identifier
+ *  \param values array of snum + 1 values
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semSetAll (int semgid, unsigned short values[]);
+
+/**
+ *  \brief Waiting for a semaphore within the set to be zero.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semWaitZero (int semgid, unsigned int sindex);
+
+/**
+ *  \brief Sequencing the <em>downs</em> of the calling thread.
+ *
+ *  From now on, the functions of the sequencer pointed by <tt>seq</tt> are called around every <em>down</em>
+ *  (including the operations of several semaphores with at least one <em>down</em>) of the calling thread.
+ *  Sequencing stops when <tt>seq</tt> is a null pointer.
+ *
+ *  \param seq pointer to the sequencer
+ *
+ *  \return \c 0, upon success
+ */
+
+extern int semSequence (SEM_SEQUENCER *seq);
+
+/**
+ *  \brief Timing the <em>downs</em> of the calling thread.
+ *
+ *  From now on, the time (in nanoseconds of the monotonic clock) the calling thread takes to carry out a
+ *  <em>down</em> that may block is recorded in <tt>waits[sindex]</tt>, concurrently with the other threads.
+ *  The time of several operations in a single operation is recorded for the first semaphore decremented by the
+ *  System V backend, which carries them out atomically, and for every semaphore decremented by the POSIX backend,
+ *  which carries them out one after the other. Non blocking <em>downs</em> are not timed.
+ *  Timing stops when <tt>waits</tt> is a null pointer.
+ *
+ *  \param waits histograms of the downs of each semaphore within the set (indexed by semaphore location)
+ *
+ *  \return \c 0, upon success
+ */
+
+extern int semTimeWaits (HISTOGRAM waits[]);
+
+/**
+ *  \brief Size of a contention profile.
+ *
+ *  \param nSems number of semaphores (including the start of operations semaphore)
+ *  \param nCallers number of callers
+ *
+ *  \return number of bytes required by the profile
+ */
+
+extern unsigned long semStatsBytes (unsigned int nSems, unsigned int nCallers);
+
+/**
+ *  \brief Initialization of a contention profile: every counter is zeroed.
+ *
+ *  \param stats pointer to the profile
+ *  \param nSems number of semaphores (including the start of operations semaphore)
+ *  \param nCallers number of callers
+ */
+
+extern void semInitStats (SEM_STATS *stats, unsigned int nSems, unsigned int nCallers);
+
+/**
+ *  \brief Profiling the contention of the <em>downs</em> of the calling thread.
+ *
+ *  From now on, every <em>down</em> of the calling thread is counted in the counters of the semaphore and
+ *  <tt>caller</tt>; a <em>down</em> that may block is tried first without blocking and, when it would block,
+ *  counted as contended and the time blocked is added. Every semaphore decremented by several operations in a
+ *  single operation is counted: the System V backend, which carries them out atomically, counts as contended the
+ *  first semaphore in red state when the operations were tried; the POSIX backend carries them out one after the
+ *  other. Profiling stops when <tt>stats</tt> is a null pointer; it has no effect unless the backend is compiled
+ *  with <tt>SEMPROFILE</tt> defined.
+ *
+ *  \param stats pointer to the profile
+ *  \param caller caller the downs are counted for (0 .. nCallers-1)
+ *
+ *  \return \c 0, upon success
+ */
+
+extern int semProfile (SEM_STATS *stats, unsigned int caller);
+
 #endif /* SEMAPHORE_H_ */
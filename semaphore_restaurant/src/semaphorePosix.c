@@ -0,0 +1,683 @@
+/**
+ *  \file semaphorePosix.c (implementation file)
+ *
+ *  \brief Semaphore management.
+ *
+ *  Implementation of the operations defined in semaphore.h with process-shared POSIX semaphores, so that
+ *  a <em>down</em> of a semaphore in the green state or an <em>up</em> without waiting processes does not
+ *  leave user space.
+ *
+ *  The semaphores of a set live in a shared memory block whose creation key is the key of the set with the
+ *  bits of the project id given by <tt>ftok</tt> changed, so that the block does not collide with the
+ *  shared region created with the same key. The set identifier is the block identifier.
+ *
+ *  Operations defined on semaphores:
+ *     \li creation of a set of semaphores
+ *     \li connection to a previously created set of semaphores
+ *     \li destruction of a previously created set of semaphores
+ *     \li signalling start of operations
+ *     \li <em>down</em> of a semaphore within the set
+ *     \li <em>up</em> of a semaphore within the set
+ *     \li several <em>downs</em> and <em>ups</em> of semaphores within the set in a single operation
+ *     \li reading the value of a semaphore
+ *     \li reading and setting the values of all semaphores of the set
+ *     \li sequencing the <em>downs</em> of a thread
+ *     \li timing the <em>downs</em> of a thread
+ *     \li profiling the contention of the <em>downs</em> of a thread.
+ *
+ *  The operations that support the virtual clock (tracking of blocking operations, counting the blocked threads
+ *  that may proceed and waiting for a semaphore to be zero) are not supported.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <semaphore.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+#include "semaphore.h"
+#include "sharedMemory.h"
+
+/** \brief bits of the creation key changed to obtain the key of the block where the semaphores live */
+#define  SEMKEYMASK     0x01000000
+
+/** \brief maximum number of sets a process may be connected to */
+#define  MAXSETS        4
+
+/**
+ *  \brief Definition of the block where a set of semaphores lives.
+ */
+typedef struct {
+    /** \brief number of semaphores in the set (including the start of operations semaphore) */
+    unsigned int snum;
+    /** \brief semaphores of the set */
+    sem_t sem[];
+} SEM_SET;
+
+/** \brief sets the process is connected to */
+static struct {
+    /** \brief set identifier */
+    int semgid;
+    /** \brief local address of the attached block */
+    SEM_SET *set;
+} sets[MAXSETS];
+
+/** \brief number of sets the process is connected to */
+static int nSets = 0;
+
+/** \brief sequencer of the downs of the thread (NULL if they are not sequenced) */
+static __thread SEM_SEQUENCER *sequencer = NULL;
+
+/** \brief histograms of the downs of the thread, indexed by semaphore location (NULL if they are not timed) */
+static __thread HISTOGRAM *waitTimes = NULL;
+
+#ifdef SEMPROFILE
+/** \brief contention profile the downs of the thread are counted in (NULL if they are not profiled) */
+static __thread SEM_STATS *profile = NULL;
+
+/** \brief caller the downs of the thread are counted for */
+static __thread unsigned int profCaller = 0;
+#endif
+
+/* internal functions */
+
+static int addSet (int semgid, SEM_SET *set)
+{
+    if (nSets == MAXSETS) {
+        errno = ENOMEM;
+        return -1;
+    }
+    sets[nSets].semgid = semgid;
+    sets[nSets].set = set;
+    nSets += 1;
+    return 0;
+}
+
+static SEM_SET *findSet (int semgid)
+{
+    int s;
+
+    for (s = 0; s < nSets; s++) {
+        if (sets[s].semgid == semgid) {
+            return sets[s].set;
+        }
+    }
+    errno = EINVAL;
+    return NULL;
+}
+
+static int waitSem (sem_t *sem)
+{
+    int stat;
+
+    while (((stat = sem_wait (sem)) == -1) && (errno == EINTR))
+        ;
+    return stat;
+}
+
+#ifdef SEMPROFILE
+static int acquireSem (SEM_SET *set, unsigned int sindex)
+{
+    SEM_COUNTERS *cnt;                                                  /* counters of the semaphore and caller */
+    struct timespec start, end;
+    int stat;
+
+    if ((profile == NULL) || (sindex >= profile->nSems)) {
+        return waitSem (&set->sem[sindex]);
+    }
+    cnt = &SEMCOUNTERS (profile, sindex, profCaller);
+    while (((stat = sem_trywait (&set->sem[sindex])) == -1) && (errno == EINTR))
+        ;
+    if (stat == -1) {
+        if (errno != EAGAIN) {
+            return -1;
+        }
+        clock_gettime (CLOCK_MONOTONIC, &start);
+        if (waitSem (&set->sem[sindex]) == -1) {
+            return -1;
+        }
+        clock_gettime (CLOCK_MONOTONIC, &end);
+        __atomic_add_fetch (&cnt->contended, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch (&cnt->blocked, (end.tv_sec - start.tv_sec) * 1000000000UL + end.tv_nsec - start.tv_nsec,
+                            __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch (&cnt->acquires, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+#else
+#define  acquireSem(set, sindex)     waitSem (&(set)->sem[sindex])
+#endif
+
+static int downSem (SEM_SET *set, unsigned int sindex)
+{
+    struct timespec start, end;
+    int stat;
+
+    if (waitTimes == NULL) {
+        return acquireSem (set, sindex);
+    }
+    clock_gettime (CLOCK_MONOTONIC, &start);
+    if ((stat = acquireSem (set, sindex)) == 0) {
+        clock_gettime (CLOCK_MONOTONIC, &end);
+        histRecord (&waitTimes[sindex], (end.tv_sec - start.tv_sec) * 1000000000UL + end.tv_nsec - start.tv_nsec);
+    }
+    return stat;
+}
+
+/* external functions */
+
+/**
+ *  \brief Creation of a set of semaphores.
+ *
+ *  All semaphores in the set will be in set to <em>red state</em> upon creation.
+ *  The function fails if there is already a semaphore set with a creation key equal to <tt>key</tt>.
+ *
+ *  \param key creation key
+ *  \param snum number of semaphores in the set (>= 1)
+ *
+ *  \return set identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semCreate (int key, unsigned int snum)
+{
+  int semgid;                                                                            /* semaphore set identifier */
+  SEM_SET *set;                                                                   /* local address of the set block */
+  unsigned int s;
+
+  if ((semgid = shmemCreate (key ^ SEMKEYMASK, sizeof (SEM_SET) + (snum + 1) * sizeof (sem_t))) == -1)
+     return -1;
+  if (shmemAttach (semgid, (void **) &set) == -1)
+     return -1;
+  set->snum = snum + 1;
+  for (s = 0; s < set->snum; s++)
+    if (sem_init (&set->sem[s], 1, 0) == -1)
+       return -1;
+  if (addSet (semgid, set) == -1)
+     return -1;
+  return semgid;
+}
+
+/**
+ *  \brief Connection to a previously created set of semaphores.
+ *
+ *  The function fails if there is no semaphore set with a creation key equal to <tt>key</tt>.
+ *
+ *  \param key creation key
+ *
+ *  \return set identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semConnect (int key)
+{
+  int semgid;                                                                            /* semaphore set identifier */
+  SEM_SET *set;                                                                   /* local address of the set block */
+
+  if ((semgid = shmemConnect (key ^ SEMKEYMASK)) == -1)
+     return -1;
+  if ((set = findSet (semgid)) == NULL) {
+     if (shmemAttach (semgid, (void **) &set) == -1)
+        return -1;
+     if (addSet (semgid, set) == -1)
+        return -1;
+  }
+  if ((waitSem (&set->sem[0]) == -1) || (sem_post (&set->sem[0]) == -1))    /* wait for start of operations */
+     return -1;
+  return semgid;
+}
+
+/**
+ *  \brief Destruction of a previously created set of semaphores.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semDestroy (int semgid)
+{
+  SEM_SET *set;                                                                   /* local address of the set block */
+  unsigned int s;
+
+  if ((set = findSet (semgid)) == NULL)
+     return -1;
+  for (s = 0; s < set->snum; s++)
+    sem_destroy (&set->sem[s]);
+  if (shmemDettach (set) == -1)
+     return -1;
+  for (s = 0; sets[s].semgid != semgid; s++)
+    ;
+  sets[s] = sets[--nSets];
+  return shmemDestroy (semgid);
+}
+
+/**
+ *  \brief Signalling start of operations upon initialization of shared data structures.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semSignal (int semgid)
+{
+  SEM_SET *set;                                                                   /* local address of the set block */
+
+  if ((set = findSet (semgid)) == NULL)
+     return -1;
+  return sem_post (&set->sem[0]);
+}
+
+/**
+ *  \brief <em>Down</em> of a semaphore within the set.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semDown (int semgid, unsigned int sindex)
+{
+  SEM_SET *set;                                                                   /* local address of the set block */
+  SEM_SEQUENCER *seq;
+  int stat;
+
+  assert(sindex>0);
+  if ((set = findSet (semgid)) == NULL)
+     return -1;
+  if (sindex >= set->snum) {
+     errno = EFBIG;
+     return -1;
+  }
+  if ((seq = sequencer) == NULL)
+     return downSem (set, sindex);
+  sequencer = NULL;
+  seq->enter (seq->arg, -1);
+  if ((stat = downSem (set, sindex)) == 0)
+     seq->leave (seq->arg, -1);
+  sequencer = seq;
+  return stat;
+}
+
+/**
+ *  \brief <em>Up</em> of a semaphore within the set.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semUp (int semgid, unsigned int sindex)
+{
+  SEM_SET *set;                                                                   /* local address of the set block */
+
+  assert(sindex>0);
+  if ((set = findSet (semgid)) == NULL)
+     return -1;
+  if (sindex >= set->snum) {
+     errno = EFBIG;
+     return -1;
+  }
+  return sem_post (&set->sem[sindex]);
+}
+
+/**
+ *  \brief Several <em>downs</em> of a semaphore within the set, without blocking.
+ *
+ *  Up to <tt>max</tt> <em>downs</em> are carried out, while the semaphore is in <em>green state</em>.
+ *  When the <em>downs</em> of the thread are sequenced, the sequencer may impose the number of <em>downs</em>,
+ *  which are then carried out blocking if needed.
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param max maximum number of downs
+ *
+ *  \return number of downs carried out, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semTryDown (int semgid, unsigned int sindex, unsigned int max)
+{
+  SEM_SET *set;                                                                   /* local address of the set block */
+  SEM_SEQUENCER *seq;
+  int forced = -1;                                                     /* number of downs imposed by the sequencer */
+  int stat = 0;
+  unsigned int n;
+
+  assert(sindex>0);
+  if ((set = findSet (semgid)) == NULL)
+     return -1;
+  if (sindex >= set->snum) {
+     errno = EFBIG;
+     return -1;
+  }
+  if ((seq = sequencer) != NULL) {
+     sequencer = NULL;
+     forced = seq->enter (seq->arg, (int) max);
+  }
+  n = 0;
+  if (forced >= 0) {                                              /* imposed number of downs, blocking if needed */
+     while ((n < (unsigned int) forced) && ((stat = downSem (set, sindex)) == 0))
+       n++;
+  }
+  else while (n < max)
+         if (sem_trywait (&set->sem[sindex]) == 0)
+            n++;
+         else if (errno == EAGAIN)
+            break;
+         else if (errno != EINTR) {
+            stat = -1;
+            break;
+         }
+#ifdef SEMPROFILE
+  if ((forced < 0) && (profile != NULL) && (sindex < profile->nSems))     /* non blocking downs are not contended */
+     __atomic_add_fetch (&SEMCOUNTERS (profile, sindex, profCaller).acquires, n, __ATOMIC_RELAXED);
+#endif
+  if (seq != NULL) {
+     if (stat == 0)
+        seq->leave (seq->arg, (int) n);
+     sequencer = seq;
+  }
+  return (stat == 0) ? (int) n : -1;
+}
+
+/**
+ *  \brief Several <em>downs</em> and <em>ups</em> of semaphores within the set in a single operation.
+ *
+ *  The operations are carried out one after the other, in the given order.
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param ops operations to be carried out
+ *  \param nops number of operations (>= 1)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semOpMulti (int semgid, SEM_OP ops[], unsigned int nops)
+{
+  SEM_SET *set;                                                                   /* local address of the set block */
+  SEM_SEQUENCER *seq = NULL;
+  unsigned int n;
+  int d, stat;
+
+  assert(nops>0);
+  if ((set = findSet (semgid)) == NULL)
+     return -1;
+  for (n = 0; n < nops; n++)
+  { assert(ops[n].sindex>0);
+    if (ops[n].sindex >= set->snum) {
+       errno = EFBIG;
+       return -1;
+    }
+    if (ops[n].delta < 0)
+       seq = sequencer;
+  }
+  if (seq != NULL) {
+     sequencer = NULL;
+     seq->enter (seq->arg, -1);
+  }
+  stat = 0;
+  for (n = 0; (n < nops) && (stat == 0); n++)
+  { for (d = ops[n].delta; (d < 0) && (stat == 0); d++)
+      stat = downSem (set, ops[n].sindex);
+    for (d = ops[n].delta; (d > 0) && (stat == 0); d--)
+      stat = sem_post (&set->sem[ops[n].sindex]);
+  }
+  if (seq != NULL) {
+     if (stat == 0)
+        seq->leave (seq->arg, -1);
+     sequencer = seq;
+  }
+  return stat;
+}
+
+/**
+ *  \brief Tracking of the blocking operations of the calling thread.
+ *
+ *  Not supported: a POSIX semaphore can not be decremented atomically with the operation that unblocks the
+ *  thread.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param wait pointer to the wait descriptor of the thread (in shared memory)
+ *  \param pCount pointer to the counter of blocking operations (in shared memory)
+ *
+ *  \return -\c 1 (<tt>errno</tt> is set to <tt>ENOSYS</tt>)
+ */
+
+int semTrackBlocking (int semgid, unsigned int sindex, SEM_WAIT *wait, unsigned int *pCount)
+{
+  errno = ENOSYS;
+  return -1;
+}
+
+/**
+ *  \brief Counting the wait descriptors whose operations may take place with the current values of the semaphores.
+ *
+ *  Not supported: the values of the semaphores of the set can not be read atomically.
+ *
+ *  \param semgid set identifier
+ *  \param waits wait descriptors
+ *  \param n number of wait descriptors
+ *
+ *  \return -\c 1 (<tt>errno</tt> is set to <tt>ENOSYS</tt>)
+ */
+
+int semUnblockable (int semgid, SEM_WAIT waits[], unsigned int n)
+{
+  errno = ENOSYS;
+  return -1;
+}
+
+/**
+ *  \brief Reading the value of a semaphore within the set.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return value of the semaphore, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semValue (int semgid, unsigned int sindex)
+{
+  SEM_SET *set;                                                                   /* local address of the set block */
+  int val;
+
+  assert(sindex>0);
+  if ((set = findSet (semgid)) == NULL)
+     return -1;
+  if (sindex >= set->snum) {
+     errno = EFBIG;
+     return -1;
+  }
+  if (sem_getvalue (&set->sem[sindex], &val) == -1)
+     return -1;
+  return val;
+}
+
+/**
+ *  \brief Reading the values of all semaphores of the set.
+ *
+ *  The values of the semaphores at locations 0 (start of operations) to snum are stored in <tt>values</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param values array of snum + 1 values
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semGetAll (int semgid, unsigned short values[])
+{
+  SEM_SET *set;                                                                   /* local address of the set block */
+  unsigned int s;
+  int val;
+
+  if ((set = findSet (semgid)) == NULL)
+     return -1;
+  for (s = 0; s < set->snum; s++) {
+    if (sem_getvalue (&set->sem[s], &val) == -1)
+       return -1;
+    values[s] = (unsigned short) val;
+  }
+  return 0;
+}
+
+/**
+ *  \brief Setting the values of all semaphores of the set.
+ *
+ *  The semaphores at locations 0 (start of operations) to snum take the values stored in <tt>values</tt>, as
+ *  read by <tt>semGetAll</tt>; they are initialized again, so no thread may be blocked on a semaphore of the set.
+ *
+ *  \param semgid set identifier
+ *  \param values array of snum + 1 values
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semSetAll (int semgid, unsigned short values[])
+{
+  SEM_SET *set;                                                                   /* local address of the set block */
+  unsigned int s;
+
+  if ((set = findSet (semgid)) == NULL)
+     return -1;
+  for (s = 0; s < set->snum; s++) {
+    sem_destroy (&set->sem[s]);
+    if (sem_init (&set->sem[s], 1, values[s]) == -1)
+       return -1;
+  }
+  return 0;
+}
+
+/**
+ *  \brief Waiting for a semaphore within the set to be zero.
+ *
+ *  Not supported: POSIX semaphores have no wait for zero operation.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return -\c 1 (<tt>errno</tt> is set to <tt>ENOSYS</tt>)
+ */
+
+int semWaitZero (int semgid, unsigned int sindex)
+{
+  errno = ENOSYS;
+  return -1;
+}
+
+/**
+ *  \brief Sequencing the <em>downs</em> of the calling thread.
+ *
+ *  From now on, the functions of the sequencer pointed by <tt>seq</tt> are called around every <em>down</em>
+ *  (including the operations of several semaphores with at least one <em>down</em>) of the calling thread.
+ *  Sequencing stops when <tt>seq</tt> is a null pointer.
+ *
+ *  \param seq pointer to the sequencer
+ *
+ *  \return \c 0, upon success
+ */
+
+int semSequence (SEM_SEQUENCER *seq)
+{
+  sequencer = seq;
+  return 0;
+}
+
+/**
+ *  \brief Timing the <em>downs</em> of the calling thread.
+ *
+ *  From now on, the time (in nanoseconds of the monotonic clock) the calling thread takes to carry out a
+ *  <em>down</em> that may block is recorded in <tt>waits[sindex]</tt>. Several operations in a single operation
+ *  are carried out one after the other and each <em>down</em> is recorded for its own semaphore.
+ *  Timing stops when <tt>waits</tt> is a null pointer.
+ *
+ *  \param waits histograms of the downs of each semaphore within the set (indexed by semaphore location)
+ *
+ *  \return \c 0, upon success
+ */
+
+int semTimeWaits (HISTOGRAM waits[])
+{
+  waitTimes = waits;
+  return 0;
+}
+
+/**
+ *  \brief Size of a contention profile.
+ *
+ *  \param nSems number of semaphores (including the start of operations semaphore)
+ *  \param nCallers number of callers
+ *
+ *  \return number of bytes required by the profile
+ */
+
+unsigned long semStatsBytes (unsigned int nSems, unsigned int nCallers)
+{
+  return sizeof (SEM_STATS) + (unsigned long) nSems * nCallers * sizeof (SEM_COUNTERS);
+}
+
+/**
+ *  \brief Initialization of a contention profile: every counter is zeroed.
+ *
+ *  \param stats pointer to the profile
+ *  \param nSems number of semaphores (including the start of operations semaphore)
+ *  \param nCallers number of callers
+ */
+
+void semInitStats (SEM_STATS *stats, unsigned int nSems, unsigned int nCallers)
+{
+  memset (stats, 0, semStatsBytes (nSems, nCallers));
+  stats->nSems = nSems;
+  stats->nCallers = nCallers;
+}
+
+/**
+ *  \brief Profiling the contention of the <em>downs</em> of the calling thread.
+ *
+ *  From now on, every <em>down</em> of the calling thread is counted in the counters of the semaphore and
+ *  <tt>caller</tt>; a <em>down</em> that may block is tried first without blocking and, when it would block,
+ *  counted as contended and the time blocked is added. Several operations in a single operation are carried out
+ *  one after the other and each <em>down</em> is counted for its own semaphore. Profiling stops when
+ *  <tt>stats</tt> is a null pointer; it has no effect unless compiled with <tt>SEMPROFILE</tt> defined.
+ *
+ *  \param stats pointer to the profile
+ *  \param caller caller the downs are counted for (0 .. nCallers-1)
+ *
+ *  \return \c 0, upon success
+ */
+
+int semProfile (SEM_STATS *stats, unsigned int caller)
+{
+#ifdef SEMPROFILE
+  assert((stats==NULL)||(caller<stats->nCallers));
+  profile = stats;
+  profCaller = caller;
+#endif
+  return 0;
+}
@@ -0,0 +1,76 @@
+/**
+ *  \file semstat.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  Reader of the contention profile of a running simulation.
+ *
+ *  The shared region of the simulation is attached and the acquires, contended acquires and time blocked of each
+ *  semaphore and kind of entity are printed, as they stand. The simulation must have been compiled with
+ *  <tt>SEMPROFILE</tt> defined (<tt>make profile</tt>).
+ *
+ *  Options:
+ *    \li <tt>-k key</tt> access key of the shared region, instead of the key generated from the current directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "sharedDataSync.h"
+#include "sharedMemory.h"
+#include "semaphore.h"
+#include "contention.h"
+
+/**
+ *  \brief Main program.
+ *
+ *  Its role is to attach the shared region of a simulation and to print its contention profile.
+ */
+int main (int argc, char *argv[])
+{
+    SHARED_DATA *sh;                                                           /* pointer to the shared region */
+    SEM_RANGE ranges[SEMRANGES];                                                     /* names of the semaphores */
+    int key = IPC_PRIVATE;                                                       /* access key to shared memory */
+    int shmid;                                                                       /* shared memory identifier */
+    int opt;
+
+    while ((opt = getopt (argc, argv, "k:")) != -1) {
+        switch (opt) {
+            case 'k':
+                key = (int) strtol (optarg, NULL, 0);
+                break;
+            default:
+                fprintf (stderr, "Usage: %s [-k key]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if ((key == IPC_PRIVATE) && ((key = ftok (".", 'a')) == -1)) {
+        perror ("error on generating the key");
+        return EXIT_FAILURE;
+    }
+
+    if ((shmid = shmemConnect (key)) == -1) {
+        perror ("error on connecting to the shared memory region");
+        return EXIT_FAILURE;
+    }
+    if (shmemAttach (shmid, (void **) &sh) == -1) {
+        perror ("error on mapping the shared region on the process address space");
+        return EXIT_FAILURE;
+    }
+    if (sh->statsOff == 0) {
+        fprintf (stderr, "The semaphores of the simulation are not profiled (make profile)!\n");
+        return EXIT_FAILURE;
+    }
+    printContention (stdout, SEMSTATS, ranges, semRanges (sh, ranges));
+    if (shmemDettach (sh) == -1) {
+        perror ("error on unmapping the shared region off the process address space");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -11,6 +11,55 @@
  *  Both the format of the shared data, which represents the full state of the problem, and the identification of
  *  the different semaphores, which carry out the synchronization among the intervening entities, are provided.
  *
+ *  The full state is protected by three kinds of locks, each critical region taking exactly one of them:
+ *     \li the reception lock: receptionist state and request, tables assigned to groups, groups waiting
+ *     \li the kitchen lock: waiter and chef states, waiter request, food order
+ *     \li the lock of each table: state of the group seated at the table.
+ *
+ *  By default all locks are the semaphore <tt>mutex</tt>; when locks are split, each one is a different semaphore.
+ *
+ *  When locks are split, the state saves are serialized by the log lock, so that the lines are logged in the order
+ *  the states were saved, but a saved state is not a consistent snapshot: the entity only holds the lock of its
+ *  own region, while the fields of the other regions (the states of the other entities, the tables assigned, the
+ *  food order) may be changing. A line may show a change of another region before the entity that made it saves
+ *  its state, whose line then repeats the state (or is coalesced, with <tt>-d</tt>), and the log of a run that
+ *  imposes a recorded order may differ from the log of the recorded run.
+ *
+ *  The number of tables is only known at run time: the identification of the semaphores of each table is stored
+ *  in an array that follows the shared data in the shared region. The fixed size table arrays keep the layout
+ *  expected by the reference binaries and are filled for the first <tt>NUMTABLES</tt> tables.
+ *
+ *  The group arrays (of the full state and of the semaphores used by groups to wait for a table) are located by
+ *  offsets: up to <tt>MAXGROUPS</tt> groups they are the fixed size arrays, as expected by the reference binaries;
+ *  larger populations use arrays that follow the table synchronization array.
+ *
+ *  Unless the configuration is the one supported by the reference binaries (one waiter and one chef, up to
+ *  <tt>NUMTABLES</tt> tables, single slot mailboxes), food orders are placed in a bounded queue, with one slot per
+ *  table, instead of the single slot of the full state (<tt>foodOrder</tt> and <tt>foodGroup</tt>); the chefs wait
+ *  for orders on <tt>waitOrder</tt> and the waiters wait for a vacant slot on <tt>orderSlots</tt>, so that a waiter
+ *  never waits for a chef that may be waiting to hand food to it. Waiters and chefs terminate
+ *  when the shared counters of the requests and the orders still to be served reach zero.
+ *
+ *  Requests to the receptionist and to the waiter are posted in mailboxes: producers wait on
+ *  <tt>receptionistRequestPossible</tt> and <tt>waiterRequestPossible</tt>, whose initial value is the number of
+ *  slots, and consumers wait on <tt>receptionistReq</tt> and <tt>waiterRequest</tt>. The default mailboxes have a single slot, the request slot
+ *  of the full state, as expected by the reference binaries.
+ *
+ *  When the receptionist and the waiter are a single event-driven entity, the producers of their requests also
+ *  notify the source of each request (see notify.h), after leaving the critical region.
+ *
+ *  With the virtual clock, the semaphore <tt>running</tt> counts the entities that are not blocked and each entity
+ *  waits for its scheduled wake-ups on its own semaphore.
+ *
+ *  When the recorded order of the downs is imposed, each entity waits for its turn on its own semaphore.
+ *
+ *  The layout of the fields of the reference binaries is kept. The fields that follow them are grouped by the
+ *  entities that write them: the configuration, which is only read once the simulation starts, the reception state,
+ *  the kitchen state, the log, the clock, the replay and the latency statistics each start a cache line, so that an
+ *  entity updating one of them does not take away the lines read or written by the others. Within the log, the ring
+ *  head, the ring tail and the snapshot each start a cache line as well, apart from the log configuration, which
+ *  holds the identification of the log lock (a semaphore of the set, not a field that is written).
+ *
  *  \author Nuno Lau - December 2023
  */
 
@@ -20,6 +69,36 @@
 #include "probConst.h"
 #include "probDataStruct.h"
 
+/**
+ *  \brief Definition of <em>table synchronization</em> data type.
+ */
+typedef struct
+        { /** \brief identification of semaphore used by the group to wait for waiter ackowledge – val = 0  */
+          unsigned int requestReceived;
+          /** \brief identification of semaphore used by the group to wait for food – val = 0 */
+          unsigned int foodArrived;
+          /** \brief identification of semaphore used by the group to wait for payment completed – val = 0 */
+          unsigned int tableDone;
+          /** \brief identification of semaphore protecting the state of the group seated at the table – val = 1 */
+          unsigned int tableLock;
+        } TABLE_SYNC;
+
+/**
+ *  \brief Definition of <em>order queue</em> data type.
+ */
+typedef struct
+        { /** \brief groups whose food orders were not received by a chef yet, in order of arrival */
+          int group[MAXTABLES];
+          /** \brief time each order was placed (us), when its cooking starts in the pipelined kitchen */
+          unsigned long placed[MAXTABLES];
+          /** \brief position of the oldest order */
+          unsigned int head;
+          /** \brief number of queued orders */
+          unsigned int count;
+          /** \brief number of slots (number of tables) */
+          unsigned int size;
+        } ORDER_QUEUE;
+
 /**
  *  \brief Definition of <em>shared information</em> data type.
  */
@@ -32,11 +111,11 @@ typedef struct
           unsigned int mutex;
           /** \brief identification of semaphore used by receptionist to wait for groups - val = 0 */
           unsigned int receptionistReq;
-          /** \brief identification of semaphore used by groups to wait before issuing receptionist request - val = 1 */
+          /** \brief identification of semaphore used by groups to wait before issuing receptionist request - val = mailbox slots */
           unsigned int receptionistRequestPossible;
           /** \brief identification of semaphore used by waiter to wait for requests – val = 0  */
           unsigned int waiterRequest;
-          /** \brief identification of semaphore used by groups and chef to wait before issuing waiter request - val = 1 */
+          /** \brief identification of semaphore used by groups and chef to wait before issuing waiter request - val = mailbox slots */
           unsigned int waiterRequestPossible;
           /** \brief identification of semaphore used by chef to wait for order – val = 0  */
           unsigned int waitOrder;
@@ -50,11 +129,81 @@ typedef struct
           unsigned int foodArrived[NUMTABLES];
           /** \brief identification of semaphore used by groups to wait for payment completed – val = 0 */
           unsigned int tableDone[NUMTABLES];
+          /* the fields above are those of the reference binaries, the fields below only follow them */
+
+          /** \brief identification of semaphore protecting the reception state – val = 1 */
+          unsigned int receptionLock;
+          /** \brief identification of semaphore protecting the kitchen state – val = 1 */
+          unsigned int kitchenLock;
+          /** \brief identification of semaphore used by chef to wait before handing ready food - val = 1 */
+          unsigned int foodReadyPossible;
+          /** \brief identification of semaphore used by waiters to wait for a vacant slot of the order queue - val = number of tables */
+          unsigned int orderSlots;
+
+          /** \brief number of tables */
+          int nTables;
+          /** \brief location of the table synchronization array (offset relative to the shared data) */
+          unsigned long tablesOff;
+          /** \brief location of the group arrays of the full state */
+          GROUP_ARRAYS groups;
+          /** \brief location of the array of semaphores used by groups to wait for table (offset relative to the shared data) */
+          unsigned long waitForTableOff;
+
+          /** \brief number of waiters */
+          int nWaiters;
+          /** \brief number of chefs */
+          int nChefs;
+          /** \brief food orders are placed in the order queue (unless the reference binaries configuration is used) */
+          bool queueOrders;
+          /** \brief the chefs cook the orders they received at the same time and hand the food in batches (pipelined
+           *  kitchen, the orders are queued) */
+          bool pipelinedKitchen;
+          /** \brief seed of the random streams of the start, eat and cooking times */
+          unsigned long seed;
+          /** \brief location of the contention profile of the semaphores, whose callers are the kinds of entities
+           *  (offset relative to the shared data, 0 when the semaphores are not profiled) */
+          unsigned long statsOff;
+          /** \brief placement of the shared region (every entity faults its pages in with SHMPREFAULT) */
+          unsigned int placement;
+          /** \brief notification of the requests to the event-driven staff (no sources unless the receptionist and
+           *  the waiter are a single entity) */
+          NOTIFIER notify;
+          /** \brief scheduling policy of the waiting groups (SCHEDFIFO, SCHEDSEF or SCHEDEDF) */
+          unsigned int schedPolicy;
+
+          /* reception state */
+          /** \brief requests to the receptionist (the semaphores of the receptionist count used and vacant slots) */
+          MAILBOX receptionistBox CACHEALIGNED;
+
+          /* kitchen state */
+          /** \brief requests of the groups and chef to the waiter (the semaphores of the waiter count used and vacant slots) */
+          MAILBOX waiterBox CACHEALIGNED;
+          /** \brief used by chef to hand ready food to waiter (kept apart from the request slot of the groups) */
+          request foodReady;
+          /** \brief food orders waiting for a chef */
+          ORDER_QUEUE orders;
+          /** \brief number of requests still to be served by the waiters */
+          int requestsToServe;
+          /** \brief number of orders still to be received by the chefs */
+          int ordersToCook;
+
+          /** \brief log configuration (the log ring slots follow the table synchronization and group arrays, the
+           *  published state is the last item of the shared region) */
+          LOG_CONF log CACHEALIGNED;
+
+          /** \brief virtual clock (the timer queue follows the log ring slots) */
+          VCLOCK clock CACHEALIGNED;
+
+          /** \brief record and replay of the order of the downs (the entries follow the timer queue) */
+          REPLAY replay CACHEALIGNED;
+
+          /** \brief latency statistics (the stamps and semaphore histograms follow the replay entries) */
+          LATENCY lat CACHEALIGNED;
 
         } SHARED_DATA;
 
 /** \brief number of semaphores in the set */
-#define SEM_NU               ( 7 + sh->fSt.nGroups + 3*NUMTABLES )
+#define SEM_NU               ( 13 + sh->fSt.nGroups + 4*sh->nTables + sh->clock.members + sh->replay.members )
 
 #define MUTEX                  1
 #define RECEPTIONISTREQ        2
@@ -65,7 +214,33 @@ typedef struct
 #define ORDERRECEIVED          7
 #define WAITFORTABLE           8
 #define FOODARRIVED            (WAITFORTABLE+sh->fSt.nGroups)
-#define REQUESTRECEIVED        (FOODARRIVED+NUMTABLES)
-#define TABLEDONE              (REQUESTRECEIVED+NUMTABLES)
+#define REQUESTRECEIVED        (FOODARRIVED+sh->nTables)
+#define TABLEDONE              (REQUESTRECEIVED+sh->nTables)
+#define RECEPTIONLOCK          (TABLEDONE+sh->nTables)
+#define KITCHENLOCK            (RECEPTIONLOCK+1)
+#define TABLELOCK              (KITCHENLOCK+1)
+#define FOODREADYPOSSIBLE      (TABLELOCK+sh->nTables)
+#define ORDERSLOTS             (FOODREADYPOSSIBLE+1)
+#define LOGLOCK                (ORDERSLOTS+1)
+#define RUNNING                (LOGLOCK+1)
+#define WAKEUP                 (RUNNING+1)
+#define TURN                   (WAKEUP+sh->clock.members)
+
+/** \brief contention profile of the semaphores (NULL when they are not profiled) */
+#define SEMSTATS               (sh->statsOff ? (SEM_STATS *) ((char *) sh + sh->statsOff) : NULL)
+
+/** \brief synchronization of table t */
+#define TABLESYNC(t)           (((TABLE_SYNC *) ((char *) sh + sh->tablesOff))[t])
+
+/** \brief state of group g */
+#define GROUPSTAT(g)           (GROUPARRAY(&sh->fSt, sh->groups.groupStat, unsigned int)[g])
+/** \brief estimated start time of group g */
+#define STARTTIME(g)           (GROUPARRAY(&sh->fSt, sh->groups.startTime, int)[g])
+/** \brief estimated eat time of group g */
+#define EATTIME(g)             (GROUPARRAY(&sh->fSt, sh->groups.eatTime, int)[g])
+/** \brief table assigned to group g */
+#define ASSIGNEDTABLE(g)       (GROUPARRAY(&sh->fSt, sh->groups.assignedTable, int)[g])
+/** \brief identification of semaphore used by group g to wait for table */
+#define GROUPWAIT(g)           (((unsigned int *) ((char *) sh + sh->waitForTableOff))[g])
 
 #endif /* SHAREDDATASYNC_H_ */
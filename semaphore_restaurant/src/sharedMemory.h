@@ -4,11 +4,12 @@
  *  \brief Shared memory management.
  *
  *   Operations defined on shared memory:
- *      \li creation of a new block
+ *      \li creation of a new block (with huge pages, optionally)
  *      \li connection to a previously created block
  *      \li destruction of a previously created block
  *      \li mapping of the block previously created on the process address space
- *      \li unmapping of the block off the process address space.
+ *      \li unmapping of the block off the process address space
+ *      \li placement of a mapped block (NUMA policy and faulting its pages in).
  *
  *  \author António Rui Borges - October 1995
  */
@@ -16,6 +17,8 @@
 #ifndef SHAREDMEMORY_H_
 #define SHAREDMEMORY_H_
 
+#include "placement.h"
+
 /**
  *  \brief Creation of a new block.
  *
@@ -30,6 +33,24 @@
 
 extern int shmemCreate (int key, unsigned int size);
 
+/**
+ *  \brief Creation of a new block with a given placement.
+ *
+ *  The function fails if there is already a block of shared memory with a creation key equal to <tt>key</tt>.
+ *  With SHMHUGEPAGES, the block is made of huge pages (its size is rounded up to a whole number of them) and the
+ *  function fails if there are not enough huge pages reserved; the other placements are carried out by
+ *  <tt>shmemPlace</tt>, once the block is mapped.
+ *
+ *  \param key creation key
+ *  \param size block size (in bytes)
+ *  \param placement placement of the block (SHMHUGEPAGES or 0)
+ *
+ *  \return block identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int shmemCreatePlaced (int key, unsigned int size, unsigned int placement);
+
 /**
  *  \brief Connection to a previously created block.
  *
@@ -84,4 +105,21 @@ extern int shmemAttach (int shmid, void **pAttAdd);
 
 extern int shmemDettach (void *attAdd);
 
+/**
+ *  \brief Placement of a block mapped on the process address space.
+ *
+ *  The NUMA memory policy of the block is set (SHMINTERLEAVE or SHMBIND), before its pages are touched, and its
+ *  pages are faulted in (SHMPREFAULT), so that no page fault of the block takes place afterwards in this process.
+ *
+ *  \param shmid block identifier
+ *  \param attAdd local address of the attached block
+ *  \param placement combination of SHMPREFAULT, SHMINTERLEAVE and SHMBIND
+ *  \param node NUMA node the pages are bound to (SHMBIND)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int shmemPlace (int shmid, void *attAdd, unsigned int placement, int node);
+
 #endif /* SHAREDMEMORY_H_ */
@@ -0,0 +1,231 @@
+/**
+ *  \file sharedMemoryAnon.c (implementation file)
+ *
+ *  \brief Shared memory management.
+ *
+ *  Implementation of the operations defined in sharedMemory.h with anonymous shared mappings, inherited by the
+ *  processes forked afterwards (used by the forked engine, where every entity is a child process of the generator
+ *  that does not exec a program). A block must be created before the processes that connect to it are forked: the
+ *  keys are only known by the creator and its descendants. No System V resources are created and no file is
+ *  left behind: the mappings are released when the last process that holds them terminates, even if it crashes.
+ *
+ *   Operations defined on shared memory:
+ *      \li creation of a new block (with huge pages, optionally)
+ *      \li connection to a previously created block
+ *      \li destruction of a previously created block
+ *      \li mapping of the block previously created on the process address space
+ *      \li unmapping of the block off the process address space
+ *      \li placement of a mapped block (NUMA policy and faulting its pages in).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+#include "sharedMemory.h"
+
+/** \brief maximum number of blocks */
+#define  MAXBLOCKS      8
+
+/** \brief blocks of the process and of its parent, when it was forked (the block identifier is the position in
+ *  the array) */
+static struct {
+    /** \brief creation key */
+    int key;
+    /** \brief address of the block (NULL if the position is vacant) */
+    void *add;
+    /** \brief size of the block (in bytes) */
+    unsigned long size;
+} blocks[MAXBLOCKS];
+
+/* internal functions */
+
+static int findBlock (int key)
+{
+    int b;
+
+    for (b = 0; b < MAXBLOCKS; b++) {
+        if ((blocks[b].add != NULL) && (blocks[b].key == key)) {
+            return b;
+        }
+    }
+    return -1;
+}
+
+static bool validBlock (int shmid)
+{
+    return (shmid >= 0) && (shmid < MAXBLOCKS) && (blocks[shmid].add != NULL);
+}
+
+/* external functions */
+
+/**
+ *  \brief Creation of a new block.
+ *
+ *  The function fails if there is already a block of shared memory with a creation key equal to <tt>key</tt>.
+ *
+ *  \param key creation key
+ *  \param size block size (in bytes)
+ *
+ *  \return block identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemCreate (int key, unsigned int size)
+{
+  return shmemCreatePlaced (key, size, 0);
+}
+
+/**
+ *  \brief Creation of a new block with a given placement.
+ *
+ *  The function fails if there is already a block of shared memory with a creation key equal to <tt>key</tt>.
+ *  With SHMHUGEPAGES, the block is made of huge pages (its size is rounded up to a whole number of them) and the
+ *  function fails if there are not enough huge pages reserved; the other placements are carried out by
+ *  <tt>shmemPlace</tt>, once the block is mapped.
+ *
+ *  \param key creation key
+ *  \param size block size (in bytes)
+ *  \param placement placement of the block (SHMHUGEPAGES or 0)
+ *
+ *  \return block identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemCreatePlaced (int key, unsigned int size, unsigned int placement)
+{
+  int b;
+  void *add;                                                                        /* address of the new block */
+  unsigned long bytes = size;                                                                /* size of the block */
+  int flags = MAP_SHARED | MAP_ANONYMOUS;                                                    /* kind of mapping */
+
+  if (findBlock (key) != -1) {
+     errno = EEXIST;
+     return -1;
+  }
+  for (b = 0; (b < MAXBLOCKS) && (blocks[b].add != NULL); b++)
+    ;
+  if (b == MAXBLOCKS) {
+     errno = ENOMEM;
+     return -1;
+  }
+  if (placement & SHMHUGEPAGES) {
+     bytes = (bytes + HUGEPAGESIZE - 1) & ~(HUGEPAGESIZE - 1);
+     flags |= MAP_HUGETLB;
+  }
+  if ((add = mmap (NULL, bytes, PROT_READ | PROT_WRITE, flags, -1, 0)) == MAP_FAILED)
+     return -1;
+  blocks[b].key = key;
+  blocks[b].add = add;
+  blocks[b].size = bytes;
+  return b;
+}
+
+/**
+ *  \brief Connection to a previously created block.
+ *
+ *  The function fails if there is no block with a creation key equal to <tt>key</tt> created by the process or by
+ *  one of its ancestors before it was forked.
+ *
+ *  \param key creation key
+ *
+ *  \return block identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemConnect (int key)
+{
+  int b;
+
+  if ((b = findBlock (key)) == -1)
+     errno = ENOENT;
+  return b;
+}
+
+/**
+ *  \brief Destruction of a previously created block.
+ *
+ *  The block is unmapped off the process address space; it is released when the processes that inherited it
+ *  terminate.
+ *
+ *  \param shmid block identifier
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemDestroy (int shmid)
+{
+  if (!validBlock (shmid)) {
+     errno = EINVAL;
+     return -1;
+  }
+  if (munmap (blocks[shmid].add, blocks[shmid].size) == -1)
+     return -1;
+  blocks[shmid].add = NULL;
+  return 0;
+}
+
+/**
+ *  \brief Mapping of the block previously created on the process address space.
+ *
+ *  The block is already mapped: its address is the same in every process.
+ *
+ *  \param shmid block identifier
+ *  \param pAttAdd pointer to the location where the local address of the attached block is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemAttach (int shmid, void **pAttAdd)
+{
+  if (!validBlock (shmid)) {
+     errno = EINVAL;
+     return -1;
+  }
+  *pAttAdd = blocks[shmid].add;
+  return 0;
+}
+
+/**
+ *  \brief Unmapping of the block off the process address space.
+ *
+ *  The block remains mapped until it is destroyed or the process terminates.
+ *
+ *  \param attAdd local address of the attached block
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemDettach (void *attAdd)
+{
+  return 0;
+}
+
+/**
+ *  \brief Placement of a block mapped on the process address space.
+ *
+ *  The NUMA memory policy of the block is set (SHMINTERLEAVE or SHMBIND), before its pages are touched, and its
+ *  pages are faulted in (SHMPREFAULT), so that no page fault of the block takes place afterwards in this process.
+ *
+ *  \param shmid block identifier
+ *  \param attAdd local address of the attached block
+ *  \param placement combination of SHMPREFAULT, SHMINTERLEAVE and SHMBIND
+ *  \param node NUMA node the pages are bound to (SHMBIND)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemPlace (int shmid, void *attAdd, unsigned int placement, int node)
+{
+  if (!validBlock (shmid) || (blocks[shmid].add != attAdd)) {
+     errno = EINVAL;
+     return -1;
+  }
+  return placeRange (attAdd, blocks[shmid].size, placement, node);
+}
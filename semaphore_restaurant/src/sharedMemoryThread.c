@@ -0,0 +1,245 @@
+/**
+ *  \file sharedMemoryThread.c (implementation file)
+ *
+ *  \brief Shared memory management.
+ *
+ *  Implementation of the operations defined in sharedMemory.h with blocks of the process heap, shared by the
+ *  threads of the process (used by the threaded engine, where every entity is a thread of the same process).
+ *  No System V resources are created.
+ *
+ *   Operations defined on shared memory:
+ *      \li creation of a new block
+ *      \li connection to a previously created block
+ *      \li destruction of a previously created block
+ *      \li mapping of the block previously created on the process address space
+ *      \li unmapping of the block off the process address space
+ *      \li placement of a mapped block (NUMA policy and faulting its pages in).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "sharedMemory.h"
+
+/** \brief maximum number of blocks */
+#define  MAXBLOCKS      8
+
+/** \brief alignment of the blocks (a page, as the blocks of the shared memory segments) */
+#define  BLOCKALIGN     4096
+
+/** \brief blocks of the process (the block identifier is the position in the array) */
+static struct {
+    /** \brief creation key */
+    int key;
+    /** \brief address of the block (NULL if the position is vacant) */
+    void *add;
+    /** \brief size of the block (in bytes) */
+    unsigned long size;
+} blocks[MAXBLOCKS];
+
+/** \brief protection of the blocks array */
+static pthread_mutex_t blocksLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* internal functions */
+
+static int findBlock (int key)
+{
+    int b;
+
+    for (b = 0; b < MAXBLOCKS; b++) {
+        if ((blocks[b].add != NULL) && (blocks[b].key == key)) {
+            return b;
+        }
+    }
+    return -1;
+}
+
+/* external functions */
+
+/**
+ *  \brief Creation of a new block.
+ *
+ *  The function fails if there is already a block of shared memory with a creation key equal to <tt>key</tt>.
+ *  The block is initialized to zero.
+ *
+ *  \param key creation key
+ *  \param size block size (in bytes)
+ *
+ *  \return block identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemCreate (int key, unsigned int size)
+{
+  return shmemCreatePlaced (key, size, 0);
+}
+
+/**
+ *  \brief Creation of a new block with a given placement.
+ *
+ *  The function fails if there is already a block of shared memory with a creation key equal to <tt>key</tt>.
+ *  With SHMHUGEPAGES, the block is aligned to a huge page and transparent huge pages are requested for it (its
+ *  size is rounded up to a whole number of them); the other placements are carried out by <tt>shmemPlace</tt>.
+ *
+ *  \param key creation key
+ *  \param size block size (in bytes)
+ *  \param placement placement of the block (SHMHUGEPAGES or 0)
+ *
+ *  \return block identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+
+int shmemCreatePlaced (int key, unsigned int size, unsigned int placement)
+{
+  int b;
+  void *add;                                                                        /* address of the new block */
+  unsigned long align = (placement & SHMHUGEPAGES) ? HUGEPAGESIZE : BLOCKALIGN;          /* alignment of the block */
+  unsigned long bytes = (size + align - 1) & ~(align - 1);                                   /* size of the block */
+
+  pthread_mutex_lock (&blocksLock);
+  if (findBlock (key) != -1) {
+     pthread_mutex_unlock (&blocksLock);
+     errno = EEXIST;
+     return -1;
+  }
+  for (b = 0; (b < MAXBLOCKS) && (blocks[b].add != NULL); b++)
+    ;
+  if ((b == MAXBLOCKS) || (posix_memalign (&add, align, bytes) != 0)) {
+     pthread_mutex_unlock (&blocksLock);
+     errno = ENOMEM;
+     return -1;
+  }
+  if (placement & SHMHUGEPAGES)
+     madvise (add, bytes, MADV_HUGEPAGE);                       /* a hint: the block is used in any case */
+  blocks[b].add = memset (add, 0, bytes);
+  blocks[b].size = bytes;
+  blocks[b].key = key;
+  pthread_mutex_unlock (&blocksLock);
+  return b;
+}
+
+/**
+ *  \brief Connection to a previously created block.
+ *
+ *  The function fails if there is no block with a creation key equal to <tt>key</tt>.
+ *
+ *  \param key creation key
+ *
+ *  \return block identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemConnect (int key)
+{
+  int b;
+
+  pthread_mutex_lock (&blocksLock);
+  b = findBlock (key);
+  pthread_mutex_unlock (&blocksLock);
+  if (b == -1)
+     errno = ENOENT;
+  return b;
+}
+
+/**
+ *  \brief Destruction of a previously created block.
+ *
+ *  The function fails if there is no block with an identifier equal to <tt>shmid</tt>.
+ *
+ *  \param shmid block identifier
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemDestroy (int shmid)
+{
+  pthread_mutex_lock (&blocksLock);
+  if ((shmid < 0) || (shmid >= MAXBLOCKS) || (blocks[shmid].add == NULL)) {
+     pthread_mutex_unlock (&blocksLock);
+     errno = EINVAL;
+     return -1;
+  }
+  free (blocks[shmid].add);
+  blocks[shmid].add = NULL;
+  pthread_mutex_unlock (&blocksLock);
+  return 0;
+}
+
+/**
+ *  \brief Mapping of the block previously created on the process address space.
+ *
+ *  The function fails if there is no block with an identifier equal to <tt>shmid</tt>.
+ *
+ *  \param shmid block identifier
+ *  \param pAttAdd pointer to the location where the local address of the attached block is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemAttach (int shmid, void **pAttAdd)
+{
+  void *add;                                                                                    /* temporary pointer */
+
+  pthread_mutex_lock (&blocksLock);
+  add = ((shmid >= 0) && (shmid < MAXBLOCKS)) ? blocks[shmid].add : NULL;
+  pthread_mutex_unlock (&blocksLock);
+  if (add == NULL) {
+     errno = EINVAL;
+     return -1;
+  }
+  *pAttAdd = add;
+  return 0;
+}
+
+/**
+ *  \brief Unmapping of the block off the process address space.
+ *
+ *  The block remains in the process heap until it is destroyed.
+ *
+ *  \param attAdd local address of the attached block
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemDettach (void *attAdd)
+{
+  return 0;
+}
+
+/**
+ *  \brief Placement of a block mapped on the process address space.
+ *
+ *  The NUMA memory policy of the block is set (SHMINTERLEAVE or SHMBIND), before its pages are touched, and its
+ *  pages are faulted in (SHMPREFAULT), so that no page fault of the block takes place afterwards in this process.
+ *
+ *  \param shmid block identifier
+ *  \param attAdd local address of the attached block
+ *  \param placement combination of SHMPREFAULT, SHMINTERLEAVE and SHMBIND
+ *  \param node NUMA node the pages are bound to (SHMBIND)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+
+int shmemPlace (int shmid, void *attAdd, unsigned int placement, int node)
+{
+  unsigned long size;
+
+  pthread_mutex_lock (&blocksLock);
+  size = ((shmid >= 0) && (shmid < MAXBLOCKS) && (blocks[shmid].add == attAdd)) ? blocks[shmid].size : 0;
+  pthread_mutex_unlock (&blocksLock);
+  if (size == 0) {
+     errno = EINVAL;
+     return -1;
+  }
+  return placeRange (attAdd, size, placement, node);
+}
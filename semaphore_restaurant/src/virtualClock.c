@@ -0,0 +1,282 @@
+/**
+ *  \file virtualClock.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Virtual clock.
+ *
+ *  Operations defined on the virtual clock:
+ *     \li size of the timer queue and wait descriptors
+ *     \li initialization
+ *     \li joining the clock and leaving it
+ *     \li sleeping for a given time
+ *     \li advancing the simulated time
+ *     \li reading the current time.
+ *
+ *  The clock advancer waits for the semaphore counting the members that are not blocked to be zero. A member that
+ *  has just left the semaphore may not be blocked yet, but its operations are in its wait descriptor: every member
+ *  is blocked when none of the stored operations may take place, while no member blocks or terminates.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "semaphore.h"
+#include "virtualClock.h"
+
+/** \brief timer queue of the clock */
+#define  TIMERS(clk)     ((CLOCK_TIMER *) ((char *) (clk) + (clk)->timersOff))
+
+/** \brief wait descriptors of the members of the clock */
+#define  WAITS(clk)      ((SEM_WAIT *) ((char *) (clk) + (clk)->waitsOff))
+
+/** \brief member of the clock of the calling thread */
+static __thread int member = -1;
+
+/* internal functions */
+
+static void lockClock (VCLOCK *clk)
+{
+    while (__atomic_exchange_n (&clk->lock, 1, __ATOMIC_ACQUIRE) != 0) {
+        sched_yield ();
+    }
+}
+
+static void unlockClock (VCLOCK *clk)
+{
+    __atomic_store_n (&clk->lock, 0, __ATOMIC_RELEASE);
+}
+
+static int earlier (CLOCK_TIMER *a, CLOCK_TIMER *b)
+{
+    return (a->wake < b->wake) || ((a->wake == b->wake) && ((int) (a->seq - b->seq) < 0));
+}
+
+static void pushTimer (VCLOCK *clk, CLOCK_TIMER tm)
+{
+    CLOCK_TIMER *heap = TIMERS (clk);
+    unsigned int n = clk->nTimers++;
+
+    while ((n > 0) && earlier (&tm, &heap[(n - 1) / 2])) {                                         /* sift up */
+        heap[n] = heap[(n - 1) / 2];
+        n = (n - 1) / 2;
+    }
+    heap[n] = tm;
+}
+
+static CLOCK_TIMER popTimer (VCLOCK *clk)
+{
+    CLOCK_TIMER *heap = TIMERS (clk);
+    CLOCK_TIMER top = heap[0],
+                last = heap[--clk->nTimers];
+    unsigned int n = 0, c;
+
+    while ((c = 2 * n + 1) < clk->nTimers) {                                                     /* sift down */
+        if ((c + 1 < clk->nTimers) && earlier (&heap[c + 1], &heap[c])) {
+            c++;
+        }
+        if (!earlier (&heap[c], &last)) {
+            break;
+        }
+        heap[n] = heap[c];
+        n = c;
+    }
+    heap[n] = last;
+    return top;
+}
+
+/* external functions */
+
+/**
+ *  \brief Size of the timer queue and wait descriptors of the clock.
+ *
+ *  \param members number of members (entities)
+ *
+ *  \return number of bytes required by the timer queue and the wait descriptors
+ */
+unsigned long clockBytes (unsigned int members)
+{
+    return members * (sizeof (CLOCK_TIMER) + sizeof (SEM_WAIT));
+}
+
+/**
+ *  \brief Clock initialization.
+ *
+ *  The semaphore <tt>running</tt> must be set to the number of members before they start.
+ *
+ *  \param clk pointer to the clock
+ *  \param space pointer to the space reserved for the timer queue and wait descriptors (in shared memory)
+ *  \param members number of members (entities)
+ *  \param running identification of semaphore counting the members that are not blocked
+ *  \param wakeUp identification of the wake-up semaphore of the first member
+ */
+void initClock (VCLOCK *clk, void *space, unsigned int members, unsigned int running, unsigned int wakeUp)
+{
+    unsigned int m;
+
+    clk->enabled = 1;
+    clk->now = 0;
+    clk->running = running;
+    clk->wakeUp = wakeUp;
+    clk->members = members;
+    clk->staff = 0;
+    clk->live = members;
+    clk->blockings = 0;
+    clk->lock = 0;
+    clk->nTimers = 0;
+    clk->seq = 0;
+    clk->timersOff = (char *) space - (char *) clk;
+    clk->waitsOff = clk->timersOff + members * sizeof (CLOCK_TIMER);
+    for (m = 0; m < members; m++) {
+        WAITS (clk)[m].nops = 0;
+    }
+}
+
+/**
+ *  \brief Joining the clock: the blocking operations of the calling thread are tracked from now on.
+ *
+ *  Groups are the first members; the other entities get the last ones.
+ *
+ *  \param semgid semaphore set access identifier
+ *  \param clk pointer to the clock
+ *  \param id group id (-1 for the other entities)
+ */
+void joinClock (int semgid, VCLOCK *clk, int id)
+{
+    if (!clk->enabled) {
+        return;
+    }
+    member = (id >= 0) ? id : (int) (clk->members - 1 - __atomic_fetch_add (&clk->staff, 1, __ATOMIC_RELAXED));
+    if (semTrackBlocking (semgid, clk->running, &WAITS (clk)[member], &clk->blockings) == -1) {
+        perror ("error on tracking the blocking operations");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief Leaving the clock: the entity of the calling thread terminates.
+ *
+ *  \param semgid semaphore set access identifier
+ *  \param clk pointer to the clock
+ */
+void leaveClock (int semgid, VCLOCK *clk)
+{
+    if (!clk->enabled) {
+        return;
+    }
+    semTrackBlocking (semgid, 0, NULL, NULL);
+    WAITS (clk)[member].nops = 0;
+    member = -1;
+    __atomic_sub_fetch (&clk->live, 1, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch (&clk->blockings, 1, __ATOMIC_SEQ_CST);
+    if (semDown (semgid, clk->running) == -1) {                          /* never blocks: the member was running */
+        perror ("error on the down operation for the running semaphore");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief Sleeping for a given time.
+ *
+ *  With the virtual clock, a wake-up is scheduled for the current simulated time plus <tt>usec</tt> and the entity
+ *  blocks on its wake-up semaphore.
+ *
+ *  \param semgid semaphore set access identifier
+ *  \param clk pointer to the clock
+ *  \param usec sleeping time (in microseconds)
+ */
+void clockSleep (int semgid, VCLOCK *clk, unsigned int usec)
+{
+    CLOCK_TIMER tm;
+
+    if (!clk->enabled) {
+        usleep (usec);
+        return;
+    }
+    lockClock (clk);
+    tm.wake = clk->now + usec;
+    tm.seq = clk->seq++;
+    tm.member = member;
+    pushTimer (clk, tm);
+    unlockClock (clk);
+    if (semDown (semgid, clk->wakeUp + member) == -1) {
+        perror ("error on the down operation for the wake-up semaphore");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief Advancing the simulated time, until all members have left the clock.
+ *
+ *  Whenever every member is blocked, the simulated time jumps to the earliest scheduled wake-up and all members
+ *  scheduled for that time are woken up. If there is no scheduled wake-up, the members are deadlocked: the
+ *  situation is reported and the clock stops.
+ *
+ *  \param semgid semaphore set access identifier
+ *  \param clk pointer to the clock
+ */
+void runClock (int semgid, VCLOCK *clk)
+{
+    unsigned int blockings;                                                /* blocking operations before checking */
+    int ready;                                                     /* number of members whose operations may proceed */
+    CLOCK_TIMER tm;
+
+    for (;;) {
+        if (semWaitZero (semgid, clk->running) == -1) {                          /* wait until no member is running */
+            perror ("error on waiting for the running semaphore");
+            exit (EXIT_FAILURE);
+        }
+        if (__atomic_load_n (&clk->live, __ATOMIC_SEQ_CST) == 0) {
+            break;
+        }
+        blockings = __atomic_load_n (&clk->blockings, __ATOMIC_SEQ_CST);
+        if ((ready = semUnblockable (semgid, WAITS (clk), clk->members)) == -1) {
+            perror ("error on checking the blocked members");
+            exit (EXIT_FAILURE);
+        }
+        if ((ready != 0) || (blockings != __atomic_load_n (&clk->blockings, __ATOMIC_SEQ_CST)) ||
+            (semValue (semgid, clk->running) != 0)) {                                /* not every member blocked */
+            sched_yield ();
+            continue;
+        }
+
+        lockClock (clk);
+        if (clk->nTimers == 0) {
+            unlockClock (clk);
+            fprintf (stderr, "virtual clock: every entity is blocked and no wake-up is scheduled\n");
+            return;
+        }
+        clk->now = TIMERS (clk)[0].wake;
+        while ((clk->nTimers > 0) && (TIMERS (clk)[0].wake == clk->now)) {
+            tm = popTimer (clk);
+            if (semUp (semgid, clk->wakeUp + tm.member) == -1) {
+                perror ("error on the up operation for the wake-up semaphore");
+                exit (EXIT_FAILURE);
+            }
+        }
+        unlockClock (clk);
+    }
+}
+
+/**
+ *  \brief Current time: the simulated time, when the clock is enabled, or the time of the monotonic clock.
+ *
+ *  \param clk pointer to the clock
+ *
+ *  \return current time (in nanoseconds)
+ */
+unsigned long clockNow (VCLOCK *clk)
+{
+    struct timespec ts;
+
+    if (clk->enabled) {
+        return __atomic_load_n (&clk->now, __ATOMIC_SEQ_CST) * 1000UL;
+    }
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
@@ -0,0 +1,95 @@
+/**
+ *  \file virtualClock.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Virtual clock.
+ *
+ *  Operations defined on the virtual clock:
+ *     \li size of the timer queue and wait descriptors
+ *     \li initialization
+ *     \li joining the clock and leaving it
+ *     \li sleeping for a given time
+ *     \li advancing the simulated time
+ *     \li reading the current time.
+ *
+ *  When the virtual clock is enabled, sleeping entities schedule a wake-up and block, instead of sleeping for real
+ *  time. The clock advancer waits until every entity is blocked: then no entity may proceed before the simulated
+ *  time advances, so it jumps to the earliest scheduled wake-up and the entities scheduled for that time are woken
+ *  up. Entities are counted as not blocked by the semaphore <tt>running</tt>, which is decremented before a
+ *  <em>down</em> blocks and incremented by the same operation that unblocks it (System V backend only).
+ *
+ *  When it is disabled, sleeping is real time sleeping and the other operations have no effect.
+ */
+
+#ifndef VIRTUALCLOCK_H_
+#define VIRTUALCLOCK_H_
+
+#include "probDataStruct.h"
+
+/**
+ *  \brief Size of the timer queue and wait descriptors of the clock.
+ *
+ *  \param members number of members (entities)
+ *
+ *  \return number of bytes required by the timer queue and the wait descriptors
+ */
+extern unsigned long clockBytes (unsigned int members);
+
+/**
+ *  \brief Clock initialization.
+ *
+ *  The semaphore <tt>running</tt> must be set to the number of members before they start.
+ *
+ *  \param clk pointer to the clock
+ *  \param space pointer to the space reserved for the timer queue and wait descriptors (in shared memory)
+ *  \param members number of members (entities)
+ *  \param running identification of semaphore counting the members that are not blocked
+ *  \param wakeUp identification of the wake-up semaphore of the first member
+ */
+extern void initClock (VCLOCK *clk, void *space, unsigned int members, unsigned int running, unsigned int wakeUp);
+
+/**
+ *  \brief Joining the clock: the blocking operations of the calling thread are tracked from now on.
+ *
+ *  \param semgid semaphore set access identifier
+ *  \param clk pointer to the clock
+ *  \param id group id (-1 for the other entities)
+ */
+extern void joinClock (int semgid, VCLOCK *clk, int id);
+
+/**
+ *  \brief Leaving the clock: the entity of the calling thread terminates.
+ *
+ *  \param semgid semaphore set access identifier
+ *  \param clk pointer to the clock
+ */
+extern void leaveClock (int semgid, VCLOCK *clk);
+
+/**
+ *  \brief Sleeping for a given time.
+ *
+ *  \param semgid semaphore set access identifier
+ *  \param clk pointer to the clock
+ *  \param usec sleeping time (in microseconds)
+ */
+extern void clockSleep (int semgid, VCLOCK *clk, unsigned int usec);
+
+/**
+ *  \brief Advancing the simulated time, until all members have left the clock.
+ *
+ *  \param semgid semaphore set access identifier
+ *  \param clk pointer to the clock
+ */
+extern void runClock (int semgid, VCLOCK *clk);
+
+/**
+ *  \brief Current time: the simulated time, when the clock is enabled, or the time of the monotonic clock.
+ *
+ *  \param clk pointer to the clock
+ *
+ *  \return current time (in nanoseconds)
+ */
+extern unsigned long clockNow (VCLOCK *clk);
+
+#endif /* VIRTUALCLOCK_H_ */